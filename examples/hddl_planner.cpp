@@ -0,0 +1,44 @@
+#include "hddl_parser.h"
+#include "tfd.h"
+#include <chrono>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <domain.hddl> <problem.hddl>" << std::endl;
+        return 1;
+    }
+
+    const auto parseStart = std::chrono::steady_clock::now();
+    const auto model = tfd_cpp::LoadHddlFiles(argv[1], argv[2]);
+    if (not model)
+    {
+        std::cout << "Failed to load HDDL domain and problem." << std::endl;
+        return 1;
+    }
+    const auto parseEnd = std::chrono::steady_clock::now();
+
+    tfd_cpp::TFD tfd(tfd_cpp::CreatePlanningProblem(model));
+    tfd_cpp::TFD::Plan solutionPlan = tfd.TryToPlan();
+    const auto planEnd = std::chrono::steady_clock::now();
+
+    std::cout << "Parsing took " << std::chrono::duration<double, std::milli>(parseEnd - parseStart).count() << " ms, "
+              << "planning took " << std::chrono::duration<double, std::milli>(planEnd - parseEnd).count() << " ms." << std::endl;
+
+    if (not solutionPlan.empty())
+    {
+        std::cout << "TFD found solution plan with " << solutionPlan.size() << " steps." << std::endl;
+        for (const auto& _operator : solutionPlan)
+        {
+            std::cout << model->ToString(_operator.task) << std::endl;
+        }
+    }
+    else
+    {
+        std::cout << "TFD failed to plan for " << model->problemName << "." << std::endl;
+    }
+
+    return 0;
+}
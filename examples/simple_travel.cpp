@@ -6,20 +6,24 @@ int main()
 {
     std::cout << "Total-forward Decomposition Algorithm Demo: Simple Travel Problem" << std::endl;
     
+    const auto roadMap = simple_travel::CityRoadMap();
+
     tfd_cpp::Task task;
     task.taskName = TRAVEL;
     task.parameters.push_back(simple_travel::SimpleTravelState::Object("me"));
     task.parameters.push_back(simple_travel::SimpleTravelState::Object("taxi"));
-    task.parameters.push_back(simple_travel::SimpleTravelState::Location("home"));
-    task.parameters.push_back(simple_travel::SimpleTravelState::Location("park"));
+    task.parameters.push_back(roadMap->IdOf("home").value());
+    task.parameters.push_back(roadMap->IdOf("station").value());
     
     tfd_cpp::TFD tfd(simple_travel::CreatePlanningProblem(task));
-    tfd_cpp::TFD::Plan solutionPlan = tfd.TryToPlan();
+    tfd_cpp::SearchOptions options;
+    options.optimize = true;
+    tfd_cpp::SearchResult result = tfd.Search(options);
 
-    if (not solutionPlan.empty())
+    if (not result.plan.empty())
     {
-        std::cout << "TFD found solution plan for Simple Travel Problem." << std::endl;
-        for (const auto& _operator : solutionPlan)
+        std::cout << "TFD found solution plan for Simple Travel Problem with cost " << result.cost << "." << std::endl;
+        for (const auto& _operator : result.plan)
         {
             std::cout <<  _operator.task.taskName << std::endl;
         }
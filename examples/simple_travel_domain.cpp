@@ -1,18 +1,166 @@
 #include "simple_travel_domain.h"
 #include <cassert>
+#include <functional>
+#include <queue>
 #include <sstream>
 
 namespace simple_travel
 {
+    RoadMap::RoadMap(const std::vector<Location>& locations, const std::vector<Road>& roads) :
+        m_names(locations),
+        m_roadLength(locations.size() * locations.size(), UNREACHABLE),
+        m_shortestDistance(locations.size() * locations.size(), UNREACHABLE),
+        m_nextHop(locations.size() * locations.size(), 0)
+    {
+        for (LocationId location = 0; location < m_names.size(); ++location)
+        {
+            m_ids.emplace(m_names[location], location);
+        }
+
+        std::vector<std::vector<LocationId>> neighbours(m_names.size());
+        for (const auto& road : roads)
+        {
+            const auto from = IdOf(road.from);
+            const auto to = IdOf(road.to);
+            if (not from or not to or road.length == 0 or from.value() == to.value())
+            {
+                continue;
+            }
+
+            auto& forward = m_roadLength[Index(from.value(), to.value())];
+            if (forward == UNREACHABLE)
+            {
+                neighbours[from.value()].push_back(to.value());
+                neighbours[to.value()].push_back(from.value());
+            }
+            forward = std::min(forward, road.length);
+            m_roadLength[Index(to.value(), from.value())] = forward;
+        }
+
+        // Roads are sparse, so a Dijkstra search per source beats Floyd-Warshall's n^3.
+        using Entry = std::pair<std::uint64_t, LocationId>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> frontier;
+        for (LocationId source = 0; source < m_names.size(); ++source)
+        {
+            m_shortestDistance[Index(source, source)] = 0;
+            m_nextHop[Index(source, source)] = source;
+            frontier.emplace(0, source);
+
+            while (not frontier.empty())
+            {
+                const auto [distance, location] = frontier.top();
+                frontier.pop();
+                if (distance > m_shortestDistance[Index(source, location)])
+                {
+                    continue;
+                }
+
+                for (const auto neighbour : neighbours[location])
+                {
+                    const std::uint64_t candidate = distance + m_roadLength[Index(location, neighbour)];
+                    auto& shortest = m_shortestDistance[Index(source, neighbour)];
+                    if (candidate < shortest)
+                    {
+                        shortest = static_cast<Distance>(std::min<std::uint64_t>(candidate, UNREACHABLE - 1));
+                        m_nextHop[Index(source, neighbour)] = location == source ? neighbour : m_nextHop[Index(source, location)];
+                        frontier.emplace(shortest, neighbour);
+                    }
+                }
+            }
+        }
+    }
+
+    RoadMap::~RoadMap()
+    {
+    }
+
+    std::size_t RoadMap::Size() const
+    {
+        return m_names.size();
+    }
+
+    std::optional<RoadMap::LocationId> RoadMap::IdOf(const Location& location) const
+    {
+        auto id = m_ids.find(location);
+        if (id == m_ids.end())
+        {
+            return std::nullopt;
+        }
+        return id->second;
+    }
+
+    const RoadMap::Location& RoadMap::NameOf(LocationId location) const
+    {
+        return m_names.at(location);
+    }
+
+    std::optional<RoadMap::Distance> RoadMap::RoadLength(LocationId from, LocationId to) const
+    {
+        if (from >= Size() or to >= Size() or m_roadLength[Index(from, to)] == UNREACHABLE)
+        {
+            return std::nullopt;
+        }
+        return m_roadLength[Index(from, to)];
+    }
+
+    std::optional<RoadMap::Distance> RoadMap::ShortestDistance(LocationId from, LocationId to) const
+    {
+        if (from >= Size() or to >= Size() or m_shortestDistance[Index(from, to)] == UNREACHABLE)
+        {
+            return std::nullopt;
+        }
+        return m_shortestDistance[Index(from, to)];
+    }
+
+    std::optional<RoadMap::LocationId> RoadMap::NextHop(LocationId from, LocationId to) const
+    {
+        if (not ShortestDistance(from, to))
+        {
+            return std::nullopt;
+        }
+        return m_nextHop[Index(from, to)];
+    }
+
+    std::size_t RoadMap::Index(LocationId from, LocationId to) const
+    {
+        return static_cast<std::size_t>(from) * m_names.size() + to;
+    }
+
+    // The road map never changes, so only the per-person tables contribute to the hash.
+    static tfd_cpp::ZobristHash LocationKey(const SimpleTravelState::Object& person, const SimpleTravelState::Location& location)
+    {
+        return tfd_cpp::ZobristCombine(tfd_cpp::ZobristCombine(tfd_cpp::ZobristKey("location"), tfd_cpp::ZobristKey(person)),
+                                       tfd_cpp::ZobristKey(static_cast<std::uint64_t>(location)));
+    }
+
+    static tfd_cpp::ZobristHash CashKey(const std::string& table, const SimpleTravelState::Object& person, const SimpleTravelState::Cash& cash)
+    {
+        return tfd_cpp::ZobristCombine(tfd_cpp::ZobristCombine(tfd_cpp::ZobristKey(table), tfd_cpp::ZobristKey(person)),
+                                       tfd_cpp::ZobristKey(static_cast<std::uint64_t>(cash)));
+    }
+
     SimpleTravelState::SimpleTravelState(const PersonLocationTable& personLocationTable,
                                          const PersonCashTable& personCashTable,
                                          const PersonOweTable& personOweTable,
-                                         const DistanceTable& distanceTable) : 
+                                         std::shared_ptr<const RoadMap> roadMap) : 
         m_personLocationTable(personLocationTable),
         m_personCashTable(personCashTable),
         m_personOweTable(personOweTable),
-        m_distanceTable(distanceTable)
+        m_roadMap(std::move(roadMap)),
+        m_hash(0)
     {
+        for (const auto& element : m_personLocationTable)
+        {
+            m_hash ^= LocationKey(element.first, element.second);
+        }
+        for (const auto& element : m_personCashTable)
+        {
+            m_hash ^= CashKey("cash", element.first, element.second);
+        }
+        for (const auto& element : m_personOweTable)
+        {
+            m_hash ^= CashKey("owe", element.first, element.second);
+        }
     }
 
     SimpleTravelState::~SimpleTravelState()
@@ -33,9 +181,11 @@ namespace simple_travel
 
     void SimpleTravelState::SetLocationOf(const Object& person, const Location& location)
     {
-        if (m_personLocationTable.find(person) != m_personLocationTable.end())
+        auto element = m_personLocationTable.find(person);
+        if (element != m_personLocationTable.end())
         {
-            m_personLocationTable[person] = location;
+            m_hash ^= LocationKey(person, element->second) ^ LocationKey(person, location);
+            element->second = location;
         }
     }
 
@@ -53,9 +203,11 @@ namespace simple_travel
 
     void SimpleTravelState::SetCashOwnedBy(const Object& person, const Cash& cash)
     {
-        if (m_personCashTable.find(person) != m_personCashTable.end())
+        auto element = m_personCashTable.find(person);
+        if (element != m_personCashTable.end())
         {
-            m_personCashTable[person] = cash;
+            m_hash ^= CashKey("cash", person, element->second) ^ CashKey("cash", person, cash);
+            element->second = cash;
         }
     }
 
@@ -73,281 +225,445 @@ namespace simple_travel
 
     void SimpleTravelState::SetOwe(const Object& person, const Cash& cash)
     {
-        if (m_personOweTable.find(person) != m_personOweTable.end())
+        auto element = m_personOweTable.find(person);
+        if (element != m_personOweTable.end())
         {
-            m_personOweTable[person] = cash;
+            m_hash ^= CashKey("owe", person, element->second) ^ CashKey("owe", person, cash);
+            element->second = cash;
         }
     }
     
     std::optional<SimpleTravelState::Distance> SimpleTravelState::DistanceBetween(const Location& location1, const Location& location2) const
     {
-        if (m_distanceTable.find(location1) == m_distanceTable.end())
+        return m_roadMap->RoadLength(location1, location2);
+    }
+
+    const RoadMap& SimpleTravelState::Roads() const
+    {
+        return *m_roadMap;
+    }
+
+    SimpleTravelState::Cash SimpleTravelState::TaxiRate(const Distance& distance) const
+    {
+        return (1.5 + 0.5 * distance);
+    }
+
+    tfd_cpp::ZobristHash SimpleTravelState::Hash() const
+    {
+        return m_hash;
+    }
+
+    // Operators
+    std::optional<tfd_cpp::State> Walk(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                       const SimpleTravelState::Location& src, const SimpleTravelState::Location& dst)
+    {
+        assert(state.domainName == DOMAIN_NAME);
+
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        if (not simpleTravelState)
         {
             return std::nullopt;
         }
-        else
+
+        auto currentLocation = simpleTravelState->LocationOf(person);
+        if (currentLocation && currentLocation.value() == src)
         {
-            const auto& destination_table = m_distanceTable.at(location1);
-            if (destination_table.find(location2) == destination_table.end())
-            {
-                return std::nullopt;
-            }
-            else
-            {
-                return destination_table.at(location2);
-            }
+            tfd_cpp::State newState(state);
+            std::any_cast<SimpleTravelState>(&newState.data)->SetLocationOf(person, dst);
+
+            return newState;
         }
+
+        return std::nullopt;
     }
 
-    SimpleTravelState::Cash SimpleTravelState::TaxiRate(const Distance& distance) const
+    std::optional<tfd_cpp::State> CallTaxi(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                           const SimpleTravelState::Object& taxi)
     {
-        return (1.5 + 0.5 * distance);
+        assert(state.domainName == DOMAIN_NAME);
+
+        tfd_cpp::State newState(state);
+        auto* simpleTravelState = std::any_cast<SimpleTravelState>(&newState.data);
+        if (not simpleTravelState)
+        {
+            return std::nullopt;
+        }
+
+        auto personLocation = simpleTravelState->LocationOf(person);
+        if (personLocation)
+        {
+            simpleTravelState->SetLocationOf(taxi, personLocation.value());
+        }
+
+        return newState;
     }
 
-    // Operators
-    std::optional<tfd_cpp::State> Walk(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    std::optional<tfd_cpp::State> RideTaxi(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                           const SimpleTravelState::Object& taxi, const SimpleTravelState::Location& src,
+                                           const SimpleTravelState::Location& dst)
     {
-        assert(parameters.size() == 3);
         assert(state.domainName == DOMAIN_NAME);
 
-        try 
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        if (not simpleTravelState)
         {
-            const auto& person = std::any_cast<SimpleTravelState::Object>(parameters[0]);
-            const auto& src = std::any_cast<SimpleTravelState::Location>(parameters[1]);
-            const auto& dst = std::any_cast<SimpleTravelState::Location>(parameters[2]);
-            auto simpleTravelState = std::any_cast<SimpleTravelState>(state.data);
+            return std::nullopt;
+        }
+
+        auto currentPersonLocation = simpleTravelState->LocationOf(person);
+        auto currentTaxiLocation = simpleTravelState->LocationOf(taxi);
 
-            auto currentLocation = simpleTravelState.LocationOf(person); 
-            if (currentLocation && currentLocation.value() == src)
+        if (currentPersonLocation and currentTaxiLocation)
+        {
+            if ((currentPersonLocation.value() == src) and (currentTaxiLocation.value() == src))
             {
                 tfd_cpp::State newState(state);
-                simpleTravelState.SetLocationOf(person, dst);
-                newState.data = simpleTravelState;
-                
+                auto distance = simpleTravelState->DistanceBetween(src, dst);
+
+                if (distance)
+                {
+                    auto* newTravelState = std::any_cast<SimpleTravelState>(&newState.data);
+                    newTravelState->SetLocationOf(person, dst);
+                    newTravelState->SetLocationOf(taxi, dst);
+                    newTravelState->SetOwe(person, newTravelState->TaxiRate(distance.value()));
+                }
+
                 return newState;
             }
         }
-        catch(const std::bad_any_cast& e) 
-        {
-            std::cerr << e.what() << " in " << __PRETTY_FUNCTION__ << '\n';
-        }
 
         return std::nullopt;
     }
 
-    std::optional<tfd_cpp::State> CallTaxi(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    std::optional<tfd_cpp::State> PayDriver(const tfd_cpp::State& state, const SimpleTravelState::Object& person)
     {
-        assert(parameters.size() == 2);
         assert(state.domainName == DOMAIN_NAME);
 
-        try
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        if (not simpleTravelState)
         {
-            tfd_cpp::State newState(state);
-            auto simpleTravelState = std::any_cast<SimpleTravelState>(newState.data);
-            const auto& person = std::any_cast<SimpleTravelState::Object>(parameters[0]);
-            const auto& taxi = std::any_cast<SimpleTravelState::Object>(parameters[1]);
+            return std::nullopt;
+        }
 
-            auto personLocation = simpleTravelState.LocationOf(person);
-            if (personLocation)
+        auto cashOwned = simpleTravelState->CashOwnedBy(person);
+        auto owe = simpleTravelState->Owe(person);
+
+        if (cashOwned and owe)
+        {
+            if (cashOwned.value() >= owe.value())
             {
-                simpleTravelState.SetLocationOf(taxi, personLocation.value());
+                tfd_cpp::State newState(state);
+                auto* newTravelState = std::any_cast<SimpleTravelState>(&newState.data);
+                newTravelState->SetCashOwnedBy(person, cashOwned.value() - owe.value());
+                newTravelState->SetOwe(person, 0);
+
+                return newState;
             }
-            newState.data = simpleTravelState;
-            
-            return newState;
         }
-        catch(const std::exception& e)
+
+        return std::nullopt;
+    }
+
+    // Methods
+    std::optional<std::vector<tfd_cpp::Task>> TravelByFoot(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                                           const SimpleTravelState::Object&, const SimpleTravelState::Location& src,
+                                                           const SimpleTravelState::Location& dst)
+    {
+        assert(state.domainName == DOMAIN_NAME);
+
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        if (not simpleTravelState)
         {
-            std::cerr << e.what() << " in " << __PRETTY_FUNCTION__ << '\n';
+            return std::nullopt;
+        }
+
+        auto distance = simpleTravelState->DistanceBetween(src, dst);
+        if (distance && distance.value() <= WALKING_DISTANCE && simpleTravelState->Roads().NextHop(src, dst) == dst)
+        {
+            tfd_cpp::Task task;
+            task.taskName = WALK;
+            task.parameters.push_back(person);
+            task.parameters.push_back(src);
+            task.parameters.push_back(dst);
+            std::vector<tfd_cpp::Task> subtasks{task};
+
+            return subtasks;
         }
 
         return std::nullopt;
     }
 
-    std::optional<tfd_cpp::State> RideTaxi(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    std::optional<std::vector<tfd_cpp::Task>> TravelByTaxi(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                                           const SimpleTravelState::Object& taxi, const SimpleTravelState::Location& src,
+                                                           const SimpleTravelState::Location& dst)
     {
-        assert(parameters.size() == 4);
         assert(state.domainName == DOMAIN_NAME);
 
-        try
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        if (not simpleTravelState)
         {
-            const auto& person = std::any_cast<SimpleTravelState::Object>(parameters[0]);
-            const auto& taxi = std::any_cast<SimpleTravelState::Object>(parameters[1]);
-            const auto& src = std::any_cast<SimpleTravelState::Location>(parameters[2]);
-            const auto& dst = std::any_cast<SimpleTravelState::Location>(parameters[3]);
-            auto simpleTravelState = std::any_cast<SimpleTravelState>(state.data);
-
-            auto currentPersonLocation = simpleTravelState.LocationOf(person);
-            auto currentTaxiLocation = simpleTravelState.LocationOf(taxi);
+            return std::nullopt;
+        }
 
-            if (currentPersonLocation and currentTaxiLocation)
+        auto cash = simpleTravelState->CashOwnedBy(person);
+        auto distance = simpleTravelState->DistanceBetween(src, dst);
+        auto currentPersonLocation = simpleTravelState->LocationOf(person);
+        if (cash and distance and currentPersonLocation and simpleTravelState->Roads().NextHop(src, dst) == dst)
+        {
+            if (currentPersonLocation.value() == src)
             {
-                if ((currentPersonLocation.value() == src) and (currentTaxiLocation.value() == src))
+                if (cash.value() >= simpleTravelState->TaxiRate(distance.value()))
                 {
-                    tfd_cpp::State newState(state);
-                    auto distance = simpleTravelState.DistanceBetween(src, dst);
-                    
-                    if (distance)
-                    {
-                        simpleTravelState.SetLocationOf(person, dst);
-                        simpleTravelState.SetLocationOf(taxi, dst);
-                        simpleTravelState.SetOwe(person, simpleTravelState.TaxiRate(distance.value()));
-                        newState.data = simpleTravelState;
-                    }
+                    tfd_cpp::Task callTaxi;
+                    callTaxi.taskName = CALL_TAXI;
+                    callTaxi.parameters.push_back(person);
+                    callTaxi.parameters.push_back(taxi);
 
-                    return newState;
+                    tfd_cpp::Task rideTaxi;
+                    rideTaxi.taskName = RIDE_TAXI;
+                    rideTaxi.parameters.push_back(person);
+                    rideTaxi.parameters.push_back(taxi);
+                    rideTaxi.parameters.push_back(src);
+                    rideTaxi.parameters.push_back(dst);
+
+                    tfd_cpp::Task payDriver;
+                    payDriver.taskName = PAY_DRIVER;
+                    payDriver.parameters.push_back(person);
+
+                    std::vector<tfd_cpp::Task> subtasks{payDriver, rideTaxi, callTaxi};
+
+                    return subtasks;
                 }
             }
         }
-        catch(const std::exception& e)
-        {
-            std::cerr << e.what() << " in " << __PRETTY_FUNCTION__ << '\n';
-        }
 
         return std::nullopt;
     }
 
-    std::optional<tfd_cpp::State> PayDriver(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    std::optional<std::vector<tfd_cpp::Task>> TravelByLegs(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                                           const SimpleTravelState::Object& taxi, const SimpleTravelState::Location& src,
+                                                           const SimpleTravelState::Location& dst)
     {
-        assert(parameters.size() == 1);
         assert(state.domainName == DOMAIN_NAME);
 
-        try
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        if (not simpleTravelState)
+        {
+            return std::nullopt;
+        }
+
+        // following the precomputed next hop means there is nothing to search over
+        auto hop = simpleTravelState->Roads().NextHop(src, dst);
+        if (not hop or hop.value() == dst or hop.value() == src)
         {
-            const auto& person = std::any_cast<SimpleTravelState::Object>(parameters[0]);
-            auto simpleTravelState = std::any_cast<SimpleTravelState>(state.data);
+            return std::nullopt;
+        }
 
-            auto cashOwned = simpleTravelState.CashOwnedBy(person);
-            auto owe = simpleTravelState.Owe(person);
+        tfd_cpp::Task firstLeg{TRAVEL, {person, taxi, src, hop.value()}};
+        tfd_cpp::Task remainingLegs{TRAVEL, {person, taxi, hop.value(), dst}};
+        std::vector<tfd_cpp::Task> subtasks{remainingLegs, firstLeg};
 
-            if (cashOwned and owe)
-            {
-                if (cashOwned.value() >= owe.value())
-                {
-                    tfd_cpp::State newState(state);
-                    
-                    simpleTravelState.SetCashOwnedBy(person, cashOwned.value() - owe.value());
-                    simpleTravelState.SetOwe(person, 0);
-                    newState.data = state;
+        return subtasks;
+    }
 
-                    return newState;
-                }
-            }
+    // Cheapest way to make the trip the methods allow: every road of the route is walked if it is
+    // short enough and taken by taxi otherwise. Follows the same next hops as TravelByLegs.
+    static double MinimumTravelCost(const SimpleTravelState& state, SimpleTravelState::Location src, SimpleTravelState::Location dst)
+    {
+        if (src == dst)
+        {
+            return 0.0;
+        }
+
+        auto hop = state.Roads().NextHop(src, dst);
+        if (not hop)
+        {
+            return 0.0;
         }
-        catch(const std::exception& e)
+        if (hop.value() != dst)
         {
-            std::cerr << e.what() << " in " << __PRETTY_FUNCTION__ << '\n';
+            return MinimumTravelCost(state, src, hop.value()) + MinimumTravelCost(state, hop.value(), dst);
         }
 
-        return std::nullopt;
+        auto distance = state.DistanceBetween(src, dst);
+        if (distance and distance.value() > WALKING_DISTANCE)
+        {
+            return state.TaxiRate(distance.value());
+        }
+        return 0.0;
     }
 
-    // Methods
-    std::optional<std::vector<tfd_cpp::Task>> TravelByFoot(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    double RideTaxiCost(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
     {
-        assert(parameters.size() == 4);
-        assert(state.domainName == DOMAIN_NAME);
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        const auto* src = std::any_cast<SimpleTravelState::Location>(&parameters[2]);
+        const auto* dst = std::any_cast<SimpleTravelState::Location>(&parameters[3]);
 
-        try
+        if (simpleTravelState and src and dst)
         {
-            const auto& person = std::any_cast<SimpleTravelState::Object>(parameters[0]);
-            const auto& taxi = std::any_cast<SimpleTravelState::Object>(parameters[1]);
-            const auto& src = std::any_cast<SimpleTravelState::Location>(parameters[2]);
-            const auto& dst = std::any_cast<SimpleTravelState::Location>(parameters[3]);
-            auto simpleTravelState = std::any_cast<SimpleTravelState>(state.data);
-
-            auto distance = simpleTravelState.DistanceBetween(src, dst);
-            if (distance && distance.value() <= WALKING_DISTANCE)
+            auto distance = simpleTravelState->DistanceBetween(*src, *dst);
+            if (distance)
             {
-                tfd_cpp::Task task;
-                task.taskName = WALK;
-                task.parameters.push_back(person);
-                task.parameters.push_back(src);
-                task.parameters.push_back(dst);
-                std::vector<tfd_cpp::Task> subtasks{task};
-
-                return subtasks;
+                return simpleTravelState->TaxiRate(distance.value());
             }
         }
-        catch(const std::exception& e)
+
+        return 0.0;
+    }
+
+    double TravelLowerBound(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        const auto* src = std::any_cast<SimpleTravelState::Location>(&parameters[2]);
+        const auto* dst = std::any_cast<SimpleTravelState::Location>(&parameters[3]);
+
+        if (simpleTravelState and src and dst)
         {
-            std::cerr << e.what() << " in " << __PRETTY_FUNCTION__ << '\n';
+            return MinimumTravelCost(*simpleTravelState, *src, *dst);
         }
-        
-        return std::nullopt;
+
+        return 0.0;
     }
 
-    std::optional<std::vector<tfd_cpp::Task>> TravelByTaxi(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    static std::string Field(const std::string& table, const std::any& object)
     {
-        assert(parameters.size() == 4);
-        assert(state.domainName == DOMAIN_NAME);
+        const auto* name = std::any_cast<SimpleTravelState::Object>(&object);
+        return table + ":" + (name ? *name : std::string("?"));
+    }
 
-        try
+    tfd_cpp::Footprint WalkFootprint(const tfd_cpp::State&, const tfd_cpp::Parameters& parameters)
+    {
+        const auto location = Field("location", parameters[0]);
+        return {{location}, {location}};
+    }
+
+    tfd_cpp::Footprint CallTaxiFootprint(const tfd_cpp::State&, const tfd_cpp::Parameters& parameters)
+    {
+        return {{Field("location", parameters[0])}, {Field("location", parameters[1])}};
+    }
+
+    tfd_cpp::Footprint RideTaxiFootprint(const tfd_cpp::State&, const tfd_cpp::Parameters& parameters)
+    {
+        const auto personLocation = Field("location", parameters[0]);
+        const auto taxiLocation = Field("location", parameters[1]);
+        return {{personLocation, taxiLocation}, {personLocation, taxiLocation, Field("owe", parameters[0])}};
+    }
+
+    tfd_cpp::Footprint PayDriverFootprint(const tfd_cpp::State&, const tfd_cpp::Parameters& parameters)
+    {
+        const auto cash = Field("cash", parameters[0]);
+        const auto owe = Field("owe", parameters[0]);
+        return {{cash, owe}, {cash, owe}};
+    }
+
+    tfd_cpp::Footprint TravelFootprint(const tfd_cpp::State&, const tfd_cpp::Parameters& parameters)
+    {
+        const auto personLocation = Field("location", parameters[0]);
+        const auto taxiLocation = Field("location", parameters[1]);
+        const auto cash = Field("cash", parameters[0]);
+        const auto owe = Field("owe", parameters[0]);
+        return {{personLocation, taxiLocation, cash, owe}, {personLocation, taxiLocation, cash, owe}};
+    }
+
+    std::uint64_t TravelProjection(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        tfd_cpp::ZobristHash projection = 0;
+        for (const auto& parameter : parameters)
         {
-            const auto& person = std::any_cast<SimpleTravelState::Object>(parameters[0]);
-            const auto& taxi = std::any_cast<SimpleTravelState::Object>(parameters[1]);
-            const auto& src = std::any_cast<SimpleTravelState::Location>(parameters[2]);
-            const auto& dst = std::any_cast<SimpleTravelState::Location>(parameters[3]);
-            auto simpleTravelState = std::any_cast<SimpleTravelState>(state.data);
+            projection = tfd_cpp::ZobristCombine(projection, tfd_cpp::HashParameter(parameter));
+        }
 
-            auto cash = simpleTravelState.CashOwnedBy(person);
-            auto distance = simpleTravelState.DistanceBetween(src, dst);
-            auto currentPersonLocation = simpleTravelState.LocationOf(person);
-            if (cash and distance and currentPersonLocation)
+        // the fields of TravelFootprint; the road map is the same in every state
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        const auto* person = parameters.size() == 4 ? std::any_cast<SimpleTravelState::Object>(&parameters[0]) : nullptr;
+        const auto* taxi = parameters.size() == 4 ? std::any_cast<SimpleTravelState::Object>(&parameters[1]) : nullptr;
+        if (simpleTravelState and person and taxi)
+        {
+            for (const auto& field : {simpleTravelState->LocationOf(*person), simpleTravelState->LocationOf(*taxi)})
             {
-                if (currentPersonLocation.value() == src)
-                {
-                    if (cash.value() >= simpleTravelState.TaxiRate(distance.value()))
-                    {
-                        tfd_cpp::Task callTaxi;
-                        callTaxi.taskName = CALL_TAXI;
-                        callTaxi.parameters.push_back(person);
-                        callTaxi.parameters.push_back(taxi);
-
-                        tfd_cpp::Task rideTaxi;
-                        rideTaxi.taskName = RIDE_TAXI;
-                        rideTaxi.parameters.push_back(person);
-                        rideTaxi.parameters.push_back(taxi);
-                        rideTaxi.parameters.push_back(src);
-                        rideTaxi.parameters.push_back(dst);
-
-                        tfd_cpp::Task payDriver;
-                        payDriver.taskName = PAY_DRIVER;
-                        payDriver.parameters.push_back(person);
-
-                        std::vector<tfd_cpp::Task> subtasks{payDriver, rideTaxi, callTaxi};
-                        
-                        return subtasks;
-                    }
-                }
+                projection = tfd_cpp::ZobristCombine(projection, field ? tfd_cpp::ZobristKey(field.value()) : 0);
+            }
+            for (const auto& field : {simpleTravelState->CashOwnedBy(*person), simpleTravelState->Owe(*person)})
+            {
+                projection = tfd_cpp::ZobristCombine(projection, field ? tfd_cpp::ZobristKey(field.value()) : 0);
             }
         }
-        catch(const std::exception& e)
+        return projection;
+    }
+
+    std::uint64_t HashState(const tfd_cpp::State& state)
+    {
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        return simpleTravelState ? simpleTravelState->Hash() : 0;
+    }
+
+    std::optional<std::int64_t> TravelRoadLength(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (parameters.size() != 4)
+        {
+            return std::nullopt;
+        }
+
+        const auto* simpleTravelState = std::any_cast<SimpleTravelState>(&state.data);
+        const auto* src = std::any_cast<SimpleTravelState::Location>(&parameters[2]);
+        const auto* dst = std::any_cast<SimpleTravelState::Location>(&parameters[3]);
+        if (not simpleTravelState or not src or not dst)
+        {
+            return std::nullopt;
+        }
+
+        auto distance = simpleTravelState->DistanceBetween(*src, *dst);
+        if (not distance)
         {
-            std::cerr << e.what() << " in " << __PRETTY_FUNCTION__ << '\n';
+            return std::nullopt;
         }
-        
-        return std::nullopt;
+        return distance.value();
     }
 
     tfd_cpp::PlanningDomain CreatePlanningDomain()
     {
         tfd_cpp::PlanningDomain planningDomain(DOMAIN_NAME);
+        planningDomain.SetStateHashFunction(HashState);
 
-        // Add operators
-        planningDomain.AddOperator(WALK, Walk);
-        planningDomain.AddOperator(CALL_TAXI, CallTaxi);
-        planningDomain.AddOperator(RIDE_TAXI, RideTaxi);
-        planningDomain.AddOperator(PAY_DRIVER, PayDriver);
+        using Object = SimpleTravelState::Object;
+        using Location = SimpleTravelState::Location;
 
-        // Add methods
-        planningDomain.AddMethod(TRAVEL, TravelByFoot);
-        planningDomain.AddMethod(TRAVEL, TravelByTaxi);
+        // Add operators
+        planningDomain.AddOperator(WALK, tfd_cpp::Signature<Object, Location, Location>(), Walk);
+        planningDomain.AddOperator(CALL_TAXI, tfd_cpp::Signature<Object, Object>(), CallTaxi);
+        planningDomain.AddOperator(RIDE_TAXI, tfd_cpp::Signature<Object, Object, Location, Location>(), RideTaxi);
+        planningDomain.AddOperator(PAY_DRIVER, tfd_cpp::Signature<Object>(), PayDriver);
+
+        // Add methods; trips without a direct road only go by legs, long ones never by foot
+        planningDomain.AddGuardField("travel-road-length", TravelRoadLength);
+        planningDomain.AddMethod(TRAVEL, tfd_cpp::Signature<Object, Object, Location, Location>(), TravelByFoot,
+                                 {{"travel-road-length", tfd_cpp::GuardComparison::AtMost, WALKING_DISTANCE}});
+        planningDomain.AddMethod(TRAVEL, tfd_cpp::Signature<Object, Object, Location, Location>(), TravelByTaxi,
+                                 {{"travel-road-length", tfd_cpp::GuardComparison::AtLeast, 0}});
+        planningDomain.AddMethod(TRAVEL, tfd_cpp::Signature<Object, Object, Location, Location>(), TravelByLegs);
+
+        // Add costs
+        auto free = [](const tfd_cpp::State&, const tfd_cpp::Parameters&) { return 0.0; };
+        planningDomain.SetOperatorCost(WALK, free);
+        planningDomain.SetOperatorCost(CALL_TAXI, free);
+        planningDomain.SetOperatorCost(RIDE_TAXI, RideTaxiCost);
+        planningDomain.SetOperatorCost(PAY_DRIVER, free);
+        planningDomain.SetTaskLowerBound(TRAVEL, TravelLowerBound);
+
+        // Add footprints
+        planningDomain.SetTaskFootprint(WALK, WalkFootprint);
+        planningDomain.SetTaskFootprint(CALL_TAXI, CallTaxiFootprint);
+        planningDomain.SetTaskFootprint(RIDE_TAXI, RideTaxiFootprint);
+        planningDomain.SetTaskFootprint(PAY_DRIVER, PayDriverFootprint);
+        planningDomain.SetTaskFootprint(TRAVEL, TravelFootprint);
+
+        // Add projections, which let a SubplanCache reuse the plans of Travel tasks
+        planningDomain.SetTaskProjection(TRAVEL, TravelProjection);
 
         return planningDomain;
     }
 
-    std::ostream& operator<<(std::ostream& os, const SimpleTravelState& state)
+    std::ostream& operator<<(std::ostream& os, const SimpleTravelState&)
     {
         os << "SimpleTravelState";
         return os;
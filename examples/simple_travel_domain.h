@@ -2,7 +2,11 @@
 #pragma once
 
 #include "planning_domain.h"
+#include "zobrist.h"
 #include <functional>
+#include <limits>
+#include <memory>
+#include <unordered_map>
 
 namespace simple_travel
 {
@@ -16,30 +20,73 @@ namespace simple_travel
     #define RIDE_TAXI           "RideTaxi"
     #define PAY_DRIVER          "PayDriver"
 
+    // Locations are dense IDs into contiguous row-major matrices. Shortest distances and the next
+    // hop on every shortest path are computed once, with a Dijkstra search from each location,
+    // and all states share one road map instead of copying a distance table.
+    class RoadMap
+    {
+    public:
+        using Location = std::string;
+        using LocationId = std::uint32_t;
+        using Distance = std::uint32_t;
+
+        // Roads are two-way; roads of length 0 are ignored.
+        struct Road
+        {
+            Location from;
+            Location to;
+            Distance length;
+        };
+
+        RoadMap(const std::vector<Location>& locations, const std::vector<Road>& roads);
+        ~RoadMap();
+
+        std::size_t Size() const;
+        std::optional<LocationId> IdOf(const Location& location) const;
+        const Location& NameOf(LocationId location) const;
+
+        std::optional<Distance> RoadLength(LocationId from, LocationId to) const;
+        std::optional<Distance> ShortestDistance(LocationId from, LocationId to) const;
+        // First location after `from` on a shortest path to `to`; `to` itself if the road between them is one.
+        std::optional<LocationId> NextHop(LocationId from, LocationId to) const;
+
+    private:
+        static constexpr Distance UNREACHABLE = std::numeric_limits<Distance>::max();
+
+        std::size_t Index(LocationId from, LocationId to) const;
+
+        std::vector<Location> m_names;
+        std::unordered_map<Location, LocationId> m_ids;
+        std::vector<Distance> m_roadLength;
+        std::vector<Distance> m_shortestDistance;
+        std::vector<LocationId> m_nextHop;
+    };
+
     class SimpleTravelState
     {
     public:
 
         using Object = std::string;
-        using Location = std::string;
+        using Location = RoadMap::LocationId;
         using Cash = std::size_t;
-        using Distance = std::size_t;
+        using Distance = RoadMap::Distance;
         
         using PersonLocationTable = std::map<Object, Location>;
         using PersonCashTable = std::map<Object, Cash>;
         using PersonOweTable = std::map<Object, Cash>;
-        using DistanceTable = std::map<Location, std::map<Location, Distance>>;
 
         SimpleTravelState(const PersonLocationTable& personLocationTable,
                           const PersonCashTable& personCashTable,
                           const PersonOweTable& personOweTable,
-                          const DistanceTable& distanceTable);
+                          std::shared_ptr<const RoadMap> roadMap);
         virtual ~SimpleTravelState();
         
         std::optional<Location> LocationOf(const Object& person) const;
         std::optional<Cash> CashOwnedBy(const Object& person) const;
         std::optional<Cash> Owe(const Object& person) const;
+        // Length of the road between two locations, if there is one.
         std::optional<Distance> DistanceBetween(const Location& location1, const Location& location2) const;
+        const RoadMap& Roads() const;
 
         void SetLocationOf(const Object& person, const Location& location);
         void SetCashOwnedBy(const Object& person, const Cash& cash);
@@ -47,6 +94,9 @@ namespace simple_travel
 
         Cash TaxiRate(const Distance& distance) const;
 
+        // Kept up to date by the setters, so operators never rehash the whole state.
+        tfd_cpp::ZobristHash Hash() const;
+
     private:
 
         friend std::ostream& operator<<(std::ostream& os, const SimpleTravelState& state);
@@ -54,18 +104,49 @@ namespace simple_travel
         PersonLocationTable m_personLocationTable;
         PersonCashTable m_personCashTable;
         PersonOweTable m_personOweTable;
-        DistanceTable m_distanceTable;
+        std::shared_ptr<const RoadMap> m_roadMap;
+        tfd_cpp::ZobristHash m_hash;
     };
 
-    // Operators
-    std::optional<tfd_cpp::State> Walk(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
-    std::optional<tfd_cpp::State> CallTaxi(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
-    std::optional<tfd_cpp::State> RideTaxi(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
-    std::optional<tfd_cpp::State> PayDriver(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+    // Operators, registered with typed signatures so their parameters arrive unpacked
+    std::optional<tfd_cpp::State> Walk(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                       const SimpleTravelState::Location& src, const SimpleTravelState::Location& dst);
+    std::optional<tfd_cpp::State> CallTaxi(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                           const SimpleTravelState::Object& taxi);
+    std::optional<tfd_cpp::State> RideTaxi(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                           const SimpleTravelState::Object& taxi, const SimpleTravelState::Location& src,
+                                           const SimpleTravelState::Location& dst);
+    std::optional<tfd_cpp::State> PayDriver(const tfd_cpp::State& state, const SimpleTravelState::Object& person);
+
+    // Methods; a trip whose route is not a single road is split at the next hop
+    std::optional<std::vector<tfd_cpp::Task>> TravelByFoot(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                                           const SimpleTravelState::Object& taxi, const SimpleTravelState::Location& src,
+                                                           const SimpleTravelState::Location& dst);
+    std::optional<std::vector<tfd_cpp::Task>> TravelByTaxi(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                                           const SimpleTravelState::Object& taxi, const SimpleTravelState::Location& src,
+                                                           const SimpleTravelState::Location& dst);
+    std::optional<std::vector<tfd_cpp::Task>> TravelByLegs(const tfd_cpp::State& state, const SimpleTravelState::Object& person,
+                                                           const SimpleTravelState::Object& taxi, const SimpleTravelState::Location& src,
+                                                           const SimpleTravelState::Location& dst);
+
+    // Guard fields; the length of the road a Travel task would take in one leg, if there is one
+    std::optional<std::int64_t> TravelRoadLength(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+
+    // Costs (money spent) and lower bounds for cost-optimal planning
+    double RideTaxiCost(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+    double TravelLowerBound(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+
+    // Footprints (pieces of state read and written) for deordering plans
+    tfd_cpp::Footprint WalkFootprint(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+    tfd_cpp::Footprint CallTaxiFootprint(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+    tfd_cpp::Footprint RideTaxiFootprint(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+    tfd_cpp::Footprint PayDriverFootprint(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+    tfd_cpp::Footprint TravelFootprint(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+
+    // Projection of the state a Travel task reads, for caching its sub-plans
+    std::uint64_t TravelProjection(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
 
-    // Methods
-    std::optional<std::vector<tfd_cpp::Task>> TravelByFoot(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
-    std::optional<std::vector<tfd_cpp::Task>> TravelByTaxi(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters);
+    std::uint64_t HashState(const tfd_cpp::State& state);
 
     tfd_cpp::PlanningDomain CreatePlanningDomain();
 
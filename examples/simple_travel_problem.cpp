@@ -2,21 +2,30 @@
 
 namespace simple_travel {
 
-    // initial state
-    static const SimpleTravelState::PersonLocationTable s_initPersonLocationTable = {{"me", "home"}, {"taxi", "park"}};
-    static const SimpleTravelState::PersonCashTable s_initPersonCashTable = {{"me", 20}};
-    static const SimpleTravelState::PersonOweTable s_initPersonOweTable = {{"me", 0}};
-    static const SimpleTravelState::DistanceTable s_initDistanceTable = {{"home", {{"park", 8}}}, {"park", {{"home", 8}}}};
-
-    static const SimpleTravelState s_initialState(s_initPersonLocationTable,
-                                                  s_initPersonCashTable,
-                                                  s_initPersonOweTable,
-                                                  s_initDistanceTable);
+    std::shared_ptr<const RoadMap> CityRoadMap()
+    {
+        static const auto s_roadMap = std::make_shared<const RoadMap>(
+            std::vector<RoadMap::Location>{"home", "corner", "downtown", "park", "station"},
+            std::vector<RoadMap::Road>{{"home", "park", 8},
+                                       {"home", "corner", 2},
+                                       {"corner", "downtown", 4},
+                                       {"downtown", "station", 3},
+                                       {"park", "station", 12}});
+        return s_roadMap;
+    }
 
     tfd_cpp::PlanningProblem CreatePlanningProblem(const tfd_cpp::Task& topLevelTask)
     {
+        const auto roadMap = CityRoadMap();
+
+        // initial state
+        const SimpleTravelState::PersonLocationTable personLocationTable = {{"me", roadMap->IdOf("home").value()},
+                                                                            {"taxi", roadMap->IdOf("park").value()}};
+        const SimpleTravelState::PersonCashTable personCashTable = {{"me", 20}};
+        const SimpleTravelState::PersonOweTable personOweTable = {{"me", 0}};
+
         auto planningDomain = CreatePlanningDomain();
-        tfd_cpp::State state = {DOMAIN_NAME, s_initialState};
+        tfd_cpp::State state = {DOMAIN_NAME, SimpleTravelState(personLocationTable, personCashTable, personOweTable, roadMap)};
 
         return tfd_cpp::PlanningProblem(planningDomain, state, topLevelTask);
     }
@@ -7,5 +7,8 @@
 #include <vector>
 
 namespace simple_travel {
+    // The city every state of the problem shares.
+    std::shared_ptr<const RoadMap> CityRoadMap();
+
     tfd_cpp::PlanningProblem CreatePlanningProblem(const tfd_cpp::Task& topLevelTask);
 }
@@ -0,0 +1,76 @@
+// Persistent Agenda of Tasks
+#pragma once
+
+#include "planning_domain.h"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace tfd_cpp
+{
+    // Immutable stack of tasks whose Front() is the next task. Pop() and Push() return a new agenda
+    // that shares every task below the front with the one it came from, so keeping many partial
+    // decompositions alive costs one cell per task they added rather than a copy of each agenda.
+    class Agenda
+    {
+        struct Cell
+        {
+            Task task;
+            mutable std::shared_ptr<const Cell> next;  // released iteratively by ~Agenda
+        };
+
+    public:
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Task;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Task*;
+            using reference = const Task&;
+
+            const_iterator() : m_cell(nullptr) {}
+            explicit const_iterator(const Cell* cell) : m_cell(cell) {}
+
+            reference operator*() const { return m_cell->task; }
+            pointer operator->() const { return &m_cell->task; }
+            const_iterator& operator++() { m_cell = m_cell->next.get(); return *this; }
+            const_iterator operator++(int) { auto previous = *this; ++*this; return previous; }
+            bool operator==(const const_iterator& other) const { return m_cell == other.m_cell; }
+            bool operator!=(const const_iterator& other) const { return m_cell != other.m_cell; }
+
+        private:
+            const Cell* m_cell;
+        };
+
+        Agenda();
+        // tasks.front() becomes the next task.
+        explicit Agenda(const std::vector<Task>& tasks);
+        Agenda(const Agenda& other) = default;
+        Agenda(Agenda&& other) noexcept;
+        // the replaced cells are released by the destructor of other
+        Agenda& operator=(Agenda other);
+        ~Agenda();
+
+        bool Empty() const;
+        std::size_t Size() const;
+        const Task& Front() const;
+
+        // The agenda without its front task.
+        Agenda Pop() const;
+        // The agenda with the tasks in front of it. Like the subtasks a method returns, tasks.back()
+        // becomes the next task.
+        Agenda Push(std::vector<Task>&& tasks) const;
+
+        const_iterator begin() const;
+        const_iterator end() const;
+
+    private:
+        Agenda(std::shared_ptr<const Cell> front, std::size_t size);
+
+        std::shared_ptr<const Cell> m_front;
+        std::size_t m_size;
+    };
+}
@@ -0,0 +1,113 @@
+// Best-first and Beam Search over Partial Decompositions
+#pragma once
+
+#include "tfd.h"
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace tfd_cpp
+{
+    // Runs the GreedyBestFirst, WeightedAStar and Beam strategies of SearchOptions. Every node is a
+    // partial decomposition: the remaining agenda, the state and the plan prefix. A node shares all
+    // three with its parent and only adds the subtasks, successor state or plan step it produced, so
+    // the open list never copies an agenda, a state or a plan.
+    // With optimize, the search continues after the first plan and drops nodes whose cost plus the
+    // domain's lower bounds cannot beat it; the heuristic only orders the nodes.
+    class BestFirstSearch
+    {
+    public:
+        BestFirstSearch(const PlanningProblem& planningProblem, const SearchOptions& options);
+        ~BestFirstSearch();
+
+        SearchResult Run();
+
+    private:
+        // Bytes counted in the search's memory for as long as whatever holds them is alive, so
+        // structure shared between nodes is counted until the last node using it is gone.
+        struct SharedBytes
+        {
+            SharedBytes(std::size_t& memoryBytes, std::size_t bytes, std::shared_ptr<const SharedBytes> previous = nullptr);
+            // releases the bytes only this one kept counted without recursing through them
+            ~SharedBytes();
+            SharedBytes(const SharedBytes&) = delete;
+            SharedBytes& operator=(const SharedBytes&) = delete;
+
+            std::size_t& memoryBytes;
+            std::size_t bytes;
+            mutable std::shared_ptr<const SharedBytes> previous;
+        };
+
+        struct CountedState
+        {
+            CountedState(State&& state, std::size_t& memoryBytes, std::size_t bytes);
+
+            State state;
+            SharedBytes bytes;
+        };
+
+        struct PlanCell
+        {
+            PlanCell(const Task& task, const OperatorFunction* func, std::size_t topLevelTask,
+                     std::shared_ptr<const PlanCell> previous, std::size_t& memoryBytes);
+            // releases the cells only this one kept alive without recursing through them
+            ~PlanCell();
+
+            Task task;
+            const OperatorFunction* func;
+            std::size_t topLevelTask;       // index of the top-level task this step achieves
+            mutable std::shared_ptr<const PlanCell> previous;
+            SharedBytes bytes;
+        };
+
+        struct Node
+        {
+            Agenda agenda;
+            std::shared_ptr<const State> state;     // points into a CountedState, except the initial state
+            std::shared_ptr<const PlanCell> plan;   // last step first
+            // the agenda cells added by this node and its ancestors that are still in use
+            std::shared_ptr<const SharedBytes> agendaBytes;
+            std::size_t topLevelTasksStarted = 0;
+            double cost = 0.0;
+            double priority = 0.0;
+            std::size_t order = 0;          // generation order, breaks the remaining ties
+        };
+
+        struct Compare
+        {
+            bool operator()(const Node& lhs, const Node& rhs) const;
+        };
+
+        void RunBestFirst(SearchResult& result);
+        void RunBeam(SearchResult& result);
+        void Expand(const Node& node, std::vector<Node>& children);
+        void AddNode(Node&& node, std::vector<Node>& nodes);
+        // A node leaving the open list or the beam; what it shares stays counted while others use it.
+        void DropNode();
+        // Records a plan that completes the node; returns true if the search should stop.
+        bool FoundPlan(const Node& node, SearchResult& result);
+        double LowerBound(const Node& node) const;
+        bool Prune(const Node& node) const;
+        bool OverLimits();
+
+        const PlanningProblem& m_planningProblem;
+        const SearchOptions& m_options;
+        std::optional<std::chrono::steady_clock::time_point> m_deadline;
+        double m_costBound;
+        bool m_found;
+        bool m_timedOut;
+        bool m_memoryExceeded;
+        bool m_cancelled;
+        std::size_t m_nodesGenerated;
+        std::size_t m_nodesExpanded;
+        std::size_t m_steps;
+        std::size_t m_memoryBytes;
+        std::size_t m_peakMemoryBytes;
+        GuardSelection m_selection;
+        SubtaskLookahead m_lookahead;
+        std::mt19937_64 m_random;
+    };
+}
@@ -0,0 +1,40 @@
+// Checkpoints of Depth-first Searches
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tfd_cpp
+{
+    // Position of a depth-first search, see PlanIterator::Checkpoint(). Neither states nor tasks are
+    // stored: both are opaque to the planner. A resumed search rebuilds the choice points, the
+    // agenda, the state and the plan prefix by replaying the recorded alternatives against the same
+    // problem, so the domain's methods and operators must give the same results when called again.
+    struct SearchCheckpoint
+    {
+        struct ChoicePointRecord
+        {
+            std::string taskName;               // checked while replaying
+            std::size_t nextAlternative = 0;    // the one before it leads to the next choice point
+            // the order the alternatives are tried in, when guards or the method order chose one
+            bool selected = false;
+            std::vector<std::size_t> alternatives;
+        };
+
+        std::vector<ChoicePointRecord> choicePoints;    // root first
+        // Path to the best plan so far of an optimizing search; its last choice point leads to the plan.
+        std::vector<ChoicePointRecord> incumbent;
+        double costBound = std::numeric_limits<double>::infinity();
+        std::size_t nodesExpanded = 0;
+        std::size_t peakMemoryBytes = 0;
+        std::string randomState;                        // of the shuffled method order
+    };
+
+    // Replaces the file in one rename, so a crash while writing leaves the previous checkpoint intact.
+    bool SaveCheckpoint(const SearchCheckpoint& checkpoint, const std::string& path);
+    // nullopt, with an error logged, if the file cannot be read or is not a checkpoint.
+    std::optional<SearchCheckpoint> LoadCheckpoint(const std::string& path);
+}
@@ -0,0 +1,15 @@
+// Independent Subproblems of Multi-task Problems
+#pragma once
+
+#include "planning_problem.h"
+
+#include <vector>
+
+namespace tfd_cpp
+{
+    // Groups the top-level tasks so that no task writes a piece of state that a task of another
+    // group reads or writes, by their footprints in the initial state. Groups and the tasks in them
+    // are in the order of the top-level tasks. A task without a declared footprint may touch
+    // anything, so any such task puts all the tasks in one group.
+    std::vector<std::vector<std::size_t>> IndependentTaskGroups(const PlanningProblem& planningProblem);
+}
@@ -0,0 +1,112 @@
+// Bitset Fact State
+#pragma once
+
+#include "planning_domain.h"
+#include "zobrist.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tfd_cpp
+{
+    using FactId = std::uint32_t;
+
+    // One 64-bit word of a mask together with its position in the fact bitset.
+    struct FactWord
+    {
+        std::uint32_t index;
+        std::uint64_t bits;
+    };
+
+    // Masks only keep their non-zero words, so testing a handful of facts touches a handful of
+    // words regardless of how many ground facts the problem has.
+    using FactMask = std::vector<FactWord>;
+
+    FactMask MakeFactMask(std::vector<FactId> facts);
+
+    struct FluentCondition
+    {
+        std::uint32_t fluent;
+        double minimum;
+    };
+
+    struct FluentEffect
+    {
+        std::uint32_t fluent;
+        double delta;
+    };
+
+    struct FactOperator
+    {
+        FactMask positivePreconditions;
+        FactMask negativePreconditions;
+        FactMask addEffects;
+        FactMask deleteEffects;
+        std::vector<FluentCondition> fluentPreconditions;
+        std::vector<FluentEffect> fluentEffects;
+    };
+
+    // Fixed-width bitset of ground facts plus a small array of numeric fluents. The Zobrist hash is
+    // kept up to date by every modification, XOR-ing in the key of each fact that actually changes.
+    class FactState
+    {
+    public:
+        FactState(std::size_t factCount = 0, std::size_t fluentCount = 0);
+
+        bool Test(FactId fact) const;
+        void Set(FactId fact, bool value = true);
+        double Fluent(std::uint32_t fluent) const;
+        void SetFluent(std::uint32_t fluent, double value);
+
+        bool Satisfies(const FactOperator& factOperator) const;
+        void Apply(const FactOperator& factOperator);
+
+        std::size_t FactCount() const;
+        std::size_t FluentCount() const;
+        const std::vector<std::uint64_t>& Words() const;
+        ZobristHash Hash() const;
+
+        bool operator==(const FactState& other) const;
+
+    private:
+        std::size_t m_factCount;
+        std::vector<std::uint64_t> m_words;
+        std::vector<double> m_fluents;
+        ZobristHash m_hash;
+    };
+
+    // Checks many operators against one state. Mask words of all operators are stored together,
+    // sorted by word index, so every state word is loaded once per batch instead of once per operator.
+    class FactOperatorBatch
+    {
+    public:
+        explicit FactOperatorBatch(const std::vector<const FactOperator*>& operators);
+
+        void Applicable(const FactState& state, std::vector<std::uint8_t>& applicable) const;
+        std::size_t Size() const;
+
+    private:
+        struct Entry
+        {
+            std::uint32_t word;
+            std::uint32_t operatorIndex;
+            std::uint64_t positive;
+            std::uint64_t negative;
+        };
+
+        std::vector<Entry> m_entries;
+        std::vector<std::vector<FluentCondition>> m_fluentPreconditions;
+    };
+
+    // Returns the ground operator for a task's parameters, or nullptr if the parameters do not name one.
+    using FactOperatorGrounding = std::function<const FactOperator*(const Parameters&)>;
+
+    // State hash function for states holding a FactState, see PlanningDomain::SetStateHashFunction.
+    std::uint64_t HashFactState(const State& state);
+    // State size function for states holding a FactState, see PlanningDomain::SetStateSizeFunction.
+    std::size_t FactStateSize(const State& state);
+
+    // Wraps a mask-based operator so that it can be registered with PlanningDomain::AddOperator.
+    // The state passed to the returned function must hold a FactState.
+    OperatorFunction MakeOperatorFunction(const FactOperatorGrounding& grounding);
+}
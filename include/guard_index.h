@@ -0,0 +1,96 @@
+// Declarative Guards Indexed per Task
+#pragma once
+
+#include <any>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tfd_cpp
+{
+    struct State;
+
+    // Integer value a guard tests, read from the state through the task's parameters, e.g. the
+    // location of the person a task names or the length of the road between two of its parameters.
+    // nullopt if the field does not exist for these parameters; every guard on it then fails.
+    typedef std::function<std::optional<std::int64_t>(const State&, const std::vector<std::any>&)> GuardFieldFunction;
+
+    enum class GuardComparison
+    {
+        Equal,
+        AtMost,
+        AtLeast
+    };
+
+    // A cheap precondition of a method or operator: field compared with value. The search skips a
+    // method or operator without calling it unless all of its guards hold.
+    struct Guard
+    {
+        std::string field;
+        GuardComparison comparison;
+        std::int64_t value;
+    };
+
+    // Alternatives selected by a GuardIndex, and the buffers it reuses from one lookup to the next.
+    struct GuardSelection
+    {
+        std::vector<std::size_t> alternatives;  // increasing
+        std::vector<std::optional<std::int64_t>> fieldValues;
+        std::vector<bool> evaluated;
+    };
+
+    // Guards of the methods, or the operators, of one task. Each alternative is filed under its
+    // first guard: equalities in a hash table per field and bounds in a list per field sorted by
+    // bound, so one evaluation of a field and one lookup select every alternative filed under it.
+    // Further guards are checked on the selected alternatives only.
+    class GuardIndex
+    {
+    public:
+        GuardIndex();
+        ~GuardIndex();
+
+        // Fields must be added before the guards that read them.
+        void AddField(const std::string& fieldName, const GuardFieldFunction& fieldFunc);
+        // Alternatives must be added in order; one without guards is always selected.
+        // Returns false if a guard reads a field that was not added.
+        bool Add(std::size_t alternative, const std::vector<Guard>& guards);
+
+        // Alternatives whose guards hold in the state, in the order they were added.
+        void Select(const State& state, const std::vector<std::any>& parameters, GuardSelection& selection) const;
+
+    private:
+        struct Bound
+        {
+            std::int64_t value;
+            std::size_t alternative;
+
+            bool operator<(const Bound& other) const { return value < other.value; }
+        };
+
+        struct Field
+        {
+            std::string name;
+            GuardFieldFunction func;
+            std::unordered_map<std::int64_t, std::vector<std::size_t>> equal;
+            std::vector<Bound> atMost;      // sorted by value
+            std::vector<Bound> atLeast;     // sorted by value
+        };
+
+        struct ResolvedGuard
+        {
+            std::size_t field;
+            GuardComparison comparison;
+            std::int64_t value;
+        };
+
+        const std::optional<std::int64_t>& FieldValue(std::size_t field, const State& state, const std::vector<std::any>& parameters,
+                                                      GuardSelection& selection) const;
+
+        std::vector<Field> m_fields;
+        std::vector<std::size_t> m_unguarded;
+        std::vector<std::vector<ResolvedGuard>> m_residualGuards;     // per alternative, all guards but the first
+    };
+}
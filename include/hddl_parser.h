@@ -0,0 +1,127 @@
+// HDDL Domain and Problem Loader
+#pragma once
+
+#include "fact_state.h"
+#include "planning_problem.h"
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tfd_cpp
+{
+    using SymbolId = std::uint32_t;
+
+    static constexpr SymbolId INVALID_SYMBOL = std::numeric_limits<SymbolId>::max();
+
+    // Interns names into dense ids. Ids are assigned in order of first appearance.
+    class SymbolTable
+    {
+    public:
+        SymbolTable() = default;
+        SymbolTable(const SymbolTable& other);
+        SymbolTable(SymbolTable&& other) = default;
+        SymbolTable& operator=(const SymbolTable& other);
+        SymbolTable& operator=(SymbolTable&& other) = default;
+
+        SymbolId Intern(std::string_view name);
+        std::optional<SymbolId> Find(std::string_view name) const;
+        const std::string& NameOf(SymbolId id) const;
+        std::size_t Size() const;
+
+    private:
+        std::deque<std::string> m_names;
+        std::unordered_map<std::string_view, SymbolId> m_ids;
+    };
+
+    // A term is either a parameter slot of the enclosing action/method or an object id.
+    struct HddlTerm
+    {
+        bool isVariable;
+        std::uint32_t index;
+    };
+
+    struct HddlLiteral
+    {
+        SymbolId predicate;
+        bool positive;
+        std::vector<HddlTerm> arguments;
+    };
+
+    struct HddlTaskReference
+    {
+        SymbolId task;
+        std::vector<HddlTerm> arguments;
+    };
+
+    struct HddlPredicate
+    {
+        std::vector<SymbolId> parameterTypes;
+        std::vector<FactId> strides;
+        FactId offset;
+    };
+
+    struct HddlAction
+    {
+        SymbolId task;
+        std::vector<SymbolId> parameterTypes;
+        std::vector<HddlLiteral> preconditions;
+        std::vector<HddlLiteral> addEffects;
+        std::vector<HddlLiteral> deleteEffects;
+    };
+
+    struct HddlMethod
+    {
+        std::string name;
+        SymbolId task;
+        std::vector<HddlTerm> taskArguments;
+        std::vector<SymbolId> parameterTypes;
+        std::vector<HddlLiteral> preconditions;
+        std::vector<HddlTaskReference> subtasks;   // in execution order
+    };
+
+    // Compiled domain and problem. Types, objects, predicates and tasks are interned into separate
+    // dense id spaces so that a ground fact can be addressed by arithmetic instead of by name.
+    struct HddlModel
+    {
+        static constexpr SymbolId EQUALITY = INVALID_SYMBOL - 1;
+        static constexpr SymbolId OBJECT_TYPE = 0;
+
+        std::string domainName;
+        std::string problemName;
+
+        SymbolTable types;
+        SymbolTable objects;
+        SymbolTable predicates;
+        SymbolTable tasks;
+
+        std::vector<SymbolId> parentType;
+        std::vector<std::vector<SymbolId>> objectsOfType;
+        std::vector<std::vector<std::uint32_t>> indexInType;    // [type][object], INVALID_SYMBOL if not a member
+
+        std::vector<HddlPredicate> predicateTable;
+        std::vector<std::vector<SymbolId>> taskParameterTypes;
+        std::vector<bool> taskIsPrimitive;
+        std::vector<HddlAction> actions;
+        std::vector<HddlMethod> methods;
+
+        std::vector<HddlTaskReference> initialTaskNetwork;      // constants only
+        FactId factCount = 0;
+        FactState initialState;
+
+        std::optional<FactId> FactOf(SymbolId predicate, const std::vector<SymbolId>& arguments) const;
+        Task MakeTask(const HddlTaskReference& reference, const std::vector<SymbolId>& bindings) const;
+        std::string ToString(const Task& task) const;
+    };
+
+    std::shared_ptr<const HddlModel> ParseHddl(const std::string& domainText, const std::string& problemText);
+    std::shared_ptr<const HddlModel> LoadHddlFiles(const std::string& domainPath, const std::string& problemPath);
+
+    PlanningDomain CreatePlanningDomain(const std::shared_ptr<const HddlModel>& model);
+    PlanningProblem CreatePlanningProblem(const std::shared_ptr<const HddlModel>& model);
+}
@@ -0,0 +1,45 @@
+// Forward Checking of Subtasks
+#pragma once
+
+#include "planning_problem.h"
+
+#include <string>
+#include <vector>
+
+namespace tfd_cpp
+{
+    enum class Lookahead
+    {
+        None,
+        FirstSubtask,   // the subtask a method's decomposition starts with
+        // also the later subtasks whose footprints read nothing the subtasks before them write, and
+        // any subtask that has neither operators nor methods
+        Independent
+    };
+
+    // Checks a method's subtasks in the state the method is applied in, before the search commits to
+    // it. A primitive subtask fails the check if none of its operators' guards hold; the subtask that
+    // runs first is checked by applying its operators if they have no guards. Later subtasks are only
+    // checked against guards, in the same state, which is only sound when their guards read fields
+    // named in their footprints and the footprints depend on the parameters alone.
+    class SubtaskLookahead
+    {
+    public:
+        SubtaskLookahead();
+        ~SubtaskLookahead();
+
+        void SetMode(Lookahead lookahead);
+        Lookahead Mode() const;
+        // False if the method can be pruned; always true with Lookahead::None.
+        bool Passes(const PlanningProblem& planningProblem, const State& state, const std::vector<Task>& subtasks);
+
+    private:
+        // False if none of the task's operator guards holds or, for the task that runs next and has
+        // unguarded operators only, none of its operators applies.
+        bool OperatorsMayApply(const PlanningProblem& planningProblem, const State& state, const Task& task, bool runsNext);
+
+        Lookahead m_lookahead;
+        GuardSelection m_selection;
+        std::vector<std::string> m_written;     // by the subtasks checked so far
+    };
+}
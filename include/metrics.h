@@ -0,0 +1,133 @@
+// Runtime Metrics in Prometheus Text Format
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tfd_cpp
+{
+    struct SearchResult;
+
+    using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+    class Counter
+    {
+    public:
+        Counter();
+        ~Counter();
+
+        void Increment(std::uint64_t amount = 1);
+        std::uint64_t Value() const;
+
+    private:
+        std::atomic<std::uint64_t> m_value;
+    };
+
+    // Buckets hold the observations up to and including their upper bound; the last one, +Inf,
+    // takes the rest. Observe() only touches atomics, so it can be called from any thread.
+    class Histogram
+    {
+    public:
+        // The bounds must be increasing.
+        explicit Histogram(const std::vector<double>& upperBounds);
+        ~Histogram();
+
+        void Observe(double value);
+
+        const std::vector<double>& UpperBounds() const;
+        // Observations per bucket, not cumulative; one more entry than UpperBounds().
+        std::vector<std::uint64_t> BucketCounts() const;
+        std::uint64_t Count() const;
+        double Sum() const;
+
+    private:
+        const std::vector<double> m_upperBounds;
+        std::vector<std::atomic<std::uint64_t>> m_buckets;
+        std::atomic<std::uint64_t> m_sumBits;   // a double; atomic<double> cannot be added to before C++20
+    };
+
+    // start, start * factor, ..., count bounds in total.
+    std::vector<double> ExponentialBuckets(double start, double factor, std::size_t count);
+
+    // Named metric families, each with one metric per label set. Registration takes a lock; updating
+    // a metric does not. Metrics live as long as the registry.
+    class MetricsRegistry
+    {
+    public:
+        MetricsRegistry();
+        ~MetricsRegistry();
+
+        // Returns the existing metric for the name and labels, or registers it. Returns nullptr, and
+        // logs an error, if the name is not a valid metric name or is registered with another type.
+        Counter* GetCounter(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+        Histogram* GetHistogram(const std::string& name, const std::string& help, const std::vector<double>& upperBounds,
+                                const MetricLabels& labels = {});
+
+        // Prometheus text exposition format, version 0.0.4.
+        std::string Render() const;
+        // Replaces the file in one rename, so a scraper never reads half of it.
+        bool WriteToFile(const std::string& path) const;
+
+    private:
+        struct Family
+        {
+            std::string help;
+            bool isHistogram;
+            std::map<MetricLabels, std::unique_ptr<Counter>> counters;
+            std::map<MetricLabels, std::unique_ptr<Histogram>> histograms;
+        };
+
+        Family* GetFamily(const std::string& name, const std::string& help, bool isHistogram);
+
+        mutable std::shared_mutex m_mutex;
+        std::map<std::string, Family> m_families;
+    };
+
+    // The planner's own metrics, registered in a registry that the service may share with its own:
+    //   tfd_search_duration_seconds               histogram of the wall-clock time of a search
+    //   tfd_search_nodes_expanded                 histogram of the nodes a search expanded
+    //   tfd_searches_total{status}                searches by SearchStatus
+    //   tfd_callback_duration_seconds{task}       histogram of the time spent in a task's methods and operators
+    //   tfd_portfolio_wins_total{configuration}   portfolio searches each configuration decided
+    // Pass it to a search through SearchOptions::metrics. A metric whose name the registry already
+    // holds as another type is not recorded.
+    class PlannerMetrics
+    {
+    public:
+        explicit PlannerMetrics(MetricsRegistry& registry);
+        ~PlannerMetrics();
+
+        void RecordSearch(const SearchResult& result, std::chrono::steady_clock::duration duration);
+        // nullptr if the registry refused the histogram.
+        Histogram* CallbackDuration(const std::string& taskName);
+        void RecordPortfolioWinner(const std::string& configuration);
+
+    private:
+        MetricsRegistry& m_registry;
+        Histogram* m_searchDuration;
+        Histogram* m_nodesExpanded;
+        std::vector<Counter*> m_searches;   // indexed by SearchStatus
+        // the registry's lookup builds a label set, this one does not allocate
+        std::shared_mutex m_callbackMutex;
+        std::map<std::string, Histogram*, std::less<>> m_callbackDurations;
+    };
+
+    // Observes the seconds between its construction and destruction; does nothing without a histogram.
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram* histogram);
+        ~ScopedTimer();
+
+    private:
+        Histogram* m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
@@ -0,0 +1,30 @@
+// Plan Deordering and Parallel Schedules
+#pragma once
+
+#include "tfd.h"
+
+#include <functional>
+#include <vector>
+
+namespace tfd_cpp
+{
+    // Partial order over the steps of a totally ordered plan. Step j depends on step i < j when
+    // one of them writes a piece of state the other reads or writes. Steps without a declared
+    // footprint are treated as touching everything, so they are never reordered.
+    struct ParallelSchedule
+    {
+        std::vector<std::vector<std::size_t>> predecessors;    // DAG edges, per step
+        std::vector<std::size_t> levelOfStep;
+        std::vector<std::vector<std::size_t>> levels;          // steps in a level may run at the same time
+        std::vector<double> earliestStart;
+        double criticalPathLength = 0.0;
+    };
+
+    using StepDurationFunction = std::function<double(const OperatorWithParams&)>;
+
+    // Replays the plan from the initial state to evaluate every step's footprint in the state it
+    // is executed in. Returns nullopt if a step is not applicable during the replay.
+    // Steps take one time unit unless a duration function is given.
+    std::optional<ParallelSchedule> DeorderPlan(const PlanningProblem& planningProblem, const Plan& plan,
+                                                const StepDurationFunction& stepDuration = nullptr);
+}
@@ -0,0 +1,38 @@
+// Validation and Simulation of Plans
+#pragma once
+
+#include "tfd.h"
+
+#include <optional>
+#include <vector>
+
+namespace tfd_cpp
+{
+    struct ValidationOptions
+    {
+        // Applies the in-place operator of a task that has a single operator, changing one copy of
+        // the initial state instead of copying the state at every step. Other tasks still go through
+        // the plan step's own function.
+        bool inPlace = false;
+        bool keepFinalState = false;
+        std::size_t threads = 0;        // for ValidatePlans; the number of cores if 0
+    };
+
+    struct PlanValidation
+    {
+        bool valid = false;
+        // Steps applied before the first one that failed; the plan's length if it is valid.
+        std::size_t stepsApplied = 0;
+        double cost = 0.0;                  // of the steps applied
+        std::optional<State> finalState;    // after the steps applied, with keepFinalState
+    };
+
+    // Replays the plan from the initial state, which need not be the problem's, with the problem's
+    // operator costs.
+    PlanValidation ValidatePlan(const PlanningProblem& planningProblem, const State& initialState, const Plan& plan,
+                                const ValidationOptions& options = ValidationOptions());
+    // Validates every plan from the same initial state on a pool of threads; the operators must be
+    // safe to call from several threads at once.
+    std::vector<PlanValidation> ValidatePlans(const PlanningProblem& planningProblem, const State& initialState,
+                                              const std::vector<Plan>& plans, const ValidationOptions& options = ValidationOptions());
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "guard_index.h"
+
 #include <string>
 #include <any>
 #include <vector>
@@ -7,6 +9,10 @@
 #include <optional>
 #include <iostream>
 #include <functional>
+#include <cstdint>
+#include <tuple>
+#include <typeindex>
+#include <utility>
 
 namespace tfd_cpp
 {
@@ -24,8 +30,29 @@ namespace tfd_cpp
         Parameters parameters;
     };
 
+    // Named pieces of state a task reads and writes, e.g. "location:me".
+    struct Footprint
+    {
+        std::vector<std::string> reads;
+        std::vector<std::string> writes;
+    };
+
+    class Trail;
+
     typedef std::function<std::optional<State>(const State&, const Parameters&)> OperatorFunction;
+    // Changes the state in place and records how to undo each change on the trail. Returns false if
+    // the operator is not applicable; changes recorded before that are rolled back by the search.
+    typedef std::function<bool(State&, const Parameters&, Trail&)> InPlaceOperatorFunction;
     typedef std::function<std::optional<std::vector<Task>>(const State&, const Parameters&)> MethodFunction;
+    typedef std::function<std::uint64_t(const State&)> StateHashFunction;
+    typedef std::function<std::size_t(const State&)> StateSizeFunction;
+    typedef std::function<double(const State&, const Parameters&)> CostFunction;
+    typedef std::function<Footprint(const State&, const Parameters&)> FootprintFunction;
+    // Hash of a task's parameters and the state fields its decomposition reads, see SetTaskProjection.
+    typedef std::function<std::uint64_t(const State&, const Parameters&)> StateProjectionFunction;
+    typedef std::function<std::optional<std::vector<Task>>(const State&, const Parameters&, const std::any&)> ObjectMethodFunction;
+    // Objects with equal signatures are interchangeable in that state, see AddMethodPerObject.
+    typedef std::function<std::uint64_t(const State&, const std::any&)> ObjectSignatureFunction;
 
     struct OperatorWithParams
     {
@@ -47,8 +74,23 @@ namespace tfd_cpp
         MethodFunction func;
     };
 
+    // Parameter types of a task, e.g. Signature<std::string, int>() for a task taking a name and a count.
+    template<typename... Args>
+    struct Signature {};
+
+    using ParameterTypes = std::vector<std::type_index>;
+
+    // The object a method added by AddMethodPerObject binds; group tells the calls apart.
+    struct BoundObject
+    {
+        std::size_t group;
+        std::any object;
+    };
+
     using Operators = std::vector<OperatorFunction>;
+    using InPlaceOperators = std::vector<InPlaceOperatorFunction>;
     using Methods = std::vector<MethodFunction>;
+    using BoundObjects = std::vector<std::optional<BoundObject>>;
     using OperatorsWithParams = std::vector<OperatorWithParams>;
     using MethodsWithParams = std::vector<MethodWithParams>;
 
@@ -58,21 +100,154 @@ namespace tfd_cpp
         PlanningDomain(const std::string& domainName);
         ~PlanningDomain();
 
-        void AddOperator(const std::string& taskName, const OperatorFunction& operatorFunc);
-        void AddMethod(const std::string& taskName, const MethodFunction& methodFunc);
+        // With guards, the operator or method is only called in states where all of them hold; one
+        // whose guards read a field that was not added is logged and not registered.
+        void AddOperator(const std::string& taskName, const OperatorFunction& operatorFunc, const std::vector<Guard>& guards = {});
+        // The operator is also registered as an OperatorFunction that applies it to a copy, which is
+        // what plans and GetApplicableOperators hand out.
+        void AddInPlaceOperator(const std::string& taskName, const InPlaceOperatorFunction& operatorFunc,
+                                const std::vector<Guard>& guards = {});
+        void AddMethod(const std::string& taskName, const MethodFunction& methodFunc, const std::vector<Guard>& guards = {});
+        // Adds one method per object, each calling methodFunc with its own object, e.g. one method per
+        // taxi that could serve a ride. methodFunc must treat every object alike: with an object
+        // signature function, the search then tries a single object of each class of interchangeable
+        // objects and skips the others.
+        void AddMethodPerObject(const std::string& taskName, const std::vector<std::any>& objects, const ObjectMethodFunction& methodFunc);
+        // Typed registration: the callback receives the task's parameters unpacked as const Args&,
+        // and tasks with this name are checked against the signature when they are created.
+        // Every typed callback of a task must use the same signature.
+        template<typename... Args, typename Function>
+        void AddOperator(const std::string& taskName, Signature<Args...> signature, Function operatorFunc,
+                         const std::vector<Guard>& guards = {});
+        template<typename... Args, typename Function>
+        void AddMethod(const std::string& taskName, Signature<Args...> signature, Function methodFunc,
+                       const std::vector<Guard>& guards = {});
+        // Names a field that guards can test. Fields must be added before the guards that read them.
+        void AddGuardField(const std::string& fieldName, const GuardFieldFunction& fieldFunc);
+        void SetStateHashFunction(const StateHashFunction& stateHashFunc);
+        // Heap bytes owned by a state's data, used for the search's memory accounting.
+        void SetStateSizeFunction(const StateSizeFunction& stateSizeFunc);
+        // Objects are only interchangeable while no task on the agenda refers to them, which the
+        // search checks itself; the signature only has to describe the state.
+        void SetObjectSignatureFunction(const ObjectSignatureFunction& objectSignatureFunc);
+        void SetOperatorCost(const std::string& taskName, const CostFunction& costFunc);
+        void SetTaskLowerBound(const std::string& taskName, const CostFunction& lowerBoundFunc);
+        void SetTaskFootprint(const std::string& taskName, const FootprintFunction& footprintFunc);
+        // Declares what a compound task's decomposition depends on: two tasks of this name with equal
+        // projections must decompose into the same plan, which lets a SubplanCache reuse it.
+        void SetTaskProjection(const std::string& taskName, const StateProjectionFunction& projectionFunc);
 
         std::optional<OperatorsWithParams> GetApplicableOperators(const State& currentState, const Task& task) const;
         std::optional<MethodsWithParams> GetRelevantMethods(const State& currentState, const Task& task) const;
 
+        // Registered functions for a task name, or nullptr. The pointers stay valid until the
+        // domain is modified; the search walks them directly instead of copying them per node.
+        const Operators* FindOperators(const std::string& taskName) const;
+        const Methods* FindMethods(const std::string& taskName) const;
+        // Entry i is the in-place form of operator i, or empty if that operator has none. May be
+        // shorter than the operator list; nullptr if the task has no in-place operators.
+        const InPlaceOperators* FindInPlaceOperators(const std::string& taskName) const;
+        // Entry i is the object method i binds, or empty. nullptr if the task has no such methods or
+        // the domain has no object signature function.
+        const BoundObjects* FindBoundObjects(const std::string& taskName) const;
+        // Guards of a task's operators or methods; nullptr if none of them has any.
+        const GuardIndex* FindOperatorGuards(const std::string& taskName) const;
+        const GuardIndex* FindMethodGuards(const std::string& taskName) const;
+
         bool TaskIsOperator(const std::string& taskName) const;
         bool TaskIsMethod(const std::string& taskName) const;
+        // True if the task's parameters match its declared signature or it has none; a mismatch is logged.
+        bool CheckTask(const Task& task) const;
+        bool HasSignatures() const;
+        std::optional<std::uint64_t> HashState(const State& state) const;
+        // Bytes a copy of the state occupies; only sizeof(State) without a state size function.
+        std::size_t StateSize(const State& state) const;
+        std::uint64_t ObjectSignature(const State& state, const std::any& object) const;
+
+        // Cost of applying an operator task in a state; 1 for operators without a cost function.
+        double OperatorCost(const State& currentState, const Task& task) const;
+        // Admissible lower bound on the cost of achieving a task; 0 for tasks without a bound.
+        double TaskLowerBound(const State& currentState, const Task& task) const;
+        bool HasLowerBounds() const;
+        // Footprint of a task evaluated in the state it starts from; nullopt if none was declared.
+        std::optional<Footprint> TaskFootprint(const State& currentState, const Task& task) const;
+        // Projection of the state a task starts from; nullopt if none was declared.
+        std::optional<std::uint64_t> TaskProjection(const State& currentState, const Task& task) const;
     
     private:
+        void SetSignature(const std::string& taskName, const ParameterTypes& parameterTypes);
+        bool CheckGuards(const std::vector<Guard>& guards) const;
+        void IndexGuards(std::map<std::string, GuardIndex>& guardTable, const std::string& taskName, std::size_t alternative,
+                         const std::vector<Guard>& guards);
+
         std::string m_domainName;
         std::map<std::string, Operators> m_operatorTable;
+        std::map<std::string, InPlaceOperators> m_inPlaceOperatorTable;
         std::map<std::string, Methods> m_methodTable;
+        std::map<std::string, GuardFieldFunction> m_guardFieldTable;
+        std::map<std::string, GuardIndex> m_operatorGuardTable;
+        std::map<std::string, GuardIndex> m_methodGuardTable;
+        std::map<std::string, BoundObjects> m_boundObjectTable;
+        std::size_t m_objectGroups;
+        ObjectSignatureFunction m_objectSignatureFunction;
+        std::map<std::string, ParameterTypes> m_signatureTable;
+        StateHashFunction m_stateHashFunction;
+        StateSizeFunction m_stateSizeFunction;
+        std::map<std::string, CostFunction> m_costTable;
+        std::map<std::string, CostFunction> m_lowerBoundTable;
+        std::map<std::string, FootprintFunction> m_footprintTable;
+        std::map<std::string, StateProjectionFunction> m_projectionTable;
     };
 
+    namespace detail
+    {
+        // Calls the function with the parameters unpacked as Args, or returns nullopt if they do not match.
+        template<typename Result, typename Function, typename... Args, std::size_t... Index>
+        Result CallWithArguments(const Function& func, Signature<Args...>, std::index_sequence<Index...>,
+                                 const State& state, const Parameters& parameters)
+        {
+            if (parameters.size() != sizeof...(Args))
+            {
+                return std::nullopt;
+            }
+
+            const std::tuple<const Args*...> arguments{std::any_cast<Args>(&parameters[Index])...};
+            if ((false or ... or (std::get<Index>(arguments) == nullptr)))
+            {
+                return std::nullopt;
+            }
+
+            return func(state, *std::get<Index>(arguments)...);
+        }
+    }
+
+    template<typename... Args, typename Function>
+    void PlanningDomain::AddOperator(const std::string& taskName, Signature<Args...> signature, Function operatorFunc,
+                                     const std::vector<Guard>& guards)
+    {
+        SetSignature(taskName, {std::type_index(typeid(Args))...});
+        AddOperator(taskName, OperatorFunction([signature, operatorFunc](const State& currentState, const Parameters& parameters)
+        {
+            return detail::CallWithArguments<std::optional<State>>(operatorFunc, signature, std::index_sequence_for<Args...>(),
+                                                                   currentState, parameters);
+        }), guards);
+    }
+
+    template<typename... Args, typename Function>
+    void PlanningDomain::AddMethod(const std::string& taskName, Signature<Args...> signature, Function methodFunc,
+                                   const std::vector<Guard>& guards)
+    {
+        SetSignature(taskName, {std::type_index(typeid(Args))...});
+        AddMethod(taskName, MethodFunction([signature, methodFunc](const State& currentState, const Parameters& parameters)
+        {
+            return detail::CallWithArguments<std::optional<std::vector<Task>>>(methodFunc, signature, std::index_sequence_for<Args...>(),
+                                                                               currentState, parameters);
+        }), guards);
+    }
+
+    // Bytes a task occupies, including its name and parameter storage, for memory accounting.
+    std::size_t TaskSize(const Task& task);
+
     std::ostream& operator<<(std::ostream& os, const State& state);
     std::ostream& operator<<(std::ostream& os, const Task& task);
 }
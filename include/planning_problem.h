@@ -6,6 +6,13 @@
 
 namespace tfd_cpp
 {
+    // Ordered top-level tasks. A struct rather than a plain vector, so that a braced single task
+    // such as {"Travel", {...}} still picks the single-task constructor.
+    struct TaskNetwork
+    {
+        std::vector<Task> tasks;
+    };
+
     class PlanningProblem
     {
     public:
@@ -13,18 +20,39 @@ namespace tfd_cpp
         using ApplicableOperators = OperatorsWithParams;
         
         PlanningProblem(const PlanningDomain& domain, const State& initialState, const Task& topLevelTask);
+        // The tasks are planned in order as one search, so later tasks can change how earlier ones are achieved.
+        PlanningProblem(const PlanningDomain& domain, const State& initialState, const TaskNetwork& topLevelTasks);
         ~PlanningProblem();
 
+        const Operators* FindOperators(const std::string& taskName) const;
+        const Methods* FindMethods(const std::string& taskName) const;
+        const InPlaceOperators* FindInPlaceOperators(const std::string& taskName) const;
+        const BoundObjects* FindBoundObjects(const std::string& taskName) const;
+        const GuardIndex* FindOperatorGuards(const std::string& taskName) const;
+        const GuardIndex* FindMethodGuards(const std::string& taskName) const;
         bool TaskIsOperator(const std::string& taskName) const;
         bool TaskIsMethod(const std::string& taskName) const;
+        bool CheckTask(const Task& task) const;
+        bool HasSignatures() const;
         RelevantMethods GetMethodsForTask(const Task& task, const State& currentState) const;
         ApplicableOperators GetOperatorsForTask(const Task& task, const State& currentState) const;
-        State GetInitialState() const;
-        Task GetTopLevelTask() const;
+        std::optional<std::uint64_t> HashState(const State& state) const;
+        std::size_t StateSize(const State& state) const;
+        std::uint64_t ObjectSignature(const State& state, const std::any& object) const;
+        double OperatorCost(const State& currentState, const Task& task) const;
+        double TaskLowerBound(const State& currentState, const Task& task) const;
+        bool HasLowerBounds() const;
+        std::optional<Footprint> TaskFootprint(const State& currentState, const Task& task) const;
+        std::optional<std::uint64_t> TaskProjection(const State& currentState, const Task& task) const;
+        const PlanningDomain& GetPlanningDomain() const;
+        const State& GetInitialState() const;
+        // The first top-level task.
+        const Task& GetTopLevelTask() const;
+        const std::vector<Task>& GetTopLevelTasks() const;
 
     private:
         const PlanningDomain m_planningDomain;
         const State m_initialState;
-        const Task m_topLevelTask;
+        const std::vector<Task> m_topLevelTasks;
     };
 }
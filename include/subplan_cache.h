@@ -0,0 +1,61 @@
+// Cache of Sub-plans of Compound Tasks
+#pragma once
+
+#include "planning_domain.h"
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace tfd_cpp
+{
+    // Plans that achieved a compound task, keyed on the task's name and its projection (see
+    // PlanningDomain::SetTaskProjection). A depth-first search given the cache stores the sub-plan of
+    // every task it achieves and, the next time it meets a task with the same key, first tries to
+    // apply the stored sub-plan instead of decomposing the task again. The cache can outlive the
+    // search and be shared by several searches, also on other threads, of problems in one domain.
+    // Entries are never evicted, so the sub-plans stay where they are for as long as the cache lives;
+    // once it holds maxBytes, new ones are no longer added.
+    class SubplanCache
+    {
+    public:
+        explicit SubplanCache(std::size_t maxBytes = 64 * 1024 * 1024);
+        ~SubplanCache();
+
+        // nullptr if there is no sub-plan for the key. Counts a hit or a miss.
+        const OperatorsWithParams* Find(const std::string& taskName, std::uint64_t projection) const;
+        bool Contains(const std::string& taskName, std::uint64_t projection) const;
+        // Keeps the first sub-plan stored for a key. Returns false if the key was taken or the cache is full.
+        bool Store(const std::string& taskName, std::uint64_t projection, OperatorsWithParams subplan);
+
+        std::size_t Size() const;
+        // Estimate of the memory the sub-plans hold, see TaskSize().
+        std::size_t Bytes() const;
+        std::size_t Hits() const;
+        std::size_t Misses() const;
+
+    private:
+        struct Key
+        {
+            std::string taskName;
+            std::uint64_t projection;
+
+            bool operator==(const Key& other) const;
+        };
+
+        struct KeyHash
+        {
+            std::size_t operator()(const Key& key) const;
+        };
+
+        std::size_t m_maxBytes;
+        std::size_t m_bytes;
+        // a node-based map keeps every sub-plan in place while others are added
+        std::unordered_map<Key, OperatorsWithParams, KeyHash> m_subplans;
+        mutable std::shared_mutex m_mutex;
+        mutable std::atomic<std::size_t> m_hits;
+        mutable std::atomic<std::size_t> m_misses;
+    };
+}
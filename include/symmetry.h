@@ -0,0 +1,43 @@
+// Symmetry Reduction over Interchangeable Objects
+#pragma once
+
+#include "planning_problem.h"
+#include "zobrist.h"
+
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace tfd_cpp
+{
+    // Per choice point record of the objects tried so far, see PlanningDomain::AddMethodPerObject.
+    // Two objects of the same group are interchangeable if their signatures in the choice point's
+    // state are equal and no task on the agenda refers to either of them. Signatures are taken in
+    // the state at hand, so objects stop being interchangeable as soon as the state tells them apart.
+    class SymmetryFilter
+    {
+    public:
+        SymmetryFilter();
+        ~SymmetryFilter();
+
+        // Starts a new choice point.
+        void Clear();
+        // Objects among the task's parameters are never interchangeable at this choice point.
+        void Refer(const Task& task);
+        // True if an object interchangeable with this one has been tried; otherwise records it.
+        bool Skip(const PlanningProblem& planningProblem, const State& state, const BoundObject& boundObject);
+
+    private:
+        using ObjectClass = std::pair<std::size_t, std::uint64_t>;     // group and signature
+
+        struct ObjectClassHash
+        {
+            std::size_t operator()(const ObjectClass& objectClass) const;
+        };
+
+        std::vector<ZobristHash> m_referenced;
+        bool m_referencedSorted;
+        std::unordered_set<ObjectClass, ObjectClassHash> m_tried;
+    };
+}
@@ -1,17 +1,338 @@
 // Total-order Forward Decomposition Algorithm
 #pragma once
 
+#include "agenda.h"
+#include "checkpoint.h"
+#include "lookahead.h"
+#include "metrics.h"
 #include "planning_problem.h"
+#include "subplan_cache.h"
+#include "symmetry.h"
+#include "trail.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
 #include <vector>
 #include <utility>
 
 namespace tfd_cpp
 {
+    using Plan = OperatorsWithParams;
+
+    enum class SearchStatus
+    {
+        Solved,     // a plan was found; with optimize it may not be the cheapest one, without it is empty only if there is no other
+        Optimal,    // the search space was exhausted after finding the returned plan
+        NoPlan,     // the search space was exhausted without a plan
+        Timeout,            // the time limit was reached before any plan was found
+        MemoryExceeded,     // the memory limit was reached before any plan was found
+        Cancelled           // SearchOptions::cancel was set before any plan was found
+    };
+
+    enum class SearchStrategy
+    {
+        DepthFirst,         // TFD: methods and operators in the order they were added
+        GreedyBestFirst,    // expand the partial decomposition with the lowest heuristic value
+        WeightedAStar,      // expand the lowest cost + weight * heuristic
+        Beam                // keep the beamWidth best children per level, ranked like WeightedAStar; incomplete
+    };
+
+    enum class MethodOrder
+    {
+        AsAdded,
+        Reversed,
+        Shuffled            // a new random order for every decomposition, drawn from SearchOptions::seed
+    };
+
+    // Estimated cost of achieving the remaining agenda from the state. Without one, best-first
+    // strategies use the sum of the domain's task lower bounds.
+    using Heuristic = std::function<double(const State&, const Agenda&)>;
+
+    struct SearchOptions
+    {
+        // Branch-and-bound: keep searching after the first plan and prune every partial plan whose
+        // cost plus the lower bound of its remaining tasks reaches the cost of the best plan so far.
+        bool optimize = false;
+        std::optional<std::chrono::milliseconds> timeLimit;
+        // Cap on the bytes the search holds, see SearchResult::peakMemoryBytes.
+        std::optional<std::size_t> memoryLimit;
+        // Called with every improving plan, which makes an optimizing search usable as an anytime search.
+        std::function<void(const Plan&, double)> onPlanFound;
+
+        SearchStrategy strategy = SearchStrategy::DepthFirst;
+        Heuristic heuristic;
+        double weight = 1.0;
+        std::size_t beamWidth = 16;
+
+        // Order in which a task's methods are tried; best-first strategies only break ties with it.
+        MethodOrder methodOrder = MethodOrder::AsAdded;
+        std::uint64_t seed = 0;
+        // Prunes methods whose subtasks are known not to apply before decomposing them, see SubtaskLookahead.
+        Lookahead lookahead = Lookahead::None;
+        // Depth-first only: choice points this deep are not expanded, so the search is incomplete. Tasks
+        // with a single unguarded operator are applied without a choice point and do not count.
+        std::optional<std::size_t> depthLimit;
+        // Stops the search once set, e.g. by another search that got there first; must outlive the search.
+        const std::atomic<bool>* cancel = nullptr;
+
+        // Depth-first only: a SearchCheckpoint is written to this file every checkpointInterval, and
+        // when the search times out or is cancelled. With resume, the search continues from the
+        // file if there is one, and starts over, logging an error, if the file cannot be resumed.
+        std::string checkpointFile;
+        std::chrono::milliseconds checkpointInterval = std::chrono::minutes(1);
+        bool resume = false;
+
+        // Depth-first only: sub-plans of tasks with a projection are stored in and spliced from this
+        // cache, which may be shared by several searches and must outlive them. Not used by a
+        // search that checkpoints, since a checkpoint cannot record a splice.
+        SubplanCache* subplanCache = nullptr;
+
+        // Records the search's duration, outcome and callback times; must outlive the search.
+        PlannerMetrics* metrics = nullptr;
+    };
+
+    struct SearchResult
+    {
+        Plan plan;
+        double cost = 0.0;
+        SearchStatus status = SearchStatus::NoPlan;
+        std::size_t nodesExpanded = 0;
+        // Estimate of the most memory the search held at once: choice points, agendas, subtasks,
+        // the states it kept for backtracking and the plan. States count sizeof(State) unless the
+        // domain has a state size function.
+        std::size_t peakMemoryBytes = 0;
+        // taskBoundaries[i] is one past the last plan step of top-level task i.
+        std::vector<std::size_t> taskBoundaries;
+    };
+
+    // One search of a portfolio; the name identifies it in the winner's report and the metrics.
+    struct PortfolioConfiguration
+    {
+        std::string name;
+        SearchOptions options;
+    };
+
+    struct PortfolioResult
+    {
+        // The winner's result; without a winner, the outcome of the configurations that ran out.
+        SearchResult result;
+        // The configuration that found the plan, or proved there is none, first.
+        std::optional<std::size_t> winner;
+        std::vector<SearchResult> results;      // per configuration; the others usually end Cancelled
+    };
+
+    struct DecomposedResult
+    {
+        // The groups' plans merged in the order of the top-level tasks; without a plan for every
+        // group, the outcome of the first group that failed.
+        SearchResult result;
+        std::vector<std::vector<std::size_t>> groups;   // indices of the top-level tasks planned together
+        std::vector<SearchResult> results;              // per group
+    };
+
+    // Depth-first search with the methods as added, reversed and shuffled with two seeds, and
+    // greedy best-first search; no limits.
+    std::vector<PortfolioConfiguration> DefaultPortfolio();
+
+    // Buffers a search keeps between calls: choice points, the live state and its trail, the partial
+    // plan and the returned plan. Slots are reused by assignment rather than destroyed on
+    // backtracking, so once a context has been warmed up by one search, repeating it allocates
+    // nothing inside the engine; allocations made by the domain's own methods and operators are
+    // the only ones left.
+    // A context serves one search at a time.
+    class PlannerContext
+    {
+    public:
+        PlannerContext();
+        ~PlannerContext();
+
+    private:
+        friend class PlanIterator;
+
+        // Agendas are linked lists that share their tail with the agenda they were derived from, so
+        // an expansion only links the subtasks it adds in front of its parent's remaining tasks.
+        struct AgendaLink
+        {
+            const Task* task;
+            const AgendaLink* next;
+        };
+
+        struct ChoicePoint
+        {
+            const AgendaLink* agenda = nullptr;     // the next task first; nullptr when empty
+            std::size_t topLevelTasksStarted = 0;   // the rest of the top-level tasks are not on the agenda yet
+            std::vector<Task> subtasks;         // decomposition the current alternative produced
+            std::vector<AgendaLink> links;      // agenda links of the subtasks
+            std::size_t trailSize = 0;          // the live state is this node's state at this trail size
+            std::size_t planSize = 0;
+            double cost = 0.0;
+            double lowerBound = 0.0;
+            const Operators* operators = nullptr;
+            const InPlaceOperators* inPlaceOperators = nullptr;
+            const Methods* methods = nullptr;
+            const BoundObjects* boundObjects = nullptr;
+            const GuardIndex* guards = nullptr;
+            GuardSelection selection;           // the alternatives nextAlternative walks if selected
+            bool selected = false;
+            SymmetryFilter symmetry;
+            std::size_t nextAlternative = 0;
+            // a cached sub-plan of the task, tried before the methods
+            const Plan* subplan = nullptr;
+            std::optional<std::uint64_t> projection;    // of the state the task started from
+            // depth of the innermost choice point with a projection whose task is not achieved yet,
+            // 0 if none; each such choice point links to the next one out the same way
+            std::size_t openProjection = 0;
+            std::size_t bytes = 0;              // memory accounted to this node while it is on the stack
+            Histogram* callbackDuration = nullptr;  // only with metrics
+        };
+
+        struct PlanStep
+        {
+            Task task;
+            const OperatorFunction* func;
+        };
+
+        void PushPlanStep(const Task& task, const OperatorFunction& func);
+        void CopyPlan();
+
+        std::deque<ChoicePoint> m_choicePoints;  // a deque keeps the subtasks in place while it grows
+        std::size_t m_depth;
+        std::vector<AgendaLink> m_topLevelLinks;
+        State m_state;
+        Trail m_trail;
+        std::vector<PlanStep> m_planSteps;
+        std::size_t m_planSize;
+        std::vector<std::size_t> m_taskBoundaries;     // of the path being searched
+        Plan m_plan;
+        std::vector<std::size_t> m_planBoundaries;     // of m_plan
+    };
+
+    // Depth-first TFD search over an explicit stack of choice points. Every call to Next() resumes
+    // from the most recent choice point that still has untried alternatives, so enumerating k plans
+    // costs the same as one search that runs until it has found k solutions.
+    // The planning problem, and the context if one is passed, must outlive the iterator.
+    class PlanIterator
+    {
+    public:
+        using RelevantMethods = PlanningProblem::RelevantMethods;
+        using ApplicableOperators = PlanningProblem::ApplicableOperators;
+
+        PlanIterator(const PlanningProblem& planningProblem);
+        PlanIterator(const PlanningProblem& planningProblem, PlannerContext& context);
+        PlanIterator(PlanIterator&&) = default;
+        ~PlanIterator();
+
+        std::optional<Plan> Next();
+        // Same as Next() without copying the plan; it stays in CurrentPlan() until the next call.
+        bool Advance();
+        const Plan& CurrentPlan() const;
+        // Where each top-level task's steps end in CurrentPlan(), see SearchResult::taskBoundaries.
+        const std::vector<std::size_t>& TaskBoundaries() const;
+        bool Exhausted() const;
+        bool TimedOut() const;
+
+        // Only plans cheaper than the bound are returned; partial plans that cannot beat it are pruned.
+        void SetCostBound(double costBound);
+        void SetDeadline(std::chrono::steady_clock::time_point deadline);
+        // Stops the search, as if it were exhausted, once it would hold more than this many bytes.
+        void SetMemoryLimit(std::size_t memoryLimit);
+        bool MemoryExceeded() const;
+        void SetMetrics(PlannerMetrics* metrics);
+        void SetMethodOrder(MethodOrder methodOrder, std::uint64_t seed);
+        void SetDepthLimit(std::size_t depthLimit);
+        void SetLookahead(Lookahead lookahead);
+        // Stops the search, as if it timed out, once the flag is set.
+        void SetCancelFlag(const std::atomic<bool>* cancel);
+        bool Cancelled() const;
+
+        // Where the search is, for Resume() in this or another process. The path to the incumbent is
+        // only recorded while checkpointing is set.
+        SearchCheckpoint Checkpoint() const;
+        // Continues a checkpointed search of the same problem, instead of starting a new one; call it
+        // before Advance(). If the checkpoint has an incumbent, CurrentPlan() and PlanCost() hold its
+        // plan afterwards. Returns false, and logs an error, if replaying the checkpoint diverges; the
+        // iterator then starts a new search.
+        bool Resume(const SearchCheckpoint& checkpoint);
+        // Hands Checkpoint() to onCheckpoint about once per interval while the search runs.
+        void SetCheckpointing(std::chrono::milliseconds interval, std::function<void(const SearchCheckpoint&)> onCheckpoint);
+        // See SearchOptions::subplanCache; ignored once checkpointing is set or the search is resumed.
+        void SetSubplanCache(SubplanCache* subplanCache);
+
+        double PlanCost() const;
+        std::size_t NodesExpanded() const;
+        std::size_t PeakMemory() const;
+
+    private:
+        using ChoicePoint = PlannerContext::ChoicePoint;
+        using AgendaLink = PlannerContext::AgendaLink;
+        using ChoicePointRecord = SearchCheckpoint::ChoicePointRecord;
+
+        bool StartSearch();
+        bool SeekPlan(ChoicePoint& node);
+        // Retakes the recorded alternatives from the root; with toPlan, the last one must complete a plan.
+        bool Replay(const std::vector<ChoicePointRecord>& records, bool toPlan);
+        std::vector<ChoicePointRecord> RecordChoicePoints() const;
+        void FoundPlan();
+        void Backtrack(const ChoicePoint& choicePoint);
+        bool SearchMethods(ChoicePoint& choicePoint, ChoicePoint& node);
+        bool SearchOperators(ChoicePoint& choicePoint, ChoicePoint& node);
+        bool SpliceSubplan(ChoicePoint& choicePoint, ChoicePoint& node);
+        void StoreSubplans(ChoicePoint& node);
+        static std::size_t Alternatives(const ChoicePoint& choicePoint);
+        static std::size_t NextAlternative(ChoicePoint& choicePoint);
+        double LowerBound(const ChoicePoint& node, const State& currentState) const;
+        bool Prune(double cost, double lowerBound) const;
+        // A choice point itself; what it owns is added by the expansion that fills it.
+        static std::size_t NodeBytes();
+        // Sets TimedOut() or Cancelled(); the deadline is only read when checkClock is set.
+        bool Interrupted(bool checkClock);
+        bool OverMemoryLimit(std::size_t nodeBytes);
+
+        const PlanningProblem& m_planningProblem;
+        std::unique_ptr<PlannerContext> m_ownedContext;
+        PlannerContext* m_context;
+        bool m_started;
+        bool m_timedOut;
+        double m_costBound;
+        double m_planCost;
+        std::optional<std::chrono::steady_clock::time_point> m_deadline;
+        std::size_t m_nodesExpanded;
+        std::size_t m_steps;
+        std::optional<std::size_t> m_memoryLimit;
+        bool m_memoryExceeded;
+        std::size_t m_memoryBytes;
+        std::size_t m_peakMemoryBytes;
+        PlannerMetrics* m_metrics;
+        MethodOrder m_methodOrder;
+        std::mt19937_64 m_random;
+        std::optional<std::size_t> m_depthLimit;
+        SubtaskLookahead m_lookahead;
+        const std::atomic<bool>* m_cancel;
+        bool m_cancelled;
+        std::chrono::milliseconds m_checkpointInterval;
+        std::function<void(const SearchCheckpoint&)> m_onCheckpoint;
+        std::chrono::steady_clock::time_point m_nextCheckpoint;
+        std::vector<ChoicePointRecord> m_incumbent;
+        SubplanCache* m_subplanCache;
+    };
+
+    namespace detail
+    {
+        // Puts the alternatives in the method order; shared by the depth-first and best-first searches.
+        void OrderAlternatives(MethodOrder methodOrder, std::mt19937_64& random, std::vector<std::size_t>& alternatives);
+    }
+
     class TFD
     {
     public:
-        using Plan = OperatorsWithParams;
+        using Plan = tfd_cpp::Plan;
         using RelevantMethods = PlanningProblem::RelevantMethods;
         using ApplicableOperators = PlanningProblem::ApplicableOperators;
 
@@ -19,11 +340,27 @@ namespace tfd_cpp
         ~TFD();
 
         Plan TryToPlan();
+        // Plans in the given context; the returned plan lives in the context until its next search.
+        const Plan& TryToPlan(PlannerContext& context);
+        SearchResult Search(const SearchOptions& options);
+        // Only the depth-first strategy uses the context.
+        SearchResult Search(const SearchOptions& options, PlannerContext& context);
+        PlanIterator EnumeratePlans() const;
+        // Runs every configuration on a thread of its own and returns as soon as one of them finds
+        // a plan, or exhausts a complete search without one, cancelling the rest. A cancel flag set on
+        // any configuration cancels the whole portfolio, and only the first configuration naming a
+        // checkpoint file writes it. The domain's functions must be safe to call from several
+        // threads at once. Wins are counted in the metrics, if any are passed.
+        PortfolioResult SearchPortfolio(const std::vector<PortfolioConfiguration>& configurations, PlannerMetrics* metrics = nullptr);
+        // Splits the top-level tasks into groups that share no state, see IndependentTaskGroups(),
+        // plans each group as a problem of its own on a pool of threads (the number of cores if 0),
+        // and merges the plans. Tasks that interact stay in one group and are searched jointly.
+        // The time limit and cancel flag cover the whole search, the other options apply per group;
+        // the domain's functions must be safe to call from several threads at once.
+        DecomposedResult SearchDecomposed(const SearchOptions& options, std::size_t threads = 0);
 
     private:
-        Plan SeekPlan(const std::vector<Task>& tasks, const State& currentState, Plan& currentPlan);
-        Plan SearchMethods(const std::vector<Task>& tasks, const State& currentState, Plan& currentPlan);
-        Plan SearchOperators(const std::vector<Task>& tasks, const State& currentState, Plan& currentPlan);
+        SearchResult SearchDepthFirst(const SearchOptions& options, PlannerContext& context);
 
         const PlanningProblem m_planningProblem;
     };
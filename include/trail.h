@@ -0,0 +1,45 @@
+// Undo Trail for In-place Operators
+#pragma once
+
+#include "planning_domain.h"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace tfd_cpp
+{
+    // Undo log of the changes made to the one state a search keeps alive. Backtracking to a choice
+    // point undoes, newest first, every entry recorded after it. Slots are reused, so a warm trail
+    // only allocates for undo functions too large for std::function's inline buffer.
+    class Trail
+    {
+    public:
+        using UndoFunction = std::function<void(State&)>;
+
+        Trail();
+        ~Trail();
+
+        void Record(UndoFunction undo);
+
+        // Restores the current value of a field of the live state on backtracking.
+        template<typename T>
+        void Save(T& field)
+        {
+            Record([&field, previous = field](State&) mutable { field = std::move(previous); });
+        }
+
+        // Restores a whole state, for operators that return a successor instead of changing the state.
+        void SaveState(State&& state);
+
+        std::size_t Size() const;
+        void UndoTo(State& state, std::size_t mark);
+        void Clear();
+
+    private:
+        std::vector<UndoFunction> m_entries;    // an empty entry restores the newest saved state
+        std::size_t m_size;
+        std::vector<State> m_savedStates;
+        std::size_t m_savedStateCount;
+    };
+}
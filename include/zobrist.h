@@ -0,0 +1,45 @@
+// Zobrist Hashing of States and Agendas
+#pragma once
+
+#include "planning_domain.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace tfd_cpp
+{
+    using ZobristHash = std::uint64_t;
+
+    // Keys are derived with a stateless mixing function rather than drawn from a random table, so
+    // a feature maps to the same key in every state, every call and every process.
+    ZobristHash ZobristKey(std::uint64_t feature);
+    ZobristHash ZobristKey(std::string_view feature);
+
+    // Order-sensitive combination, used to build keys for composite features such as (person, location).
+    ZobristHash ZobristCombine(ZobristHash lhs, ZobristHash rhs);
+
+    // Supports bool, integral and floating point types and std::string. Other types only
+    // contribute their type, which keeps the hash correct but weaker.
+    ZobristHash HashParameter(const std::any& parameter);
+    ZobristHash HashTask(const Task& task);
+
+    // Hash of an agenda (a stack whose back() is the next task) that is updated on push and pop
+    // instead of being recomputed from the whole vector.
+    class AgendaHash
+    {
+    public:
+        void Push(const Task& task);
+        void Pop();
+        void Clear();
+
+        ZobristHash Value() const;
+        std::size_t Size() const;
+
+    private:
+        std::vector<ZobristHash> m_keys;
+        ZobristHash m_value = 0;
+    };
+
+    ZobristHash HashAgenda(const std::vector<Task>& tasks);
+}
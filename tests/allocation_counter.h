@@ -0,0 +1,11 @@
+// Allocation Counter for Tests
+#pragma once
+
+#include <cstddef>
+
+namespace tfd_cpp_test
+{
+    // Calls of the global operator new so far. Linking allocation_counter.cpp replaces the global
+    // operator new and delete, so a test executable that does cannot hold the other tests.
+    std::size_t Allocations();
+}
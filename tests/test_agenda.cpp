@@ -0,0 +1,53 @@
+#include "agenda.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <string>
+#include <vector>
+
+TEST(AgendaTest, FrontIsFirstTask)
+{
+    tfd_cpp::Agenda agenda(std::vector<tfd_cpp::Task>{{"First", {}}, {"Second", {}}});
+
+    ASSERT_FALSE(agenda.Empty());
+    ASSERT_EQ(2, agenda.Size());
+    ASSERT_EQ("First", agenda.Front().taskName);
+    ASSERT_EQ("Second", agenda.Pop().Front().taskName);
+    ASSERT_TRUE(agenda.Pop().Pop().Empty());
+    ASSERT_TRUE(tfd_cpp::Agenda().Empty());
+}
+
+TEST(AgendaTest, PushAndPopLeaveTheOriginalUnchanged)
+{
+    const tfd_cpp::Agenda agenda(std::vector<tfd_cpp::Task>{{"Task", {}}, {"Last", {}}});
+
+    const auto rest = agenda.Pop();
+    const auto decomposed = rest.Push({{"SubtaskB", {2}}, {"SubtaskA", {1}}});
+
+    std::vector<std::string> names;
+    for (const auto& task : decomposed)
+    {
+        names.push_back(task.taskName);
+    }
+    ASSERT_EQ((std::vector<std::string>{"SubtaskA", "SubtaskB", "Last"}), names);
+    ASSERT_EQ(3, decomposed.Size());
+    ASSERT_EQ(1, std::any_cast<int>(decomposed.Front().parameters[0]));
+
+    ASSERT_EQ(2, agenda.Size());
+    ASSERT_EQ("Task", agenda.Front().taskName);
+    ASSERT_EQ(1, rest.Size());
+    // the task below the pushed ones is shared, not copied
+    ASSERT_EQ(&rest.Front(), &decomposed.Pop().Pop().Front());
+}
+
+TEST(AgendaTest, ReleasesLongAgendas)
+{
+    tfd_cpp::Agenda agenda;
+    for (int task = 0; task < 100000; ++task)
+    {
+        agenda = agenda.Push({{"Task", {}}});
+    }
+    ASSERT_EQ(100000, agenda.Size());
+
+    agenda = tfd_cpp::Agenda();
+    ASSERT_TRUE(agenda.Empty());
+}
@@ -0,0 +1,212 @@
+// Built as its own executable because it links allocation_counter.cpp, which replaces the global
+// operator new.
+#include "allocation_counter.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <optional>
+#include <boost/log/core.hpp>
+
+namespace {
+    using tfd_cpp_test::Allocations;
+
+    std::size_t g_callbackAllocations = 0;
+
+    // Attributes the allocations made while it is alive, including those of the returned value,
+    // to the domain instead of the engine.
+    struct CallbackAllocations
+    {
+        CallbackAllocations() : before(Allocations()) {}
+        ~CallbackAllocations() { g_callbackAllocations += Allocations() - before; }
+
+        std::size_t before;
+    };
+
+    std::size_t EngineAllocations(std::size_t allocationsBefore, std::size_t callbackAllocationsBefore)
+    {
+        return (Allocations() - allocationsBefore) - (g_callbackAllocations - callbackAllocationsBefore);
+    }
+
+    std::optional<tfd_cpp::State> Increment(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        CallbackAllocations callbackAllocations;
+        tfd_cpp::State newState(state);
+        newState.data = std::any_cast<int>(state.data) + 1;
+        return newState;
+    }
+
+    std::optional<tfd_cpp::State> IncrementEven(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (std::any_cast<int>(state.data) % 2 != 0)
+        {
+            return std::nullopt;
+        }
+        return Increment(state, parameters);
+    }
+
+    std::optional<tfd_cpp::State> Stuck(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::nullopt;
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> CountThroughDeadEnd(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        CallbackAllocations callbackAllocations;
+        const int count = std::any_cast<int>(parameters[0]);
+        if (count == 0)
+        {
+            return std::nullopt;
+        }
+        return std::vector<tfd_cpp::Task>{{"Count", {count - 1}}, {"Stuck", {}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> CountDown(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        CallbackAllocations callbackAllocations;
+        const int count = std::any_cast<int>(parameters[0]);
+        if (count == 0)
+        {
+            return std::nullopt;
+        }
+        return std::vector<tfd_cpp::Task>{{"Count", {count - 1}}, {"Increment", {count}}};
+    }
+
+    // too large for the small-buffer storage of std::any, so every copy of it is a heap allocation
+    struct Payload
+    {
+        char bytes[256] = {};
+    };
+
+    std::optional<std::vector<tfd_cpp::Task>> CountDownWithPayload(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        CallbackAllocations callbackAllocations;
+        const int count = std::any_cast<int>(parameters[0]);
+        if (count == 0)
+        {
+            return std::nullopt;
+        }
+        return std::vector<tfd_cpp::Task>{{"Payload", {count - 1}}, {"Increment", {Payload()}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Done(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (std::any_cast<int>(parameters[0]) != 0)
+        {
+            return std::nullopt;
+        }
+        return std::vector<tfd_cpp::Task>{};
+    }
+}
+
+struct AllocationTest : public ::testing::Test
+{
+    AllocationTest() :
+        planningDomain("Counter"),
+        initialState{"Counter", 0},
+        topLevelTask{"Count", {10}}
+    {
+        planningDomain.AddOperator("Increment", IncrementEven);
+        planningDomain.AddOperator("Increment", Increment);
+        planningDomain.AddOperator("Stuck", Stuck);
+        planningDomain.AddMethod("Count", CountThroughDeadEnd);
+        planningDomain.AddMethod("Count", CountDown);
+        planningDomain.AddMethod("Count", Done);
+
+        // records that pass the filter are formatted on the heap
+        boost::log::core::get()->set_logging_enabled(false);
+    }
+
+    ~AllocationTest()
+    {
+        boost::log::core::get()->set_logging_enabled(true);
+    }
+
+    tfd_cpp::PlanningDomain planningDomain;
+    tfd_cpp::State initialState;
+    tfd_cpp::Task topLevelTask;
+};
+
+TEST_F(AllocationTest, ColdContextAllocates)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::PlannerContext context;
+
+    const auto allocations = Allocations();
+    const auto callbackAllocations = g_callbackAllocations;
+    const auto& plan = tfd.TryToPlan(context);
+
+    ASSERT_EQ(10, plan.size());
+    ASSERT_LT(0, EngineAllocations(allocations, callbackAllocations));
+}
+
+TEST_F(AllocationTest, WarmContextDoesNotAllocate)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::PlannerContext context;
+    tfd.TryToPlan(context);
+
+    for (int run = 0; run < 5; ++run)
+    {
+        const auto allocations = Allocations();
+        const auto callbackAllocations = g_callbackAllocations;
+        const auto& plan = tfd.TryToPlan(context);
+
+        ASSERT_EQ(10, plan.size());
+        ASSERT_EQ("Increment", plan[0].task.taskName);
+        ASSERT_EQ(0, EngineAllocations(allocations, callbackAllocations));
+    }
+}
+
+TEST_F(AllocationTest, WarmContextDoesNotAllocateWithoutPlan)
+{
+    planningDomain.AddMethod("Impossible", CountThroughDeadEnd);
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Impossible", {3}});
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::PlannerContext context;
+    tfd.TryToPlan(context);
+
+    const auto allocations = Allocations();
+    const auto callbackAllocations = g_callbackAllocations;
+    const auto& plan = tfd.TryToPlan(context);
+
+    ASSERT_TRUE(plan.empty());
+    ASSERT_EQ(0, EngineAllocations(allocations, callbackAllocations));
+}
+
+TEST_F(AllocationTest, IteratorReusesContext)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::PlannerContext context;
+    {
+        tfd_cpp::PlanIterator planIterator(planningProblem, context);
+        ASSERT_TRUE(planIterator.Advance());
+    }
+
+    const auto allocations = Allocations();
+    const auto callbackAllocations = g_callbackAllocations;
+    tfd_cpp::PlanIterator planIterator(planningProblem, context);
+
+    ASSERT_TRUE(planIterator.Advance());
+    ASSERT_EQ(10, planIterator.CurrentPlan().size());
+    ASSERT_EQ(0, EngineAllocations(allocations, callbackAllocations));
+}
+
+TEST_F(AllocationTest, WarmContextCopiesHeapSizedParameters)
+{
+    // the plan holds copies of its steps' tasks, and copying a parameter that does not fit std::any's
+    // small buffer allocates
+    planningDomain.AddMethod("Payload", CountDownWithPayload);
+    planningDomain.AddMethod("Payload", Done);
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Payload", {10}});
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::PlannerContext context;
+    tfd.TryToPlan(context);
+
+    const auto allocations = Allocations();
+    const auto callbackAllocations = g_callbackAllocations;
+    const auto& plan = tfd.TryToPlan(context);
+
+    ASSERT_EQ(10, plan.size());
+    ASSERT_LE(10, EngineAllocations(allocations, callbackAllocations));
+}
@@ -0,0 +1,278 @@
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+namespace {
+    int Count(const tfd_cpp::State& state)
+    {
+        return std::any_cast<int>(state.data);
+    }
+
+    std::optional<tfd_cpp::State> Move(const tfd_cpp::State& state, int step)
+    {
+        tfd_cpp::State newState(state);
+        newState.data = Count(state) + step;
+        return newState;
+    }
+
+    std::optional<tfd_cpp::State> Up(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return Move(state, 1);
+    }
+
+    std::optional<tfd_cpp::State> Down(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return Move(state, -1);
+    }
+
+    std::optional<tfd_cpp::State> Leap(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return Move(state, -3);
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> LeapDown(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Reach", parameters}, {"Leap", {}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> StepUp(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Reach", parameters}, {"Up", {}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> StepDown(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Reach", parameters}, {"Down", {}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Climb(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Climb", {}}, {"Up", {}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Done(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (Count(state) != std::any_cast<int>(parameters[0]))
+        {
+            return std::nullopt;
+        }
+        return std::vector<tfd_cpp::Task>{};
+    }
+
+    double Distance(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::abs(Count(state) - std::any_cast<int>(parameters[0]));
+    }
+
+    double DistanceToTargets(const tfd_cpp::State& state, const tfd_cpp::Agenda& agenda)
+    {
+        double distance = 0.0;
+        for (const auto& task : agenda)
+        {
+            if (task.taskName == "Reach")
+            {
+                distance += Distance(state, task.parameters);
+            }
+        }
+        return distance;
+    }
+
+    int Replay(tfd_cpp::State state, const tfd_cpp::Plan& plan)
+    {
+        for (const auto& step : plan)
+        {
+            state = step.func(state, step.task.parameters).value();
+        }
+        return Count(state);
+    }
+}
+
+struct BestFirstSearchTest : public ::testing::Test
+{
+    BestFirstSearchTest() :
+        planningDomain("Counter"),
+        initialState{"Counter", 0},
+        topLevelTask{"Reach", {-3}}
+    {
+        planningDomain.AddOperator("Up", Up);
+        planningDomain.AddOperator("Down", Down);
+        planningDomain.AddOperator("Leap", Leap);
+        planningDomain.SetOperatorCost("Leap", [](const tfd_cpp::State&, const tfd_cpp::Parameters&) { return 5.0; });
+        planningDomain.AddMethod("Reach", LeapDown);
+        planningDomain.AddMethod("Reach", StepUp);
+        planningDomain.AddMethod("Reach", StepDown);
+        planningDomain.AddMethod("Reach", Done);
+    }
+
+    ~BestFirstSearchTest() {}
+
+    tfd_cpp::PlanningDomain planningDomain;
+    tfd_cpp::State initialState;
+    tfd_cpp::Task topLevelTask;
+};
+
+TEST_F(BestFirstSearchTest, DepthFirstRunsAway)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::SearchOptions options;
+    options.memoryLimit = 1 << 16;
+    auto result = tfd.Search(options);
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::MemoryExceeded, result.status);
+}
+
+TEST_F(BestFirstSearchTest, GreedyFollowsTheHeuristic)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+    options.heuristic = DistanceToTargets;
+    auto result = tfd.Search(options);
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_EQ(1, result.plan.size());
+    ASSERT_EQ("Leap", result.plan[0].task.taskName);
+    ASSERT_EQ(5.0, result.cost);
+    ASSERT_EQ(-3, Replay(initialState, result.plan));
+    ASSERT_EQ(std::vector<std::size_t>{1}, result.taskBoundaries);
+}
+
+TEST_F(BestFirstSearchTest, WeightedAStarAddsTheCost)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::WeightedAStar;
+    options.heuristic = DistanceToTargets;
+    auto result = tfd.Search(options);
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_EQ(3, result.plan.size());
+    ASSERT_EQ("Down", result.plan[0].task.taskName);
+    ASSERT_EQ(3.0, result.cost);
+    ASSERT_EQ(-3, Replay(initialState, result.plan));
+}
+
+TEST_F(BestFirstSearchTest, OptimizeProvesTheCheapestPlan)
+{
+    planningDomain.SetTaskLowerBound("Reach", Distance);
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+
+    std::vector<double> costs;
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+    options.heuristic = DistanceToTargets;
+    options.optimize = true;
+    options.onPlanFound = [&costs](const tfd_cpp::Plan&, double cost) { costs.push_back(cost); };
+    auto result = tfd.Search(options);
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Optimal, result.status);
+    ASSERT_EQ(3.0, result.cost);
+    ASSERT_EQ((std::vector<double>{5.0, 3.0}), costs);
+}
+
+TEST_F(BestFirstSearchTest, BeamKeepsTheBestChildren)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::Beam;
+    options.heuristic = DistanceToTargets;
+    options.beamWidth = 1;
+    auto result = tfd.Search(options);
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_EQ(-3, Replay(initialState, result.plan));
+    // one node per level
+    ASSERT_EQ(3, result.nodesExpanded);
+}
+
+TEST_F(BestFirstSearchTest, BeamWithoutPlan)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Unknown", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::Beam;
+    auto result = tfd.Search(options);
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, result.status);
+    ASSERT_TRUE(result.plan.empty());
+}
+
+TEST_F(BestFirstSearchTest, PlansTopLevelTasksInOrder)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState,
+                                             tfd_cpp::TaskNetwork{{{"Reach", {-2}}, {"Reach", {0}}}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::WeightedAStar;
+    options.heuristic = DistanceToTargets;
+    auto result = tfd.Search(options);
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_EQ(4, result.plan.size());
+    ASSERT_EQ("Down", result.plan[0].task.taskName);
+    ASSERT_EQ("Up", result.plan[3].task.taskName);
+    ASSERT_EQ((std::vector<std::size_t>{2, 4}), result.taskBoundaries);
+}
+
+TEST_F(BestFirstSearchTest, StopsAtLimits)
+{
+    planningDomain.AddMethod("Climb", Climb);
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Climb", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+    options.timeLimit = std::chrono::milliseconds(20);
+    auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Timeout, result.status);
+
+    options.timeLimit.reset();
+    options.memoryLimit = 1 << 16;
+    result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::MemoryExceeded, result.status);
+    ASSERT_LE(1 << 16, result.peakMemoryBytes);
+}
+
+TEST(BestFirstSearchMemoryTest, ExpandedNodesReleaseWhatTheirChildrenDoNotShare)
+{
+    // every step copies a 100 KB state, but only the newest state is still in use
+    tfd_cpp::PlanningDomain planningDomain("Copies");
+    planningDomain.AddOperator("Op", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        return std::optional<tfd_cpp::State>(state);
+    });
+    planningDomain.AddMethod("Run", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        return std::optional<std::vector<tfd_cpp::Task>>(std::vector<tfd_cpp::Task>(1000, {"Op", {}}));
+    });
+    planningDomain.SetStateSizeFunction([](const tfd_cpp::State& state) {
+        return std::any_cast<const std::vector<char>&>(state.data).size();
+    });
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"Copies", std::vector<char>(100 * 1024)}, {"Run", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    for (const auto strategy : {tfd_cpp::SearchStrategy::GreedyBestFirst, tfd_cpp::SearchStrategy::WeightedAStar,
+                                tfd_cpp::SearchStrategy::Beam})
+    {
+        tfd_cpp::SearchOptions options;
+        options.strategy = strategy;
+        options.memoryLimit = 1000000;
+        const auto result = tfd.Search(options);
+        ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+        ASSERT_EQ(1000, result.plan.size());
+        ASSERT_LT(result.peakMemoryBytes, 1000000);
+    }
+}
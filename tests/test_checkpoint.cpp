@@ -0,0 +1,271 @@
+#include "checkpoint.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int TARGET = 5;
+
+    std::optional<tfd_cpp::State> Move(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        const int position = std::any_cast<int>(state.data) + std::any_cast<int>(parameters[0]);
+        if (position > TARGET)
+        {
+            return std::nullopt;
+        }
+        tfd_cpp::State newState(state);
+        newState.data = position;
+        return newState;
+    }
+
+    double MoveCost(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::any_cast<int>(parameters[0]) == 1 ? 1.0 : 3.0;
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Arrived(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (std::any_cast<int>(state.data) != TARGET)
+        {
+            return std::nullopt;
+        }
+        return std::vector<tfd_cpp::Task>{};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Leap(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Reach", {}}, {"Move", {2}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Step(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Reach", {}}, {"Move", {1}}};
+    }
+
+    tfd_cpp::PlanningDomain CreatePlanningDomain()
+    {
+        tfd_cpp::PlanningDomain planningDomain("Checkpoint");
+        planningDomain.AddOperator("Move", Move);
+        planningDomain.SetOperatorCost("Move", MoveCost);
+        planningDomain.AddMethod("Reach", Arrived);
+        planningDomain.AddMethod("Reach", Leap);
+        planningDomain.AddMethod("Reach", Step);
+        return planningDomain;
+    }
+
+    std::vector<int> Moves(const tfd_cpp::Plan& plan)
+    {
+        std::vector<int> moves;
+        for (const auto& step : plan)
+        {
+            moves.push_back(std::any_cast<int>(step.task.parameters[0]));
+        }
+        return moves;
+    }
+}
+
+struct CheckpointTest : public ::testing::Test
+{
+    CheckpointTest() :
+        planningDomain(CreatePlanningDomain()),
+        planningProblem(planningDomain, {"Checkpoint", 0}, {"Reach", {}}),
+        path(::testing::TempDir() + "tfd_cpp_checkpoint_test")
+    {
+    }
+
+    ~CheckpointTest()
+    {
+        std::remove(path.c_str());
+    }
+
+    tfd_cpp::PlanningDomain planningDomain;
+    tfd_cpp::PlanningProblem planningProblem;
+    std::string path;
+};
+
+TEST_F(CheckpointTest, SavedCheckpointsLoadBack)
+{
+    tfd_cpp::SearchCheckpoint checkpoint;
+    checkpoint.choicePoints.push_back({"Reach", 2, false, {}});
+    checkpoint.choicePoints.push_back({"Take the bus", 1, true, {3, 0, 2}});
+    checkpoint.nodesExpanded = 42;
+    checkpoint.peakMemoryBytes = 4096;
+    checkpoint.randomState = "1 2 3";
+    ASSERT_TRUE(tfd_cpp::SaveCheckpoint(checkpoint, path));
+
+    auto loaded = tfd_cpp::LoadCheckpoint(path);
+    ASSERT_TRUE(loaded);
+    ASSERT_TRUE(std::isinf(loaded->costBound));
+    ASSERT_EQ(42, loaded->nodesExpanded);
+    ASSERT_EQ(4096, loaded->peakMemoryBytes);
+    ASSERT_EQ("1 2 3", loaded->randomState);
+    ASSERT_TRUE(loaded->incumbent.empty());
+    ASSERT_EQ(2, loaded->choicePoints.size());
+    ASSERT_EQ("Take the bus", loaded->choicePoints[1].taskName);
+    ASSERT_EQ(1, loaded->choicePoints[1].nextAlternative);
+    ASSERT_TRUE(loaded->choicePoints[1].selected);
+    ASSERT_EQ((std::vector<std::size_t>{3, 0, 2}), loaded->choicePoints[1].alternatives);
+
+    checkpoint.costBound = 7.5;
+    checkpoint.incumbent = checkpoint.choicePoints;
+    ASSERT_TRUE(tfd_cpp::SaveCheckpoint(checkpoint, path));
+    loaded = tfd_cpp::LoadCheckpoint(path);
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(7.5, loaded->costBound);
+    ASSERT_EQ(2, loaded->incumbent.size());
+
+    std::ofstream(path) << "not a checkpoint\n";
+    ASSERT_FALSE(tfd_cpp::LoadCheckpoint(path));
+}
+
+TEST_F(CheckpointTest, ResumedEnumerationContinuesWithTheNextPlans)
+{
+    for (const auto methodOrder : {tfd_cpp::MethodOrder::AsAdded, tfd_cpp::MethodOrder::Shuffled})
+    {
+        std::vector<std::vector<int>> all;
+        tfd_cpp::PlanIterator uninterrupted(planningProblem);
+        uninterrupted.SetMethodOrder(methodOrder, 7);
+        while (uninterrupted.Advance())
+        {
+            all.push_back(Moves(uninterrupted.CurrentPlan()));
+        }
+        ASSERT_EQ(8, all.size());
+
+        tfd_cpp::PlanIterator interrupted(planningProblem);
+        interrupted.SetMethodOrder(methodOrder, 7);
+        for (int plan = 0; plan < 3; ++plan)
+        {
+            ASSERT_TRUE(interrupted.Advance());
+        }
+
+        tfd_cpp::PlanIterator resumed(planningProblem);
+        resumed.SetMethodOrder(methodOrder, 7);
+        ASSERT_TRUE(resumed.Resume(interrupted.Checkpoint()));
+        std::vector<std::vector<int>> rest;
+        while (resumed.Advance())
+        {
+            rest.push_back(Moves(resumed.CurrentPlan()));
+        }
+        ASSERT_EQ(std::vector<std::vector<int>>(all.begin() + 3, all.end()), rest);
+    }
+}
+
+TEST_F(CheckpointTest, CancelledOptimizationResumesFromTheFile)
+{
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::SearchOptions options;
+    options.optimize = true;
+    const auto uninterrupted = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Optimal, uninterrupted.status);
+    ASSERT_EQ(5.0, uninterrupted.cost);
+
+    // stop right after the first, most expensive, plan
+    std::atomic<bool> cancel(false);
+    options.cancel = &cancel;
+    options.onPlanFound = [&cancel](const tfd_cpp::Plan&, double) { cancel = true; };
+    options.checkpointFile = path;
+    const auto interrupted = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, interrupted.status);
+    ASSERT_GT(interrupted.cost, uninterrupted.cost);
+
+    tfd_cpp::TFD otherTfd(planningProblem);
+    cancel = false;
+    options.onPlanFound = nullptr;
+    options.resume = true;
+    const auto resumed = otherTfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Optimal, resumed.status);
+    ASSERT_EQ(uninterrupted.cost, resumed.cost);
+    ASSERT_EQ(Moves(uninterrupted.plan), Moves(resumed.plan));
+    ASSERT_GE(resumed.nodesExpanded, interrupted.nodesExpanded);
+}
+
+TEST_F(CheckpointTest, ResumedIncumbentIsReturnedIfNothingBeatsIt)
+{
+    tfd_cpp::PlanIterator interrupted(planningProblem);
+    interrupted.SetCheckpointing(std::chrono::minutes(1), [](const tfd_cpp::SearchCheckpoint&) {});
+    ASSERT_TRUE(interrupted.Advance());
+    const auto first = Moves(interrupted.CurrentPlan());
+    const auto firstCost = interrupted.PlanCost();
+    interrupted.SetCostBound(firstCost);
+    const auto checkpoint = interrupted.Checkpoint();
+    ASSERT_FALSE(checkpoint.incumbent.empty());
+
+    tfd_cpp::PlanIterator resumed(planningProblem);
+    ASSERT_TRUE(resumed.Resume(checkpoint));
+    ASSERT_EQ(first, Moves(resumed.CurrentPlan()));
+    ASSERT_EQ(firstCost, resumed.PlanCost());
+    ASSERT_EQ(1, resumed.TaskBoundaries().size());
+    ASSERT_EQ(first.size(), resumed.TaskBoundaries()[0]);
+}
+
+TEST_F(CheckpointTest, CheckpointsOfAnotherProblemAreRejected)
+{
+    tfd_cpp::PlanIterator interrupted(planningProblem);
+    ASSERT_TRUE(interrupted.Advance());
+    const auto checkpoint = interrupted.Checkpoint();
+
+    tfd_cpp::PlanningProblem otherProblem(planningDomain, {"Checkpoint", 0}, {"Move", {1}});
+    tfd_cpp::PlanIterator resumed(otherProblem);
+    ASSERT_FALSE(resumed.Resume(checkpoint));
+    // the rejected checkpoint leaves a new search behind
+    ASSERT_TRUE(resumed.Advance());
+    ASSERT_EQ(std::vector<int>{1}, Moves(resumed.CurrentPlan()));
+    ASSERT_EQ(1, resumed.NodesExpanded());
+}
+
+TEST_F(CheckpointTest, UnreadableCheckpointsStartTheSearchOver)
+{
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::SearchOptions options;
+    const auto fresh = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, fresh.status);
+
+    options.checkpointFile = path;
+    options.resume = true;
+    for (const auto& contents : {"not a checkpoint\n", "tfd_cpp-checkpoint 1\ncost-bound inf\n"})
+    {
+        std::ofstream(path) << contents;
+        const auto result = tfd.Search(options);
+        ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+        ASSERT_EQ(Moves(fresh.plan), Moves(result.plan));
+    }
+
+    // a checkpoint of the same problem that leads elsewhere
+    tfd_cpp::SearchCheckpoint checkpoint;
+    checkpoint.choicePoints.push_back({"Move", 1, false, {}});
+    ASSERT_TRUE(tfd_cpp::SaveCheckpoint(checkpoint, path));
+    const auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_EQ(Moves(fresh.plan), Moves(result.plan));
+    ASSERT_EQ(fresh.nodesExpanded, result.nodesExpanded);
+}
+
+TEST_F(CheckpointTest, CorruptCountsAreRejected)
+{
+    const std::string header = "tfd_cpp-checkpoint 1\ncost-bound inf\nnodes-expanded 0\npeak-memory-bytes 0\nrandom \n";
+    const std::vector<std::string> corrupt{
+        "choice-points 18446744073709551615\n0 0 0 Reach\n",
+        "choice-points 1\n0 0 18446744073709551615 1 2 Reach\nincumbent 0\n",
+        "choice-points 1\n0 1 3 1 2 Reach\nincumbent 0\n",
+        "choice-points 2\n0 0 0 Reach\n",
+        "choice-points 0\nincumbent 4611686018427387904\n",
+    };
+    for (const auto& records : corrupt)
+    {
+        std::ofstream(path) << header << records;
+        ASSERT_FALSE(tfd_cpp::LoadCheckpoint(path)) << records;
+    }
+
+    std::ofstream(path) << header << "choice-points 1\n0 1 2 1 0 Reach\nincumbent 0\n";
+    const auto loaded = tfd_cpp::LoadCheckpoint(path);
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(1, loaded->choicePoints.size());
+    ASSERT_EQ((std::vector<std::size_t>{1, 0}), loaded->choicePoints[0].alternatives);
+}
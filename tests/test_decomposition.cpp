@@ -0,0 +1,133 @@
+#include "decomposition.h"
+#include "test_helpers.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+    using tfd_cpp_test::CounterFootprint;
+    using tfd_cpp_test::ReadFootprint;
+    using Counters = std::map<std::string, int>;
+
+    std::optional<tfd_cpp::State> Bump(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        auto counters = std::any_cast<Counters>(state.data);
+        auto& counter = counters[std::any_cast<std::string>(parameters[0])];
+        if (counter >= 2)
+        {
+            return std::nullopt;
+        }
+        ++counter;
+        tfd_cpp::State newState(state);
+        newState.data = counters;
+        return newState;
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> BumpTwice(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Bump", parameters}, {"Bump", parameters}};
+    }
+
+    tfd_cpp::Task BumpTwiceTask(const std::string& counter)
+    {
+        return {"BumpTwice", {counter}};
+    }
+}
+
+struct DecompositionTest : public ::testing::Test
+{
+    DecompositionTest() :
+        planningDomain("Decomposition")
+    {
+        planningDomain.AddOperator("Bump", Bump);
+        planningDomain.AddMethod("BumpTwice", BumpTwice);
+        planningDomain.SetTaskFootprint("BumpTwice", CounterFootprint);
+        planningDomain.AddOperator("Look", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+            return std::optional<tfd_cpp::State>(state);
+        });
+        planningDomain.SetTaskFootprint("Look", ReadFootprint);
+    }
+
+    ~DecompositionTest() {}
+
+    tfd_cpp::PlanningProblem Problem(const std::vector<tfd_cpp::Task>& tasks) const
+    {
+        return tfd_cpp::PlanningProblem(planningDomain, {"Decomposition", Counters()}, tfd_cpp::TaskNetwork{tasks});
+    }
+
+    tfd_cpp::PlanningDomain planningDomain;
+};
+
+TEST_F(DecompositionTest, TasksSharingStateAreGrouped)
+{
+    const auto planningProblem = Problem({BumpTwiceTask("a"), BumpTwiceTask("b"), {"Look", {std::string("a")}},
+                                          {"Look", {std::string("c")}}, {"Look", {std::string("c")}}});
+    const auto groups = tfd_cpp::IndependentTaskGroups(planningProblem);
+
+    // reading the same piece of state is no interaction
+    ASSERT_EQ((std::vector<std::vector<std::size_t>>{{0, 2}, {1}, {3}, {4}}), groups);
+}
+
+TEST_F(DecompositionTest, TasksWithoutFootprintsAreNotSplit)
+{
+    planningDomain.AddMethod("Anything", BumpTwice);
+    const auto planningProblem = Problem({BumpTwiceTask("a"), {"Anything", {std::string("b")}}, BumpTwiceTask("c")});
+
+    ASSERT_EQ((std::vector<std::vector<std::size_t>>{{0, 1, 2}}), tfd_cpp::IndependentTaskGroups(planningProblem));
+}
+
+TEST_F(DecompositionTest, MergedPlanKeepsTheTaskOrder)
+{
+    std::vector<tfd_cpp::Task> tasks;
+    for (const auto counter : {"a", "b", "c", "d", "e", "f", "g", "h"})
+    {
+        tasks.push_back(BumpTwiceTask(counter));
+    }
+    tfd_cpp::TFD tfd(Problem(tasks));
+
+    const auto decomposedResult = tfd.SearchDecomposed(tfd_cpp::SearchOptions(), 3);
+    ASSERT_EQ(8, decomposedResult.groups.size());
+    ASSERT_EQ(8, decomposedResult.results.size());
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, decomposedResult.result.status);
+
+    const auto joint = tfd.Search(tfd_cpp::SearchOptions());
+    ASSERT_EQ(joint.plan.size(), decomposedResult.result.plan.size());
+    for (std::size_t step = 0; step < joint.plan.size(); ++step)
+    {
+        ASSERT_EQ(std::any_cast<std::string>(joint.plan[step].task.parameters[0]),
+                  std::any_cast<std::string>(decomposedResult.result.plan[step].task.parameters[0]));
+    }
+    ASSERT_EQ(joint.taskBoundaries, decomposedResult.result.taskBoundaries);
+}
+
+TEST_F(DecompositionTest, InteractingTasksAreSearchedJointly)
+{
+    // the second bump of "a" fails on its own, so only a joint search can report it
+    tfd_cpp::TFD tfd(Problem({BumpTwiceTask("a"), BumpTwiceTask("b"), BumpTwiceTask("a")}));
+
+    const auto decomposedResult = tfd.SearchDecomposed(tfd_cpp::SearchOptions(), 2);
+    ASSERT_EQ((std::vector<std::vector<std::size_t>>{{0, 2}, {1}}), decomposedResult.groups);
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, decomposedResult.result.status);
+    ASSERT_TRUE(decomposedResult.result.plan.empty());
+}
+
+TEST_F(DecompositionTest, GroupsThatNeedNoStepsAreSolved)
+{
+    planningDomain.AddMethod("Noop", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        return std::optional<std::vector<tfd_cpp::Task>>(std::vector<tfd_cpp::Task>());
+    });
+    planningDomain.SetTaskFootprint("Noop", CounterFootprint);
+    planningDomain.SetTaskFootprint("Bump", CounterFootprint);
+    tfd_cpp::TFD tfd(Problem({{"Bump", {std::string("a")}}, {"Noop", {std::string("b")}}}));
+
+    const auto decomposedResult = tfd.SearchDecomposed(tfd_cpp::SearchOptions(), 2);
+    ASSERT_EQ(2, decomposedResult.groups.size());
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, decomposedResult.results[1].status);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, decomposedResult.result.status);
+    ASSERT_EQ(1, decomposedResult.result.plan.size());
+    ASSERT_EQ((std::vector<std::size_t>{1, 1}), decomposedResult.result.taskBoundaries);
+}
@@ -0,0 +1,110 @@
+#include "fact_state.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+namespace {
+    // facts: 0 = door open, 1 = door locked, 100 = robot inside; fluent 0 = battery
+    tfd_cpp::FactOperator OpenDoor()
+    {
+        tfd_cpp::FactOperator openDoor;
+        openDoor.negativePreconditions = tfd_cpp::MakeFactMask({0, 1});
+        openDoor.addEffects = tfd_cpp::MakeFactMask({0});
+        return openDoor;
+    }
+
+    tfd_cpp::FactOperator Enter()
+    {
+        tfd_cpp::FactOperator enter;
+        enter.positivePreconditions = tfd_cpp::MakeFactMask({0});
+        enter.negativePreconditions = tfd_cpp::MakeFactMask({100});
+        enter.addEffects = tfd_cpp::MakeFactMask({100});
+        enter.fluentPreconditions.push_back({0, 5.0});
+        enter.fluentEffects.push_back({0, -5.0});
+        return enter;
+    }
+}
+
+TEST(FactStateTest, MakeFactMaskMergesWords)
+{
+    auto mask = tfd_cpp::MakeFactMask({65, 1, 0, 64});
+
+    ASSERT_EQ(2, mask.size());
+    ASSERT_EQ(0, mask[0].index);
+    ASSERT_EQ(0b11u, mask[0].bits);
+    ASSERT_EQ(1, mask[1].index);
+    ASSERT_EQ(0b11u, mask[1].bits);
+}
+
+TEST(FactStateTest, SatisfiesAndApply)
+{
+    tfd_cpp::FactState state(128, 1);
+    state.SetFluent(0, 7.0);
+
+    auto openDoor = OpenDoor();
+    auto enter = Enter();
+
+    ASSERT_TRUE(state.Satisfies(openDoor));
+    ASSERT_FALSE(state.Satisfies(enter));
+
+    state.Apply(openDoor);
+    ASSERT_TRUE(state.Test(0));
+    ASSERT_FALSE(state.Satisfies(openDoor));
+    ASSERT_TRUE(state.Satisfies(enter));
+
+    state.Apply(enter);
+    ASSERT_TRUE(state.Test(100));
+    ASSERT_DOUBLE_EQ(2.0, state.Fluent(0));
+
+    state.Set(100, false);
+    ASSERT_FALSE(state.Satisfies(enter));
+}
+
+TEST(FactStateTest, BatchMatchesSingleChecks)
+{
+    auto openDoor = OpenDoor();
+    auto enter = Enter();
+    tfd_cpp::FactOperator unconditional;
+    tfd_cpp::FactOperatorBatch batch({&openDoor, &enter, &unconditional});
+
+    tfd_cpp::FactState state(128, 1);
+    state.SetFluent(0, 10.0);
+    std::vector<std::uint8_t> applicable;
+
+    batch.Applicable(state, applicable);
+    ASSERT_EQ(3, applicable.size());
+    ASSERT_EQ(std::vector<std::uint8_t>({1, 0, 1}), applicable);
+
+    state.Set(0);
+    batch.Applicable(state, applicable);
+    ASSERT_EQ(std::vector<std::uint8_t>({0, 1, 1}), applicable);
+
+    state.SetFluent(0, 1.0);
+    batch.Applicable(state, applicable);
+    ASSERT_EQ(std::vector<std::uint8_t>({0, 0, 1}), applicable);
+}
+
+TEST(FactStateTest, PlanWithMaskOperators)
+{
+    auto openDoor = OpenDoor();
+    auto enter = Enter();
+
+    tfd_cpp::PlanningDomain planningDomain("Door");
+    planningDomain.AddOperator("OpenDoor", tfd_cpp::MakeOperatorFunction([&](const tfd_cpp::Parameters&) { return &openDoor; }));
+    planningDomain.AddOperator("Enter", tfd_cpp::MakeOperatorFunction([&](const tfd_cpp::Parameters&) { return &enter; }));
+    planningDomain.AddMethod("GetInside", [](const tfd_cpp::State&, const tfd_cpp::Parameters&) {
+        return std::optional<std::vector<tfd_cpp::Task>>({{"Enter", {}}, {"OpenDoor", {}}});
+    });
+
+    tfd_cpp::FactState factState(128, 1);
+    factState.SetFluent(0, 5.0);
+    tfd_cpp::State initialState{"Door", factState};
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"GetInside", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+    auto solutionPlan = tfd.TryToPlan();
+
+    ASSERT_EQ(2, solutionPlan.size());
+    ASSERT_EQ("OpenDoor", solutionPlan[0].task.taskName);
+    ASSERT_EQ("Enter", solutionPlan[1].task.taskName);
+}
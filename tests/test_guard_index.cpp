@@ -0,0 +1,166 @@
+#include "guard_index.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace {
+    // the state is a position on a line; a task's first parameter is a target position
+    std::optional<std::int64_t> Position(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::any_cast<int>(state.data);
+    }
+
+    std::optional<std::int64_t> Distance(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (parameters.empty())
+        {
+            return std::nullopt;
+        }
+        return std::abs(std::any_cast<int>(parameters[0]) - std::any_cast<int>(state.data));
+    }
+}
+
+struct GuardIndexTest : public ::testing::Test
+{
+    GuardIndexTest() :
+        state{"Line", 3}
+    {
+        guardIndex.AddField("position", Position);
+        guardIndex.AddField("distance", Distance);
+    }
+
+    ~GuardIndexTest() {}
+
+    tfd_cpp::GuardIndex guardIndex;
+    tfd_cpp::GuardSelection selection;
+    tfd_cpp::State state;
+};
+
+TEST_F(GuardIndexTest, SelectsByEqualityAndBounds)
+{
+    ASSERT_TRUE(guardIndex.Add(0, {{"position", tfd_cpp::GuardComparison::Equal, 3}}));
+    ASSERT_TRUE(guardIndex.Add(1, {{"position", tfd_cpp::GuardComparison::Equal, 4}}));
+    ASSERT_TRUE(guardIndex.Add(2, {}));
+    ASSERT_TRUE(guardIndex.Add(3, {{"position", tfd_cpp::GuardComparison::AtMost, 2}}));
+    ASSERT_TRUE(guardIndex.Add(4, {{"position", tfd_cpp::GuardComparison::AtMost, 3}}));
+    ASSERT_TRUE(guardIndex.Add(5, {{"position", tfd_cpp::GuardComparison::AtLeast, 3}}));
+    ASSERT_TRUE(guardIndex.Add(6, {{"position", tfd_cpp::GuardComparison::AtLeast, 4}}));
+
+    guardIndex.Select(state, {}, selection);
+    ASSERT_EQ((std::vector<std::size_t>{0, 2, 4, 5}), selection.alternatives);
+
+    state.data = 4;
+    guardIndex.Select(state, {}, selection);
+    ASSERT_EQ((std::vector<std::size_t>{1, 2, 5, 6}), selection.alternatives);
+}
+
+TEST_F(GuardIndexTest, ChecksEveryGuard)
+{
+    ASSERT_TRUE(guardIndex.Add(0, {{"position", tfd_cpp::GuardComparison::AtLeast, 0},
+                                   {"distance", tfd_cpp::GuardComparison::AtMost, 2}}));
+    ASSERT_TRUE(guardIndex.Add(1, {{"distance", tfd_cpp::GuardComparison::AtLeast, 3}}));
+
+    guardIndex.Select(state, {5}, selection);
+    ASSERT_EQ((std::vector<std::size_t>{0}), selection.alternatives);
+
+    guardIndex.Select(state, {9}, selection);
+    ASSERT_EQ((std::vector<std::size_t>{1}), selection.alternatives);
+
+    // the distance field does not exist without a target
+    guardIndex.Select(state, {}, selection);
+    ASSERT_TRUE(selection.alternatives.empty());
+}
+
+TEST_F(GuardIndexTest, EvaluatesEachFieldOnce)
+{
+    int evaluations = 0;
+    guardIndex.AddField("position", [&evaluations](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        ++evaluations;
+        return Position(state, parameters);
+    });
+    for (std::size_t alternative = 0; alternative < 8; ++alternative)
+    {
+        ASSERT_TRUE(guardIndex.Add(alternative, {{"position", tfd_cpp::GuardComparison::AtLeast, 0},
+                                                 {"position", tfd_cpp::GuardComparison::Equal, static_cast<std::int64_t>(alternative)}}));
+    }
+
+    guardIndex.Select(state, {}, selection);
+    ASSERT_EQ((std::vector<std::size_t>{3}), selection.alternatives);
+    ASSERT_EQ(1, evaluations);
+}
+
+TEST_F(GuardIndexTest, RejectsUnknownFields)
+{
+    ASSERT_FALSE(guardIndex.Add(0, {{"speed", tfd_cpp::GuardComparison::Equal, 1}}));
+}
+
+struct GuardedDomainTest : public ::testing::Test
+{
+    GuardedDomainTest() :
+        planningDomain("Line"),
+        calls(0)
+    {
+        planningDomain.AddGuardField("distance", Distance);
+        planningDomain.AddOperator("Step", [this](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+            ++calls;
+            const int target = std::any_cast<int>(parameters[0]);
+            const int position = std::any_cast<int>(state.data);
+            return std::optional<tfd_cpp::State>({"Line", position + (target > position ? 1 : -1)});
+        }, {{"distance", tfd_cpp::GuardComparison::AtLeast, 1}});
+        planningDomain.AddMethod("Reach", [this](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+            ++calls;
+            return std::optional<std::vector<tfd_cpp::Task>>(std::vector<tfd_cpp::Task>{});
+        }, {{"distance", tfd_cpp::GuardComparison::Equal, 0}});
+        planningDomain.AddMethod("Reach", [this](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+            ++calls;
+            return std::optional<std::vector<tfd_cpp::Task>>({{"Reach", parameters}, {"Step", parameters}});
+        }, {{"distance", tfd_cpp::GuardComparison::AtLeast, 1}});
+    }
+
+    ~GuardedDomainTest() {}
+
+    tfd_cpp::PlanningDomain planningDomain;
+    int calls;
+};
+
+TEST_F(GuardedDomainTest, SkipsMethodsWhoseGuardsFail)
+{
+    const auto methods = planningDomain.GetRelevantMethods({"Line", 3}, {"Reach", {3}});
+
+    ASSERT_TRUE(methods);
+    ASSERT_EQ(1, methods->size());
+    ASSERT_EQ(1, calls);
+    ASSERT_TRUE(planningDomain.GetApplicableOperators({"Line", 3}, {"Step", {3}})->empty());
+    ASSERT_EQ(1, calls);
+}
+
+TEST_F(GuardedDomainTest, RejectsGuardsOnUnknownFields)
+{
+    planningDomain.AddMethod("Fly", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        return std::optional<std::vector<tfd_cpp::Task>>(std::vector<tfd_cpp::Task>{});
+    }, {{"altitude", tfd_cpp::GuardComparison::AtLeast, 1}});
+
+    ASSERT_FALSE(planningDomain.TaskIsMethod("Fly"));
+    ASSERT_EQ(nullptr, planningDomain.FindMethodGuards("Fly"));
+    ASSERT_NE(nullptr, planningDomain.FindMethodGuards("Reach"));
+}
+
+TEST_F(GuardedDomainTest, SearchOnlyCallsMethodsWhoseGuardsHold)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"Line", 0}, {"Reach", {4}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    const auto plan = tfd.TryToPlan();
+    ASSERT_EQ(4, plan.size());
+    // one Reach method and one Step per position, and the Reach method at the goal
+    ASSERT_EQ(9, calls);
+
+    calls = 0;
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+    ASSERT_EQ(4, tfd.Search(options).plan.size());
+    ASSERT_EQ(9, calls);
+}
@@ -0,0 +1,207 @@
+#include "hddl_parser.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <string>
+
+namespace {
+    const std::string s_domain = R"(
+        ; Transport-like domain with a free variable in get-to
+        (define (domain delivery)
+          (:requirements :typing :hierarchy)
+          (:types truck - vehicle vehicle package - locatable location)
+          (:predicates (at ?x - locatable ?l - location)
+                       (road ?a ?b - location)
+                       (in ?p - package ?v - vehicle))
+
+          (:task deliver :parameters (?p - package ?l - location))
+          (:task get-to :parameters (?v - vehicle ?l - location))
+
+          (:method m-deliver
+            :parameters (?p - package ?from ?to - location ?v - vehicle)
+            :task (deliver ?p ?to)
+            :precondition (and (at ?p ?from))
+            :ordered-subtasks (and (t1 (get-to ?v ?from))
+                                   (t2 (pick-up ?v ?from ?p))
+                                   (t3 (get-to ?v ?to))
+                                   (t4 (drop ?v ?to ?p))))
+
+          (:method m-already-there
+            :parameters (?v - vehicle ?l - location)
+            :task (get-to ?v ?l)
+            :precondition (at ?v ?l)
+            :subtasks ())
+
+          (:method m-drive
+            :parameters (?v - vehicle ?from ?to - location)
+            :task (get-to ?v ?to)
+            :precondition (and (at ?v ?from) (not (= ?from ?to)))
+            :subtasks (and (t1 (drive ?v ?from ?to))))
+
+          (:action drive
+            :parameters (?v - vehicle ?from ?to - location)
+            :precondition (and (at ?v ?from) (road ?from ?to))
+            :effect (and (not (at ?v ?from)) (at ?v ?to)))
+
+          (:action pick-up
+            :parameters (?v - vehicle ?l - location ?p - package)
+            :precondition (and (at ?v ?l) (at ?p ?l))
+            :effect (and (not (at ?p ?l)) (in ?p ?v)))
+
+          (:action drop
+            :parameters (?v - vehicle ?l - location ?p - package)
+            :precondition (and (at ?v ?l) (in ?p ?v))
+            :effect (and (not (in ?p ?v)) (at ?p ?l))))
+    )";
+
+    const std::string s_problem = R"(
+        (define (problem deliver-one)
+          (:domain delivery)
+          (:objects depot city - location truck-0 - truck package-0 - package)
+          (:htn :parameters ()
+                :subtasks (and (task0 (deliver package-0 depot)))
+                :ordering ())
+          (:init (at truck-0 depot) (at package-0 city)
+                 (road depot city) (road city depot)))
+    )";
+}
+
+TEST(HddlParserTest, SymbolTableInterns)
+{
+    tfd_cpp::SymbolTable symbols;
+    auto first = symbols.Intern("truck");
+    auto second = symbols.Intern("package");
+
+    ASSERT_EQ(first, symbols.Intern("truck"));
+    ASSERT_NE(first, second);
+    ASSERT_EQ("package", symbols.NameOf(second));
+    ASSERT_EQ(std::nullopt, symbols.Find("location"));
+
+    tfd_cpp::SymbolTable copy(symbols);
+    ASSERT_EQ(second, copy.Find("package").value());
+}
+
+TEST(HddlParserTest, ParseDomainAndProblem)
+{
+    auto model = tfd_cpp::ParseHddl(s_domain, s_problem);
+
+    ASSERT_TRUE(model);
+    ASSERT_EQ("delivery", model->domainName);
+    ASSERT_EQ("deliver-one", model->problemName);
+    ASSERT_EQ(3, model->actions.size());
+    ASSERT_EQ(3, model->methods.size());
+    ASSERT_EQ(1, model->initialTaskNetwork.size());
+
+    // at: 2 locatables x 2 locations, road: 2 x 2, in: 1 x 1
+    ASSERT_EQ(9, model->factCount);
+
+    auto at = model->predicates.Find("at").value();
+    auto truck = model->objects.Find("truck-0").value();
+    auto depot = model->objects.Find("depot").value();
+    auto city = model->objects.Find("city").value();
+    ASSERT_TRUE(model->initialState.Test(model->FactOf(at, {truck, depot}).value()));
+    ASSERT_FALSE(model->initialState.Test(model->FactOf(at, {truck, city}).value()));
+    ASSERT_EQ(std::nullopt, model->FactOf(at, {depot, city}));
+}
+
+TEST(HddlParserTest, RejectsMalformedInput)
+{
+    ASSERT_FALSE(tfd_cpp::ParseHddl("(define (domain broken)", s_problem));
+    ASSERT_FALSE(tfd_cpp::ParseHddl(s_domain, "(define (problem p) (:domain delivery) (:init (flying truck-0)))"));
+    ASSERT_FALSE(tfd_cpp::ParseHddl(s_domain, "(define (problem p) (:domain delivery) (:init (at nowhere depot)))"));
+}
+
+TEST(HddlParserTest, PartialOrderIsLinearizedInDeclarationOrder)
+{
+    const std::string problem = R"(
+        (define (problem deliver-around)
+          (:domain delivery)
+          (:objects depot city - location truck-0 - truck package-0 - package)
+          (:htn :parameters ()
+                :subtasks (and (task0 (deliver package-0 depot))
+                               (task1 (deliver package-0 city))
+                               (task2 (deliver package-0 depot)))
+                :ordering (and (< task2 task0)))
+          (:init (at truck-0 depot) (at package-0 city)
+                 (road depot city) (road city depot)))
+    )";
+
+    auto model = tfd_cpp::ParseHddl(s_domain, problem);
+    ASSERT_TRUE(model);
+    ASSERT_EQ(3, model->initialTaskNetwork.size());
+
+    // task1 and task2 are both ready first and keep their order; task0 waits for task2
+    auto city = model->objects.Find("city").value();
+    ASSERT_EQ(city, model->initialTaskNetwork[0].arguments[1].index);
+
+    std::string cyclic = problem;
+    cyclic.replace(cyclic.find("(< task2 task0)"), 15, "(< task2 task0) (< task0 task2)");
+    ASSERT_FALSE(tfd_cpp::ParseHddl(s_domain, cyclic));
+}
+
+TEST(HddlParserTest, PlanWithCompiledDomain)
+{
+    auto model = tfd_cpp::ParseHddl(s_domain, s_problem);
+    ASSERT_TRUE(model);
+
+    tfd_cpp::TFD tfd(tfd_cpp::CreatePlanningProblem(model));
+    auto solutionPlan = tfd.TryToPlan();
+
+    ASSERT_EQ(4, solutionPlan.size());
+    ASSERT_EQ("(drive truck-0 depot city)", model->ToString(solutionPlan[0].task));
+    ASSERT_EQ("(pick-up truck-0 city package-0)", model->ToString(solutionPlan[1].task));
+    ASSERT_EQ("(drive truck-0 city depot)", model->ToString(solutionPlan[2].task));
+    ASSERT_EQ("(drop truck-0 depot package-0)", model->ToString(solutionPlan[3].task));
+}
+
+TEST(HddlParserTest, InterchangeableTrucksAreTriedOnce)
+{
+    // the package sits on an island no truck can reach
+    const std::string problem = R"(
+        (define (problem deliver-from-island)
+          (:domain delivery)
+          (:objects depot city island - location truck-0 truck-1 truck-2 truck-3 - truck package-0 - package)
+          (:htn :parameters ()
+                :subtasks (and (task0 (deliver package-0 depot)))
+                :ordering ())
+          (:init (at truck-0 depot) (at truck-1 depot) (at truck-2 depot) (at truck-3 city) (at package-0 island)
+                 (road depot city) (road city depot)))
+    )";
+    auto model = tfd_cpp::ParseHddl(s_domain, problem);
+    ASSERT_TRUE(model);
+
+    auto planningProblem = tfd_cpp::CreatePlanningProblem(model);
+    auto result = tfd_cpp::TFD(planningProblem).Search(tfd_cpp::SearchOptions());
+
+    auto planningDomain = tfd_cpp::CreatePlanningDomain(model);
+    planningDomain.SetObjectSignatureFunction(nullptr);
+    tfd_cpp::PlanningProblem unreducedProblem(planningDomain, planningProblem.GetInitialState(), planningProblem.GetTopLevelTask());
+    auto unreducedResult = tfd_cpp::TFD(unreducedProblem).Search(tfd_cpp::SearchOptions());
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, result.status);
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, unreducedResult.status);
+    // truck-3 is elsewhere, so two of the four trucks are tried
+    ASSERT_LT(result.nodesExpanded, unreducedResult.nodesExpanded);
+}
+
+TEST(HddlParserTest, SymmetryKeepsPlans)
+{
+    const std::string problem = R"(
+        (define (problem deliver-with-fleet)
+          (:domain delivery)
+          (:objects depot city - location truck-0 truck-1 truck-2 - truck package-0 - package)
+          (:htn :parameters ()
+                :subtasks (and (task0 (deliver package-0 depot)))
+                :ordering ())
+          (:init (at truck-0 depot) (at truck-1 depot) (at truck-2 depot) (at package-0 city)
+                 (road depot city) (road city depot)))
+    )";
+    auto model = tfd_cpp::ParseHddl(s_domain, problem);
+    ASSERT_TRUE(model);
+
+    tfd_cpp::TFD tfd(tfd_cpp::CreatePlanningProblem(model));
+    auto solutionPlan = tfd.TryToPlan();
+
+    ASSERT_EQ(4, solutionPlan.size());
+    ASSERT_EQ("(drive truck-0 depot city)", model->ToString(solutionPlan[0].task));
+    ASSERT_EQ("(drop truck-0 depot package-0)", model->ToString(solutionPlan[3].task));
+}
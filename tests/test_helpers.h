@@ -0,0 +1,32 @@
+// Domain Functions Shared by the Tests
+#pragma once
+
+#include "planning_domain.h"
+
+#include <any>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tfd_cpp_test
+{
+    // A method that always decomposes into the given subtasks.
+    inline tfd_cpp::MethodFunction Decompose(const std::vector<tfd_cpp::Task>& subtasks)
+    {
+        return [subtasks](const tfd_cpp::State&, const tfd_cpp::Parameters&) {
+            return std::optional<std::vector<tfd_cpp::Task>>(subtasks);
+        };
+    }
+
+    // Footprints of tasks whose first parameter names a counter, which they read and write or only read.
+    inline tfd_cpp::Footprint CounterFootprint(const tfd_cpp::State&, const tfd_cpp::Parameters& parameters)
+    {
+        const auto counter = "counter:" + std::any_cast<std::string>(parameters[0]);
+        return {{counter}, {counter}};
+    }
+
+    inline tfd_cpp::Footprint ReadFootprint(const tfd_cpp::State&, const tfd_cpp::Parameters& parameters)
+    {
+        return {{"counter:" + std::any_cast<std::string>(parameters[0])}, {}};
+    }
+}
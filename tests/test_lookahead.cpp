@@ -0,0 +1,195 @@
+#include "lookahead.h"
+#include "test_helpers.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+    using tfd_cpp_test::CounterFootprint;
+    using tfd_cpp_test::Decompose;
+    using tfd_cpp_test::ReadFootprint;
+    using Counters = std::map<std::string, int>;
+
+    int Value(const tfd_cpp::State& state, const std::any& name)
+    {
+        const auto& counters = std::any_cast<const Counters&>(state.data);
+        const auto counter = counters.find(std::any_cast<std::string>(name));
+        return counter == counters.end() ? 0 : counter->second;
+    }
+
+    std::optional<tfd_cpp::State> Bump(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        tfd_cpp::State newState(state);
+        ++std::any_cast<Counters&>(newState.data)[std::any_cast<std::string>(parameters[0])];
+        return newState;
+    }
+
+    // applicable where its guard says, never rejects a state itself
+    std::optional<tfd_cpp::State> Open(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return state;
+    }
+
+    // unguarded, so only applying it tells where it does not apply
+    std::optional<tfd_cpp::State> Close(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (Value(state, parameters[0]) < 1)
+        {
+            return std::nullopt;
+        }
+        return state;
+    }
+
+    // Wander(name, depth) bumps the counter or not at every level, so it has 2^depth decompositions
+    std::optional<std::vector<tfd_cpp::Task>> WanderOn(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        const auto depth = std::any_cast<int>(parameters[1]);
+        if (depth == 0)
+        {
+            return std::vector<tfd_cpp::Task>();
+        }
+        return std::vector<tfd_cpp::Task>{{"Wander", {parameters[0], depth - 1}}, {"Bump", {parameters[0]}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> WanderOff(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        const auto depth = std::any_cast<int>(parameters[1]);
+        if (depth == 0)
+        {
+            return std::nullopt;
+        }
+        return std::vector<tfd_cpp::Task>{{"Wander", {parameters[0], depth - 1}}};
+    }
+
+    tfd_cpp::Task Counter(const std::string& taskName, const std::string& name)
+    {
+        return {taskName, {name}};
+    }
+
+    tfd_cpp::Task Wander(const std::string& name, int depth)
+    {
+        return {"Wander", {name, depth}};
+    }
+
+    std::vector<std::string> TaskNames(const tfd_cpp::Plan& plan)
+    {
+        std::vector<std::string> taskNames;
+        for (const auto& step : plan)
+        {
+            taskNames.push_back(step.task.taskName);
+        }
+        return taskNames;
+    }
+}
+
+struct LookaheadTest : public ::testing::Test
+{
+    LookaheadTest() :
+        planningDomain("Lookahead"),
+        initialState{"Lookahead", Counters{{"c", 1}}}
+    {
+        planningDomain.AddGuardField("value", [](const tfd_cpp::State& state, const std::vector<std::any>& parameters) {
+            return std::optional<std::int64_t>(Value(state, parameters[0]));
+        });
+        planningDomain.AddOperator("Bump", Bump);
+        planningDomain.AddOperator("Open", Open, {{"value", tfd_cpp::GuardComparison::AtLeast, 1}});
+        planningDomain.AddMethod("Wander", WanderOn);
+        planningDomain.AddMethod("Wander", WanderOff);
+        planningDomain.SetTaskFootprint("Bump", CounterFootprint);
+        planningDomain.SetTaskFootprint("Open", ReadFootprint);
+        planningDomain.SetTaskFootprint("Wander", CounterFootprint);
+    }
+
+    ~LookaheadTest() {}
+
+    tfd_cpp::SearchResult Search(const std::string& taskName, tfd_cpp::Lookahead lookahead,
+                                 tfd_cpp::SearchStrategy strategy = tfd_cpp::SearchStrategy::DepthFirst) const
+    {
+        tfd_cpp::TFD tfd(tfd_cpp::PlanningProblem(planningDomain, initialState, tfd_cpp::Task{taskName, {}}));
+        tfd_cpp::SearchOptions options;
+        options.lookahead = lookahead;
+        options.strategy = strategy;
+        return tfd.Search(options);
+    }
+
+    tfd_cpp::PlanningDomain planningDomain;
+    tfd_cpp::State initialState;
+};
+
+TEST_F(LookaheadTest, PrunesMethodsWhoseFirstSubtaskDoesNotApply)
+{
+    // the last subtask runs first
+    planningDomain.AddMethod("Knock", Decompose({Wander("b", 6), Counter("Open", "a")}));
+    planningDomain.AddMethod("Knock", Decompose({Counter("Open", "c")}));
+
+    const auto unchecked = Search("Knock", tfd_cpp::Lookahead::None);
+    const auto checked = Search("Knock", tfd_cpp::Lookahead::FirstSubtask);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, checked.status);
+    ASSERT_EQ(TaskNames(unchecked.plan), TaskNames(checked.plan));
+    ASSERT_LT(checked.nodesExpanded, unchecked.nodesExpanded);
+}
+
+TEST_F(LookaheadTest, AppliesUnguardedOperatorsOfTheFirstSubtask)
+{
+    planningDomain.AddOperator("Close", Close);
+    planningDomain.AddMethod("Leave", Decompose({Wander("b", 6), Counter("Close", "a")}));
+    planningDomain.AddMethod("Leave", Decompose({Counter("Close", "c")}));
+
+    const auto unchecked = Search("Leave", tfd_cpp::Lookahead::None);
+    const auto checked = Search("Leave", tfd_cpp::Lookahead::FirstSubtask);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, checked.status);
+    ASSERT_EQ(TaskNames(unchecked.plan), TaskNames(checked.plan));
+    ASSERT_LT(checked.nodesExpanded, unchecked.nodesExpanded);
+}
+
+TEST_F(LookaheadTest, ChecksLaterSubtasksThatNothingBeforeThemChanges)
+{
+    // Open(a) fails only after every decomposition of Wander(b) has been tried
+    planningDomain.AddMethod("Enter", Decompose({Counter("Open", "a"), Wander("b", 6)}));
+    planningDomain.AddMethod("Enter", Decompose({Counter("Open", "c")}));
+
+    const auto unchecked = Search("Enter", tfd_cpp::Lookahead::None);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, unchecked.status);
+    ASSERT_EQ(std::vector<std::string>{"Open"}, TaskNames(unchecked.plan));
+
+    // Wander runs first, so only the independent lookahead sees that Open(a) cannot apply
+    ASSERT_EQ(unchecked.nodesExpanded, Search("Enter", tfd_cpp::Lookahead::FirstSubtask).nodesExpanded);
+    const auto checked = Search("Enter", tfd_cpp::Lookahead::Independent);
+    ASSERT_EQ(TaskNames(unchecked.plan), TaskNames(checked.plan));
+    ASSERT_LT(checked.nodesExpanded * 10, unchecked.nodesExpanded);
+
+    const auto greedy = Search("Enter", tfd_cpp::Lookahead::Independent, tfd_cpp::SearchStrategy::GreedyBestFirst);
+    ASSERT_EQ(TaskNames(unchecked.plan), TaskNames(greedy.plan));
+    ASSERT_LE(greedy.nodesExpanded, Search("Enter", tfd_cpp::Lookahead::None, tfd_cpp::SearchStrategy::GreedyBestFirst).nodesExpanded);
+}
+
+TEST_F(LookaheadTest, SubtasksThatMayBeChangedAreNotChecked)
+{
+    // Bump(a) writes what Open(a) reads; Prepare has no footprint, so it may write anything
+    planningDomain.AddMethod("Unlock", Decompose({Counter("Open", "a"), Counter("Bump", "a")}));
+    planningDomain.AddOperator("Prepare", Bump);
+    planningDomain.AddMethod("Sneak", Decompose({Counter("Open", "a"), Counter("Prepare", "a")}));
+
+    for (const auto& taskName : {"Unlock", "Sneak"})
+    {
+        const auto result = Search(taskName, tfd_cpp::Lookahead::Independent);
+        ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+        ASSERT_EQ(2, result.plan.size());
+    }
+}
+
+TEST_F(LookaheadTest, PrunesSubtasksWithoutOperatorsOrMethods)
+{
+    planningDomain.AddMethod("Lost", Decompose({Counter("Missing", "a"), Wander("b", 6)}));
+    planningDomain.AddMethod("Lost", Decompose({Counter("Open", "c")}));
+
+    const auto unchecked = Search("Lost", tfd_cpp::Lookahead::None);
+    const auto checked = Search("Lost", tfd_cpp::Lookahead::Independent);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, checked.status);
+    ASSERT_EQ(TaskNames(unchecked.plan), TaskNames(checked.plan));
+    ASSERT_LT(checked.nodesExpanded * 10, unchecked.nodesExpanded);
+}
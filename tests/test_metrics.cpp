@@ -0,0 +1,176 @@
+#include "metrics.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::optional<tfd_cpp::State> Operator(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return state;
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Method(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"TestOperator", {}}};
+    }
+
+    bool Contains(const std::string& text, const std::string& line)
+    {
+        return text.find(line + "\n") != std::string::npos;
+    }
+}
+
+TEST(MetricsTest, CounterIncrements)
+{
+    tfd_cpp::MetricsRegistry registry;
+    auto counter = registry.GetCounter("test_total", "Test counter.");
+
+    ASSERT_NE(nullptr, counter);
+    counter->Increment();
+    counter->Increment(4);
+    ASSERT_EQ(5, counter->Value());
+    ASSERT_EQ(counter, registry.GetCounter("test_total", "Test counter."));
+    ASSERT_NE(counter, registry.GetCounter("test_total", "Test counter.", {{"kind", "other"}}));
+}
+
+TEST(MetricsTest, HistogramBuckets)
+{
+    tfd_cpp::Histogram histogram({1.0, 2.0, 4.0});
+
+    histogram.Observe(0.5);
+    histogram.Observe(1.0);
+    histogram.Observe(3.0);
+    histogram.Observe(10.0);
+
+    ASSERT_EQ((std::vector<std::uint64_t>{2, 0, 1, 1}), histogram.BucketCounts());
+    ASSERT_EQ(4, histogram.Count());
+    ASSERT_DOUBLE_EQ(14.5, histogram.Sum());
+    ASSERT_EQ((std::vector<double>{1.0, 10.0, 100.0}), tfd_cpp::ExponentialBuckets(1.0, 10.0, 3));
+}
+
+TEST(MetricsTest, ConcurrentObservations)
+{
+    tfd_cpp::Histogram histogram(tfd_cpp::ExponentialBuckets(1.0, 2.0, 8));
+    tfd_cpp::Counter counter;
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; ++thread)
+    {
+        threads.emplace_back([&histogram, &counter]() {
+            for (int observation = 0; observation < 10000; ++observation)
+            {
+                histogram.Observe(observation % 300);
+                counter.Increment();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(40000, histogram.Count());
+    ASSERT_EQ(40000, counter.Value());
+}
+
+TEST(MetricsTest, RejectsInvalidAndConflictingNames)
+{
+    tfd_cpp::MetricsRegistry registry;
+
+    ASSERT_EQ(nullptr, registry.GetCounter("0_total", "Starts with a digit."));
+    ASSERT_EQ(nullptr, registry.GetCounter("test-total", "Has a dash."));
+    ASSERT_NE(nullptr, registry.GetCounter("test_total", "Test counter."));
+    ASSERT_EQ(nullptr, registry.GetHistogram("test_total", "Test counter.", {1.0}));
+}
+
+TEST(MetricsTest, RendersTextExposition)
+{
+    tfd_cpp::MetricsRegistry registry;
+    registry.GetCounter("requests_total", "Requests\nserved.", {{"path", "a\"b"}})->Increment(3);
+    auto histogram = registry.GetHistogram("latency_seconds", "Latency.", {0.5, 1.0});
+    histogram->Observe(0.25);
+    histogram->Observe(2.0);
+
+    const auto text = registry.Render();
+
+    ASSERT_TRUE(Contains(text, "# HELP requests_total Requests\\nserved."));
+    ASSERT_TRUE(Contains(text, "# TYPE requests_total counter"));
+    ASSERT_TRUE(Contains(text, "requests_total{path=\"a\\\"b\"} 3"));
+    ASSERT_TRUE(Contains(text, "# TYPE latency_seconds histogram"));
+    ASSERT_TRUE(Contains(text, "latency_seconds_bucket{le=\"0.5\"} 1"));
+    ASSERT_TRUE(Contains(text, "latency_seconds_bucket{le=\"1\"} 1"));
+    ASSERT_TRUE(Contains(text, "latency_seconds_bucket{le=\"+Inf\"} 2"));
+    ASSERT_TRUE(Contains(text, "latency_seconds_sum 2.25"));
+    ASSERT_TRUE(Contains(text, "latency_seconds_count 2"));
+}
+
+TEST(MetricsTest, WritesFile)
+{
+    tfd_cpp::MetricsRegistry registry;
+    registry.GetCounter("test_total", "Test counter.")->Increment();
+    const std::string path = "test_metrics.prom";
+
+    ASSERT_TRUE(registry.WriteToFile(path));
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    ASSERT_EQ(registry.Render(), contents.str());
+    std::remove(path.c_str());
+
+    ASSERT_FALSE(registry.WriteToFile("no_such_directory/test_metrics.prom"));
+}
+
+TEST(MetricsTest, RecordsSearches)
+{
+    tfd_cpp::PlanningDomain planningDomain("TestDomain");
+    planningDomain.AddOperator("TestOperator", Operator);
+    planningDomain.AddMethod("TestMethod", Method);
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"TestDomain", 0}, {"TestMethod", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::MetricsRegistry registry;
+    tfd_cpp::PlannerMetrics metrics(registry);
+    tfd_cpp::SearchOptions options;
+    options.metrics = &metrics;
+
+    tfd.Search(options);
+    options.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+    tfd.Search(options);
+
+    ASSERT_EQ(2, registry.GetCounter("tfd_searches_total", "", {{"status", "solved"}})->Value());
+    ASSERT_EQ(0, registry.GetCounter("tfd_searches_total", "", {{"status", "no_plan"}})->Value());
+    ASSERT_EQ(2, metrics.CallbackDuration("TestMethod")->Count());
+    ASSERT_EQ(2, metrics.CallbackDuration("TestOperator")->Count());
+
+    const auto text = registry.Render();
+    ASSERT_TRUE(Contains(text, "tfd_search_duration_seconds_count 2"));
+    ASSERT_TRUE(Contains(text, "tfd_search_nodes_expanded_count 2"));
+    ASSERT_TRUE(Contains(text, "tfd_callback_duration_seconds_count{task=\"TestMethod\"} 2"));
+}
+
+TEST(MetricsTest, SkipsMetricsTheRegistryHoldsAsAnotherType)
+{
+    tfd_cpp::PlanningDomain planningDomain("TestDomain");
+    planningDomain.AddOperator("TestOperator", Operator);
+    planningDomain.AddMethod("TestMethod", Method);
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"TestDomain", 0}, {"TestMethod", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    // a service that registered the planner's names for metrics of its own
+    tfd_cpp::MetricsRegistry registry;
+    registry.GetCounter("tfd_search_duration_seconds", "Taken.")->Increment();
+    registry.GetCounter("tfd_callback_duration_seconds", "Taken.", {{"task", "TestMethod"}})->Increment();
+    registry.GetHistogram("tfd_searches_total", "Taken.", {1.0});
+    tfd_cpp::PlannerMetrics metrics(registry);
+    tfd_cpp::SearchOptions options;
+    options.metrics = &metrics;
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, tfd.Search(options).status);
+    ASSERT_EQ(nullptr, metrics.CallbackDuration("TestMethod"));
+    ASSERT_TRUE(Contains(registry.Render(), "tfd_search_nodes_expanded_count 1"));
+}
@@ -0,0 +1,89 @@
+#include "plan_schedule.h"
+#include "gtest/gtest.h"
+#include <optional>
+#include <any>
+#include <string>
+
+namespace {
+    std::optional<tfd_cpp::State> Operator(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return state;
+    }
+
+    tfd_cpp::Footprint Move(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        const auto location = "location:" + std::any_cast<std::string>(parameters[0]);
+        return {{location}, {location}};
+    }
+
+    tfd_cpp::Footprint Look(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return {{"location:" + std::any_cast<std::string>(parameters[0])}, {}};
+    }
+
+    tfd_cpp::OperatorWithParams Step(const std::string& taskName, const std::string& agent)
+    {
+        return tfd_cpp::OperatorWithParams({taskName, {agent}}, Operator);
+    }
+}
+
+struct PlanScheduleTest : public ::testing::Test
+{
+    PlanScheduleTest() :
+        planningDomain("TestDomain"),
+        initialState{"TestDomain", false}
+    {
+        planningDomain.AddOperator("Move", Operator);
+        planningDomain.AddOperator("Look", Operator);
+        planningDomain.AddOperator("Unknown", Operator);
+        planningDomain.SetTaskFootprint("Move", Move);
+        planningDomain.SetTaskFootprint("Look", Look);
+    }
+
+    tfd_cpp::PlanningDomain planningDomain;
+    tfd_cpp::State initialState;
+};
+
+TEST_F(PlanScheduleTest, IndependentAgentsRunInParallel)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Top", {}});
+    tfd_cpp::Plan plan{Step("Move", "a"), Step("Move", "b"), Step("Move", "a"), Step("Move", "b"), Step("Move", "c")};
+
+    auto schedule = tfd_cpp::DeorderPlan(planningProblem, plan);
+
+    ASSERT_TRUE(schedule);
+    ASSERT_EQ(2, schedule.value().levels.size());
+    ASSERT_EQ(std::vector<std::size_t>({0, 1, 4}), schedule.value().levels[0]);
+    ASSERT_EQ(std::vector<std::size_t>({2, 3}), schedule.value().levels[1]);
+    ASSERT_EQ(std::vector<std::size_t>({0}), schedule.value().predecessors[2]);
+    ASSERT_DOUBLE_EQ(2.0, schedule.value().criticalPathLength);
+}
+
+TEST_F(PlanScheduleTest, ReadersShareALevel)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Top", {}});
+    tfd_cpp::Plan plan{Step("Move", "a"), Step("Look", "a"), Step("Look", "a"), Step("Move", "a")};
+
+    auto schedule = tfd_cpp::DeorderPlan(planningProblem, plan, [](const tfd_cpp::OperatorWithParams& step) {
+        return step.task.taskName == "Move" ? 3.0 : 1.0;
+    });
+
+    ASSERT_TRUE(schedule);
+    ASSERT_EQ(3, schedule.value().levels.size());
+    ASSERT_EQ(std::vector<std::size_t>({1, 2}), schedule.value().levels[1]);
+    ASSERT_EQ(std::vector<std::size_t>({0, 1, 2}), schedule.value().predecessors[3]);
+    ASSERT_DOUBLE_EQ(7.0, schedule.value().criticalPathLength);
+}
+
+TEST_F(PlanScheduleTest, UndeclaredStepsAreBarriers)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Top", {}});
+    tfd_cpp::Plan plan{Step("Move", "a"), Step("Move", "b"), Step("Unknown", "a"), Step("Move", "c")};
+
+    auto schedule = tfd_cpp::DeorderPlan(planningProblem, plan);
+
+    ASSERT_TRUE(schedule);
+    ASSERT_EQ(3, schedule.value().levels.size());
+    ASSERT_EQ(std::vector<std::size_t>({0, 1}), schedule.value().predecessors[2]);
+    ASSERT_EQ(std::vector<std::size_t>({2}), schedule.value().predecessors[3]);
+}
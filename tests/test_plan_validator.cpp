@@ -0,0 +1,145 @@
+#include "plan_validator.h"
+#include "trail.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <atomic>
+#include <optional>
+#include <vector>
+
+namespace {
+    // counts its copies, to tell the in-place mode from the copying one
+    struct Counter
+    {
+        Counter(int value) : value(value) {}
+        Counter(const Counter& other) : value(other.value) { ++copies; }
+        Counter& operator=(const Counter& other) = default;
+
+        int value;
+        static std::atomic<int> copies;
+    };
+    std::atomic<int> Counter::copies(0);
+
+    int& Value(tfd_cpp::State& state)
+    {
+        return std::any_cast<Counter&>(state.data).value;
+    }
+
+    // changes the state before it finds out it is not applicable
+    bool AddBelowLimit(tfd_cpp::State& state, const tfd_cpp::Parameters& parameters, tfd_cpp::Trail& trail)
+    {
+        trail.Save(Value(state));
+        Value(state) += std::any_cast<int>(parameters[0]);
+        return Value(state) < 10;
+    }
+
+    double AddCost(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::any_cast<int>(parameters[0]);
+    }
+
+    tfd_cpp::Plan AddPlan(const tfd_cpp::PlanningProblem& planningProblem, const std::vector<int>& amounts)
+    {
+        const auto& add = planningProblem.FindOperators("Add")->front();
+        tfd_cpp::Plan plan;
+        for (const auto amount : amounts)
+        {
+            plan.emplace_back(tfd_cpp::Task{"Add", {amount}}, add);
+        }
+        return plan;
+    }
+}
+
+struct PlanValidatorTest : public ::testing::Test
+{
+    PlanValidatorTest() :
+        planningDomain(CreatePlanningDomain()),
+        planningProblem(planningDomain, {"Counter", Counter(0)}, {"Add", {1}})
+    {
+    }
+
+    ~PlanValidatorTest() {}
+
+    static tfd_cpp::PlanningDomain CreatePlanningDomain()
+    {
+        tfd_cpp::PlanningDomain planningDomain("Counter");
+        planningDomain.AddInPlaceOperator("Add", AddBelowLimit);
+        planningDomain.SetOperatorCost("Add", AddCost);
+        return planningDomain;
+    }
+
+    tfd_cpp::PlanningDomain planningDomain;
+    tfd_cpp::PlanningProblem planningProblem;
+};
+
+TEST_F(PlanValidatorTest, ValidPlansReportCostAndFinalState)
+{
+    for (const bool inPlace : {false, true})
+    {
+        tfd_cpp::ValidationOptions options;
+        options.inPlace = inPlace;
+        options.keepFinalState = true;
+        const auto validation = tfd_cpp::ValidatePlan(planningProblem, {"Counter", Counter(2)}, AddPlan(planningProblem, {1, 2, 3}), options);
+
+        ASSERT_TRUE(validation.valid);
+        ASSERT_EQ(3, validation.stepsApplied);
+        ASSERT_EQ(6.0, validation.cost);
+        ASSERT_TRUE(validation.finalState);
+        ASSERT_EQ(8, std::any_cast<Counter>(validation.finalState->data).value);
+    }
+}
+
+TEST_F(PlanValidatorTest, ReportsTheFirstFailingStep)
+{
+    for (const bool inPlace : {false, true})
+    {
+        tfd_cpp::ValidationOptions options;
+        options.inPlace = inPlace;
+        options.keepFinalState = true;
+        const auto validation = tfd_cpp::ValidatePlan(planningProblem, {"Counter", Counter(0)}, AddPlan(planningProblem, {4, 4, 4, 1}), options);
+
+        ASSERT_FALSE(validation.valid);
+        ASSERT_EQ(2, validation.stepsApplied);
+        ASSERT_EQ(8.0, validation.cost);
+        // the failed step's own changes are rolled back
+        ASSERT_EQ(8, std::any_cast<Counter>(validation.finalState->data).value);
+    }
+}
+
+TEST_F(PlanValidatorTest, InPlaceModeCopiesTheStateOnce)
+{
+    const auto plan = AddPlan(planningProblem, std::vector<int>(9, 1));
+    const tfd_cpp::State initialState{"Counter", Counter(0)};
+    tfd_cpp::ValidationOptions options;
+
+    Counter::copies = 0;
+    ASSERT_TRUE(tfd_cpp::ValidatePlan(planningProblem, initialState, plan, options).valid);
+    ASSERT_GE(Counter::copies, 9);
+
+    options.inPlace = true;
+    Counter::copies = 0;
+    ASSERT_TRUE(tfd_cpp::ValidatePlan(planningProblem, initialState, plan, options).valid);
+    ASSERT_EQ(1, Counter::copies);
+}
+
+TEST_F(PlanValidatorTest, BatchesMatchSinglePlans)
+{
+    std::vector<tfd_cpp::Plan> plans;
+    for (int plan = 0; plan < 200; ++plan)
+    {
+        plans.push_back(AddPlan(planningProblem, std::vector<int>(plan % 12, 1)));
+    }
+    const tfd_cpp::State initialState{"Counter", Counter(0)};
+    tfd_cpp::ValidationOptions options;
+    options.inPlace = true;
+    options.threads = 4;
+
+    const auto validations = tfd_cpp::ValidatePlans(planningProblem, initialState, plans, options);
+    ASSERT_EQ(plans.size(), validations.size());
+    for (std::size_t plan = 0; plan < plans.size(); ++plan)
+    {
+        const auto single = tfd_cpp::ValidatePlan(planningProblem, initialState, plans[plan]);
+        ASSERT_EQ(single.valid, validations[plan].valid);
+        ASSERT_EQ(single.stepsApplied, validations[plan].stepsApplied);
+        ASSERT_EQ(plans[plan].size() < 10, validations[plan].valid);
+    }
+}
@@ -156,6 +156,67 @@ TEST_F(PlanningDomainTest, TaskIsMethod)
     ASSERT_FALSE(isMethod);
 }
 
+TEST_F(PlanningDomainTest, HashState)
+{
+    tfd_cpp::State state;
+    state.domainName = "TestDomain";
+    state.data = internalState;
+
+    ASSERT_EQ(std::nullopt, planningDomain.HashState(state));
+
+    planningDomain.SetStateHashFunction([](const tfd_cpp::State& state) { return std::any_cast<bool>(state.data) ? 1 : 2; });
+    ASSERT_EQ(2, planningDomain.HashState(state).value());
+}
+
+TEST_F(PlanningDomainTest, TypedOperatorReceivesArguments)
+{
+    tfd_cpp::State state{"TestDomain", 0};
+
+    planningDomain.AddOperator("Add", tfd_cpp::Signature<std::string, int>(),
+                               [](const tfd_cpp::State& state, const std::string& name, const int& amount) -> std::optional<tfd_cpp::State>
+    {
+        if (name != "counter")
+        {
+            return std::nullopt;
+        }
+        return tfd_cpp::State{state.domainName, std::any_cast<int>(state.data) + amount};
+    });
+
+    auto applicableOperators = planningDomain.GetApplicableOperators(state, {"Add", {std::string("counter"), 3}});
+    ASSERT_EQ(1, applicableOperators.value().size());
+    auto successor = applicableOperators.value()[0].func(state, {std::string("counter"), 3});
+    ASSERT_EQ(3, std::any_cast<int>(successor.value().data));
+
+    // mismatched parameters make the operator inapplicable instead of throwing
+    applicableOperators = planningDomain.GetApplicableOperators(state, {"Add", {std::string("counter"), 3.0}});
+    ASSERT_TRUE(applicableOperators.value().empty());
+    applicableOperators = planningDomain.GetApplicableOperators(state, {"Add", {std::string("counter")}});
+    ASSERT_TRUE(applicableOperators.value().empty());
+}
+
+TEST_F(PlanningDomainTest, CheckTaskAgainstSignature)
+{
+    planningDomain.AddMethod("Count", tfd_cpp::Signature<int>(),
+                             [](const tfd_cpp::State&, const int&) { return std::optional<std::vector<tfd_cpp::Task>>(); });
+
+    ASSERT_TRUE(planningDomain.HasSignatures());
+    ASSERT_TRUE(planningDomain.CheckTask({"Count", {1}}));
+    ASSERT_FALSE(planningDomain.CheckTask({"Count", {true}}));
+    ASSERT_FALSE(planningDomain.CheckTask({"Count", {}}));
+    // tasks without a signature are not checked
+    ASSERT_TRUE(planningDomain.CheckTask({"Other", {true}}));
+}
+
+TEST_F(PlanningDomainTest, StateSize)
+{
+    tfd_cpp::State state{"", internalState};
+
+    ASSERT_EQ(sizeof(tfd_cpp::State) + state.domainName.capacity(), planningDomain.StateSize(state));
+
+    planningDomain.SetStateSizeFunction([](const tfd_cpp::State&) { return std::size_t(100); });
+    ASSERT_EQ(sizeof(tfd_cpp::State) + state.domainName.capacity() + 100, planningDomain.StateSize(state));
+}
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -120,3 +120,14 @@ TEST_F(PlanningProblemTest, GetTopLevelTask)
     ASSERT_EQ(topLevelTask.taskName, planningProblem.GetTopLevelTask().taskName);
     ASSERT_EQ(topLevelTask.parameters.size(), planningProblem.GetTopLevelTask().parameters.size());
 }
+
+TEST_F(PlanningProblemTest, GetTopLevelTasks)
+{
+    planningDomain.AddMethod("TestMethod", Method);
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, tfd_cpp::TaskNetwork{{topLevelTask, {"Other", {true}}}});
+
+    ASSERT_EQ(2, planningProblem.GetTopLevelTasks().size());
+    ASSERT_EQ("TestMethod", planningProblem.GetTopLevelTask().taskName);
+    ASSERT_EQ("Other", planningProblem.GetTopLevelTasks()[1].taskName);
+}
@@ -0,0 +1,213 @@
+#include "checkpoint.h"
+#include "tfd.h"
+#include "metrics.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <atomic>
+#include <cstdio>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+    std::optional<tfd_cpp::State> Up(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        tfd_cpp::State newState(state);
+        newState.data = std::any_cast<int>(state.data) + 1;
+        return newState;
+    }
+
+    std::optional<tfd_cpp::State> Mark(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return state;
+    }
+
+    // never makes progress, so trying it first sends a depth-first search down forever
+    std::optional<std::vector<tfd_cpp::Task>> Wander(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Goal", {}}, {"Up", {}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Finish(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Up", {}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> Impossible(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::nullopt;
+    }
+}
+
+struct PortfolioTest : public ::testing::Test
+{
+    PortfolioTest() :
+        planningDomain("Portfolio")
+    {
+        planningDomain.AddOperator("Up", Up);
+        planningDomain.AddOperator("Mark", Mark);
+        planningDomain.AddMethod("Goal", Wander);
+        planningDomain.AddMethod("Goal", Finish);
+        planningDomain.AddMethod("Nothing", Impossible);
+        for (int choice = 0; choice < 4; ++choice)
+        {
+            planningDomain.AddMethod("Choose", [choice](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+                return std::optional<std::vector<tfd_cpp::Task>>({{"Mark", {choice}}});
+            });
+        }
+    }
+
+    ~PortfolioTest() {}
+
+    tfd_cpp::PlanningProblem Problem(const std::string& taskName) const
+    {
+        return tfd_cpp::PlanningProblem(planningDomain, {"Portfolio", 0}, {taskName, {}});
+    }
+
+    tfd_cpp::PlanningDomain planningDomain;
+};
+
+TEST_F(PortfolioTest, ReversedMethodOrderTriesTheLastMethodFirst)
+{
+    tfd_cpp::TFD tfd(Problem("Goal"));
+    tfd_cpp::SearchOptions options;
+    options.methodOrder = tfd_cpp::MethodOrder::Reversed;
+
+    const auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_EQ(1, result.plan.size());
+}
+
+TEST_F(PortfolioTest, ShuffledMethodOrderFollowsTheSeed)
+{
+    tfd_cpp::TFD tfd(Problem("Choose"));
+    tfd_cpp::SearchOptions options;
+    options.methodOrder = tfd_cpp::MethodOrder::Shuffled;
+
+    std::set<int> choices;
+    for (std::uint64_t seed = 0; seed < 16; ++seed)
+    {
+        options.seed = seed;
+        const auto first = tfd.Search(options);
+        const auto second = tfd.Search(options);
+        ASSERT_EQ(1, first.plan.size());
+        ASSERT_EQ(std::any_cast<int>(first.plan[0].task.parameters[0]), std::any_cast<int>(second.plan[0].task.parameters[0]));
+        choices.insert(std::any_cast<int>(first.plan[0].task.parameters[0]));
+    }
+    ASSERT_GT(choices.size(), 1);
+
+    options.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+    options.seed = 0;
+    ASSERT_EQ(1, tfd.Search(options).plan.size());
+}
+
+TEST_F(PortfolioTest, DepthLimitCutsOffRunawayMethods)
+{
+    tfd_cpp::TFD tfd(Problem("Goal"));
+    tfd_cpp::SearchOptions options;
+    options.depthLimit = 10;
+
+    const auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_LE(result.plan.size(), 10);
+}
+
+TEST_F(PortfolioTest, CancelledSearchesStop)
+{
+    tfd_cpp::TFD tfd(Problem("Goal"));
+    const std::atomic<bool> cancel(true);
+    tfd_cpp::SearchOptions options;
+    options.cancel = &cancel;
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Cancelled, tfd.Search(options).status);
+    options.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+    ASSERT_EQ(tfd_cpp::SearchStatus::Cancelled, tfd.Search(options).status);
+}
+
+TEST_F(PortfolioTest, FirstPlanWins)
+{
+    tfd_cpp::TFD tfd(Problem("Goal"));
+    std::vector<tfd_cpp::PortfolioConfiguration> configurations(2);
+    configurations[0].name = "runaway";
+    configurations[0].options.memoryLimit = 256 * 1024 * 1024;
+    configurations[1].name = "reversed";
+    configurations[1].options.methodOrder = tfd_cpp::MethodOrder::Reversed;
+
+    const auto portfolioResult = tfd.SearchPortfolio(configurations);
+    ASSERT_EQ(1, portfolioResult.winner);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, portfolioResult.result.status);
+    ASSERT_EQ(1, portfolioResult.result.plan.size());
+    ASSERT_EQ(2, portfolioResult.results.size());
+    ASSERT_NE(tfd_cpp::SearchStatus::Solved, portfolioResult.results[0].status);
+}
+
+TEST_F(PortfolioTest, OnlyCompleteSearchesProveThereIsNoPlan)
+{
+    tfd_cpp::TFD tfd(Problem("Nothing"));
+    std::vector<tfd_cpp::PortfolioConfiguration> configurations(1);
+    configurations[0].name = "beam";
+    configurations[0].options.strategy = tfd_cpp::SearchStrategy::Beam;
+
+    auto portfolioResult = tfd.SearchPortfolio(configurations);
+    ASSERT_FALSE(portfolioResult.winner);
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, portfolioResult.result.status);
+
+    configurations.push_back({"depth-first", tfd_cpp::SearchOptions()});
+    portfolioResult = tfd.SearchPortfolio(configurations);
+    ASSERT_EQ(1, portfolioResult.winner);
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, portfolioResult.result.status);
+}
+
+TEST_F(PortfolioTest, CallerCancelFlagsCancelThePortfolio)
+{
+    tfd_cpp::TFD tfd(Problem("Goal"));
+    const std::atomic<bool> cancel(true);
+    std::vector<tfd_cpp::PortfolioConfiguration> configurations(2);
+    configurations[0].name = "cancelled";
+    configurations[0].options.cancel = &cancel;
+    configurations[1].name = "runaway";
+    configurations[1].options.memoryLimit = 256 * 1024 * 1024;
+
+    const auto portfolioResult = tfd.SearchPortfolio(configurations);
+    ASSERT_FALSE(portfolioResult.winner);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Cancelled, portfolioResult.results[0].status);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Cancelled, portfolioResult.results[1].status);
+}
+
+TEST_F(PortfolioTest, OnlyTheFirstConfigurationWritesASharedCheckpointFile)
+{
+    const auto path = ::testing::TempDir() + "tfd_cpp_portfolio_test";
+    tfd_cpp::TFD tfd(Problem("Goal"));
+    const std::atomic<bool> cancel(true);
+    std::vector<tfd_cpp::PortfolioConfiguration> configurations(2);
+    configurations[0].name = "depth-first";
+    configurations[1].name = "depth-first-reversed";
+    configurations[1].options.methodOrder = tfd_cpp::MethodOrder::Reversed;
+    for (auto& configuration : configurations)
+    {
+        configuration.options.cancel = &cancel;
+        configuration.options.checkpointFile = path;
+        configuration.options.resume = true;
+    }
+
+    const auto portfolioResult = tfd.SearchPortfolio(configurations);
+    ASSERT_FALSE(portfolioResult.winner);
+    ASSERT_TRUE(tfd_cpp::LoadCheckpoint(path));
+    std::remove(path.c_str());
+}
+
+TEST_F(PortfolioTest, CountsWinsInMetrics)
+{
+    tfd_cpp::MetricsRegistry registry;
+    tfd_cpp::PlannerMetrics metrics(registry);
+    tfd_cpp::TFD tfd(Problem("Goal"));
+
+    const auto portfolioResult = tfd.SearchPortfolio(tfd_cpp::DefaultPortfolio(), &metrics);
+    ASSERT_TRUE(portfolioResult.winner);
+    ASSERT_FALSE(portfolioResult.result.plan.empty());
+
+    const auto winner = tfd_cpp::DefaultPortfolio()[portfolioResult.winner.value()].name;
+    ASSERT_EQ(1, registry.GetCounter("tfd_portfolio_wins_total", "", {{"configuration", winner}})->Value());
+    ASSERT_GE(registry.GetCounter("tfd_searches_total", "", {{"status", "solved"}})->Value(), 1);
+}
@@ -0,0 +1,201 @@
+// Built as its own executable because it links allocation_counter.cpp, which replaces the global
+// operator new, and the simple_travel example. Compares machine-independent counters of a fixed
+// corpus of problems with the baselines in TFD_REGRESSION_BASELINES, allowing them to grow by
+// TFD_REGRESSION_MARGIN (a fraction). With TFD_REGRESSION_UPDATE=1 the baselines are rewritten
+// from this run instead.
+#include "allocation_counter.h"
+#include "metrics.h"
+#include "simple_travel_problem.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/log/core.hpp>
+
+namespace {
+    using tfd_cpp_test::Allocations;
+
+
+    struct RegressionCase
+    {
+        std::string name;
+        std::size_t people;
+        tfd_cpp::SearchOptions options;
+    };
+
+    using Counters = std::map<std::string, std::size_t>;
+    using Baselines = std::map<std::string, Counters>;
+
+    const std::vector<std::string> CALLBACK_TASKS = {TRAVEL, WALK, CALL_TAXI, RIDE_TAXI, PAY_DRIVER};
+
+    std::vector<RegressionCase> Corpus()
+    {
+        tfd_cpp::SearchOptions optimize;
+        optimize.optimize = true;
+        tfd_cpp::SearchOptions greedy;
+        greedy.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+
+        return {{"travel-1/depth-first", 1, tfd_cpp::SearchOptions()},
+                {"travel-1/depth-first-optimal", 1, optimize},
+                {"travel-4/depth-first-optimal", 4, optimize},
+                {"travel-32/depth-first", 32, tfd_cpp::SearchOptions()},
+                {"travel-256/depth-first", 256, tfd_cpp::SearchOptions()},
+                {"travel-8/greedy-best-first", 8, greedy}};
+    }
+
+    // Every person has a taxi of their own and travels between two locations of the example city.
+    tfd_cpp::PlanningProblem TravelProblem(std::size_t people)
+    {
+        const auto roadMap = simple_travel::CityRoadMap();
+        simple_travel::SimpleTravelState::PersonLocationTable locations;
+        simple_travel::SimpleTravelState::PersonCashTable cash;
+        simple_travel::SimpleTravelState::PersonOweTable owe;
+        tfd_cpp::TaskNetwork tasks;
+        for (std::size_t person = 0; person < people; ++person)
+        {
+            const auto name = "person-" + std::to_string(person);
+            const auto taxi = "taxi-" + std::to_string(person);
+            const simple_travel::SimpleTravelState::Location src = person % roadMap->Size();
+            const simple_travel::SimpleTravelState::Location dst = (person + 2) % roadMap->Size();
+            locations[name] = src;
+            locations[taxi] = roadMap->IdOf("park").value();
+            cash[name] = 50;
+            owe[name] = 0;
+            tasks.tasks.push_back({TRAVEL, {name, taxi, src, dst}});
+        }
+
+        const tfd_cpp::State state = {DOMAIN_NAME, simple_travel::SimpleTravelState(locations, cash, owe, roadMap)};
+        return tfd_cpp::PlanningProblem(simple_travel::CreatePlanningDomain(), state, tasks);
+    }
+
+    Counters Measure(const RegressionCase& regressionCase)
+    {
+        tfd_cpp::TFD tfd(TravelProblem(regressionCase.people));
+        Counters counters;
+
+        // callbacks are counted by the metrics' timers, which a search without metrics skips
+        tfd_cpp::MetricsRegistry registry;
+        tfd_cpp::PlannerMetrics metrics(registry);
+        auto options = regressionCase.options;
+        options.metrics = &metrics;
+        const auto result = tfd.Search(options);
+        counters["nodes_expanded"] = result.nodesExpanded;
+        counters["plan_length"] = result.plan.size();
+        counters["callbacks"] = 0;
+        for (const auto& task : CALLBACK_TASKS)
+        {
+            counters["callbacks"] += registry.GetHistogram("tfd_callback_duration_seconds", "", {}, {{"task", task}})->Count();
+        }
+
+        const auto allocations = Allocations();
+        tfd.Search(regressionCase.options);
+        counters["allocations"] = Allocations() - allocations;
+        return counters;
+    }
+
+    Baselines LoadBaselines(const std::string& path)
+    {
+        Baselines baselines;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty() or line[0] == '#')
+            {
+                continue;
+            }
+            std::istringstream fields(line);
+            std::string name;
+            std::string counter;
+            std::size_t value;
+            if (fields >> name >> counter >> value)
+            {
+                baselines[name][counter] = value;
+            }
+        }
+        return baselines;
+    }
+
+    void SaveBaselines(const std::string& path, const Baselines& baselines)
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "# problem counter baseline; regenerate with TFD_REGRESSION_UPDATE=1\n";
+        for (const auto& [name, counters] : baselines)
+        {
+            for (const auto& [counter, value] : counters)
+            {
+                file << name << " " << counter << " " << value << "\n";
+            }
+        }
+    }
+}
+
+TEST(RegressionTest, CountersStayWithinBaselines)
+{
+    const char* baselinesPath = std::getenv("TFD_REGRESSION_BASELINES");
+    ASSERT_TRUE(baselinesPath) << "TFD_REGRESSION_BASELINES is not set.";
+    const char* marginText = std::getenv("TFD_REGRESSION_MARGIN");
+    const double margin = marginText ? std::atof(marginText) : 0.0;
+    const char* update = std::getenv("TFD_REGRESSION_UPDATE");
+
+    // records are formatted on the heap, and logging would dominate the allocation counts
+    boost::log::core::get()->set_logging_enabled(false);
+    Baselines measured;
+    for (const auto& regressionCase : Corpus())
+    {
+        measured[regressionCase.name] = Measure(regressionCase);
+    }
+    boost::log::core::get()->set_logging_enabled(true);
+
+    if (update and std::string(update) == "1")
+    {
+        SaveBaselines(baselinesPath, measured);
+        GTEST_SKIP() << "Baselines written to " << baselinesPath;
+    }
+
+    const auto baselines = LoadBaselines(baselinesPath);
+    for (const auto& [name, counters] : measured)
+    {
+        ASSERT_EQ(1, baselines.count(name)) << "No baselines for " << name << ".";
+        for (const auto& [counter, value] : counters)
+        {
+            const auto baseline = baselines.at(name).find(counter);
+            ASSERT_NE(baselines.at(name).end(), baseline) << "No baseline for " << name << " " << counter << ".";
+            EXPECT_LE(value, baseline->second * (1.0 + margin)) << name << " " << counter << " went from " << baseline->second
+                                                                << " to " << value << ".";
+            if (value < baseline->second)
+            {
+                std::cout << name << " " << counter << " went down from " << baseline->second << " to " << value
+                          << "; consider updating the baselines." << std::endl;
+            }
+        }
+    }
+}
+
+TEST(RegressionTest, LookaheadPrunesTripsFromWherePeopleAreNot)
+{
+    // the second trip starts at home, but after the first one alice is downtown; every way of making
+    // the first trip is undone to try the second again, and each time TravelByFoot only fails at Walk
+    const auto roadMap = simple_travel::CityRoadMap();
+    const auto home = roadMap->IdOf("home").value();
+    const auto corner = roadMap->IdOf("corner").value();
+    const auto downtown = roadMap->IdOf("downtown").value();
+    const simple_travel::SimpleTravelState travelState({{"alice", home}, {"taxi", roadMap->IdOf("park").value()}},
+                                                       {{"alice", 20}}, {{"alice", 0}}, roadMap);
+    const tfd_cpp::TaskNetwork tasks{{{TRAVEL, {std::string("alice"), std::string("taxi"), home, downtown}},
+                                      {TRAVEL, {std::string("alice"), std::string("taxi"), home, corner}}}};
+    tfd_cpp::TFD tfd(tfd_cpp::PlanningProblem(simple_travel::CreatePlanningDomain(), {DOMAIN_NAME, travelState}, tasks));
+
+    tfd_cpp::SearchOptions options;
+    const auto unchecked = tfd.Search(options);
+    options.lookahead = tfd_cpp::Lookahead::FirstSubtask;
+    const auto checked = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, unchecked.status);
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, checked.status);
+    ASSERT_LT(checked.nodesExpanded, unchecked.nodesExpanded);
+}
@@ -0,0 +1,209 @@
+#include "subplan_cache.h"
+#include "tfd.h"
+#include "zobrist.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+    using Counters = std::map<std::string, int>;
+
+    int Value(const tfd_cpp::State& state, const std::any& name)
+    {
+        const auto& counters = std::any_cast<const Counters&>(state.data);
+        const auto counter = counters.find(std::any_cast<std::string>(name));
+        return counter == counters.end() ? 0 : counter->second;
+    }
+
+    tfd_cpp::State WithValue(const tfd_cpp::State& state, const std::any& name, int value)
+    {
+        tfd_cpp::State newState(state);
+        std::any_cast<Counters&>(newState.data)[std::any_cast<std::string>(name)] = value;
+        return newState;
+    }
+
+    // Add(name, amount, limit) fails if it would take the counter past the limit
+    std::optional<tfd_cpp::State> Add(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        const auto value = Value(state, parameters[0]) + std::any_cast<int>(parameters[1]);
+        if (value > std::any_cast<int>(parameters[2]))
+        {
+            return std::nullopt;
+        }
+        return WithValue(state, parameters[0], value);
+    }
+
+    std::optional<tfd_cpp::State> Set(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return WithValue(state, parameters[0], std::any_cast<int>(parameters[1]));
+    }
+
+    std::optional<tfd_cpp::State> Expect(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (Value(state, parameters[0]) != std::any_cast<int>(parameters[1]))
+        {
+            return std::nullopt;
+        }
+        return state;
+    }
+
+    // Reach(name, limit) counts up to the limit in steps of two, then of one
+    std::optional<std::vector<tfd_cpp::Task>> Reached(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (Value(state, parameters[0]) != std::any_cast<int>(parameters[1]))
+        {
+            return std::nullopt;
+        }
+        return std::vector<tfd_cpp::Task>();
+    }
+
+    tfd_cpp::MethodFunction ReachBy(int amount)
+    {
+        return [amount](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) -> std::optional<std::vector<tfd_cpp::Task>>
+        {
+            if (Value(state, parameters[0]) >= std::any_cast<int>(parameters[1]))
+            {
+                return std::nullopt;
+            }
+            // the last subtask comes first
+            return std::vector<tfd_cpp::Task>{{"Reach", parameters}, {"Add", {parameters[0], amount, parameters[1]}}};
+        };
+    }
+
+    std::uint64_t ReachProjection(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        const auto task = tfd_cpp::HashParameter(parameters[0]) ^ tfd_cpp::ZobristKey(std::any_cast<int>(parameters[1]));
+        return tfd_cpp::ZobristCombine(task, tfd_cpp::ZobristKey(Value(state, parameters[0])));
+    }
+
+    tfd_cpp::Task ReachTask(const std::string& name, int limit)
+    {
+        return {"Reach", {name, limit}};
+    }
+
+    std::vector<std::string> TaskNames(const tfd_cpp::Plan& plan)
+    {
+        std::vector<std::string> taskNames;
+        for (const auto& step : plan)
+        {
+            taskNames.push_back(step.task.taskName + " " + std::to_string(std::any_cast<int>(step.task.parameters[1])));
+        }
+        return taskNames;
+    }
+}
+
+struct SubplanCacheTest : public ::testing::Test
+{
+    SubplanCacheTest() :
+        planningDomain("Counters"),
+        initialState{"Counters", Counters()}
+    {
+        planningDomain.AddOperator("Add", Add);
+        planningDomain.AddOperator("Set", Set);
+        planningDomain.AddOperator("Expect", Expect);
+        planningDomain.AddMethod("Reach", Reached);
+        planningDomain.AddMethod("Reach", ReachBy(2));
+        planningDomain.AddMethod("Reach", ReachBy(1));
+        planningDomain.SetTaskProjection("Reach", ReachProjection);
+        planningDomain.AddMethod("Choose", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+            return std::optional<std::vector<tfd_cpp::Task>>({{"Set", {parameters[0], 1}}});
+        });
+        planningDomain.AddMethod("Choose", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+            return std::optional<std::vector<tfd_cpp::Task>>({{"Set", {parameters[0], 2}}});
+        });
+    }
+
+    ~SubplanCacheTest() {}
+
+    tfd_cpp::PlanningProblem Problem(const std::vector<tfd_cpp::Task>& tasks) const
+    {
+        return tfd_cpp::PlanningProblem(planningDomain, initialState, tfd_cpp::TaskNetwork{tasks});
+    }
+
+    tfd_cpp::PlanningDomain planningDomain;
+    tfd_cpp::State initialState;
+};
+
+TEST_F(SubplanCacheTest, KeepsTheFirstSubplanUntilFull)
+{
+    const auto& add = planningDomain.FindOperators("Add")->front();
+    tfd_cpp::SubplanCache subplanCache(1024);
+    ASSERT_EQ(nullptr, subplanCache.Find("Reach", 1));
+    ASSERT_TRUE(subplanCache.Store("Reach", 1, {{{"Add", {std::string("a"), 1, 1}}, add}}));
+    ASSERT_FALSE(subplanCache.Store("Reach", 1, {}));
+    ASSERT_TRUE(subplanCache.Contains("Reach", 1));
+    ASSERT_FALSE(subplanCache.Contains("Other", 1));
+
+    const auto subplan = subplanCache.Find("Reach", 1);
+    ASSERT_NE(nullptr, subplan);
+    ASSERT_EQ(1, subplan->size());
+    ASSERT_EQ(1, subplanCache.Hits());
+    ASSERT_EQ(1, subplanCache.Misses());
+
+    std::uint64_t projection = 2;
+    while (subplanCache.Store("Reach", projection, {{{"Add", {std::string("a"), 1, 1}}, add}}))
+    {
+        ++projection;
+    }
+    ASSERT_LE(subplanCache.Bytes(), 1024);
+    ASSERT_EQ(projection - 1, subplanCache.Size());
+    // sub-plans stay where they are as others are added
+    ASSERT_EQ(subplan, subplanCache.Find("Reach", 1));
+}
+
+TEST_F(SubplanCacheTest, ReusesSubplansAcrossSearches)
+{
+    tfd_cpp::TFD tfd(Problem({ReachTask("a", 9)}));
+    tfd_cpp::SubplanCache subplanCache;
+    tfd_cpp::SearchOptions options;
+    options.subplanCache = &subplanCache;
+
+    const auto first = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, first.status);
+    ASSERT_EQ(0, subplanCache.Hits());
+    // Reach from 0, 2, 4, 6, 8 and 9: the nested tasks are all achieved by the last step
+    ASSERT_EQ(6, subplanCache.Size());
+
+    const auto second = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, second.status);
+    ASSERT_LT(0, subplanCache.Hits());
+    ASSERT_EQ(TaskNames(first.plan), TaskNames(second.plan));
+    ASSERT_EQ(first.taskBoundaries, second.taskBoundaries);
+    ASSERT_LT(second.nodesExpanded, first.nodesExpanded);
+    ASSERT_EQ(TaskNames(tfd.Search(tfd_cpp::SearchOptions()).plan), TaskNames(second.plan));
+}
+
+TEST_F(SubplanCacheTest, ReusesSubplansAcrossBranches)
+{
+    // the first choice fails only after Reach has been achieved, which the second choice does not affect
+    tfd_cpp::TFD tfd(Problem({{"Choose", {std::string("b")}}, ReachTask("a", 9), {"Expect", {std::string("b"), 2}}}));
+    tfd_cpp::SubplanCache subplanCache;
+    tfd_cpp::SearchOptions options;
+    options.subplanCache = &subplanCache;
+
+    const auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_LT(0, subplanCache.Hits());
+    ASSERT_EQ(TaskNames(tfd.Search(tfd_cpp::SearchOptions()).plan), TaskNames(result.plan));
+}
+
+TEST_F(SubplanCacheTest, StaleSubplansFallBackToTheMethods)
+{
+    const auto task = ReachTask("a", 9);
+    tfd_cpp::TFD tfd(Problem({task}));
+    tfd_cpp::SubplanCache subplanCache;
+    const auto projection = planningDomain.TaskProjection(initialState, task);
+    ASSERT_TRUE(projection);
+    const auto& add = planningDomain.FindOperators("Add")->front();
+    ASSERT_TRUE(subplanCache.Store("Reach", projection.value(), {{{"Add", {std::string("a"), 5, 4}}, add}}));
+
+    tfd_cpp::SearchOptions options;
+    options.subplanCache = &subplanCache;
+    const auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_EQ(1, subplanCache.Hits());
+    ASSERT_EQ(TaskNames(tfd.Search(tfd_cpp::SearchOptions()).plan), TaskNames(result.plan));
+}
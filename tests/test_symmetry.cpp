@@ -0,0 +1,148 @@
+#include "symmetry.h"
+#include "tfd.h"
+#include "gtest/gtest.h"
+#include <any>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+    // where each taxi is parked
+    using Taxis = std::map<std::string, std::string>;
+
+    std::optional<tfd_cpp::State> Broken(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::nullopt;
+    }
+
+    std::uint64_t ParkedAt(const tfd_cpp::State& state, const std::any& object)
+    {
+        const auto& taxis = std::any_cast<const Taxis&>(state.data);
+        return std::hash<std::string>()(taxis.at(std::any_cast<std::string>(object)));
+    }
+}
+
+struct SymmetryTest : public ::testing::Test
+{
+    SymmetryTest() :
+        planningDomain("Taxis"),
+        initialState{"Taxis", Taxis{{"taxi-0", "rank"}, {"taxi-1", "rank"}, {"taxi-2", "rank"}, {"taxi-3", "airport"}}},
+        calls(0)
+    {
+        planningDomain.AddOperator("Drive", Broken);
+        planningDomain.AddMethodPerObject("Ride", {std::string("taxi-0"), std::string("taxi-1"), std::string("taxi-2"), std::string("taxi-3")},
+            [this](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters, const std::any& taxi) {
+                ++calls;
+                return std::optional<std::vector<tfd_cpp::Task>>({{"Drive", {taxi}}});
+            });
+    }
+
+    ~SymmetryTest() {}
+
+    tfd_cpp::PlanningDomain planningDomain;
+    tfd_cpp::State initialState;
+    int calls;
+};
+
+TEST_F(SymmetryTest, TriesEveryObjectWithoutSignatures)
+{
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Ride", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    ASSERT_TRUE(tfd.TryToPlan().empty());
+    ASSERT_EQ(4, calls);
+}
+
+TEST_F(SymmetryTest, TriesOneObjectPerClass)
+{
+    planningDomain.SetObjectSignatureFunction(ParkedAt);
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Ride", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    ASSERT_TRUE(tfd.TryToPlan().empty());
+    // one taxi at the rank and the one at the airport
+    ASSERT_EQ(2, calls);
+}
+
+TEST_F(SymmetryTest, ReferencedObjectsAreNotInterchangeable)
+{
+    planningDomain.SetObjectSignatureFunction(ParkedAt);
+    planningDomain.AddMethod("Reserve", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        return std::optional<std::vector<tfd_cpp::Task>>({{"Hold", {std::string("taxi-0")}}, {"Ride", {}}});
+    });
+    planningDomain.AddOperator("Hold", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        return std::optional<tfd_cpp::State>(state);
+    });
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Reserve", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    ASSERT_TRUE(tfd.TryToPlan().empty());
+    // taxi-0 is still on the agenda, so it is tried besides one of the other taxis at the rank
+    ASSERT_EQ(3, calls);
+}
+
+TEST_F(SymmetryTest, BestFirstSearchTriesOneObjectPerClass)
+{
+    planningDomain.SetObjectSignatureFunction(ParkedAt);
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Ride", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    tfd_cpp::SearchOptions options;
+    options.strategy = tfd_cpp::SearchStrategy::GreedyBestFirst;
+    ASSERT_EQ(tfd_cpp::SearchStatus::NoPlan, tfd.Search(options).status);
+    ASSERT_EQ(2, calls);
+}
+
+TEST_F(SymmetryTest, ObjectsOfLaterTopLevelTasksAreNotInterchangeable)
+{
+    planningDomain.SetObjectSignatureFunction(ParkedAt);
+    planningDomain.AddMethodPerObject("Hail", {std::string("taxi-0"), std::string("taxi-1")},
+        [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters, const std::any& taxi) {
+            return std::optional<std::vector<tfd_cpp::Task>>({{"Occupy", {taxi}}});
+        });
+    planningDomain.AddOperator("Occupy", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        tfd_cpp::State newState(state);
+        std::any_cast<Taxis&>(newState.data)[std::any_cast<std::string>(parameters[0])] = "occupied";
+        return std::optional<tfd_cpp::State>(newState);
+    });
+    planningDomain.AddOperator("Use", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        if (std::any_cast<const Taxis&>(state.data).at(std::any_cast<std::string>(parameters[0])) == "occupied")
+        {
+            return std::optional<tfd_cpp::State>();
+        }
+        return std::optional<tfd_cpp::State>(state);
+    });
+    // taxi-0 is taken first and cannot be used afterwards, so only taxi-1 leads to a plan
+    const tfd_cpp::TaskNetwork tasks{{{"Hail", {std::string("alice")}}, {"Use", {std::string("taxi-0")}}}};
+    tfd_cpp::TFD tfd(tfd_cpp::PlanningProblem(planningDomain, initialState, tasks));
+
+    for (const auto strategy : {tfd_cpp::SearchStrategy::DepthFirst, tfd_cpp::SearchStrategy::GreedyBestFirst})
+    {
+        tfd_cpp::SearchOptions options;
+        options.strategy = strategy;
+        const auto result = tfd.Search(options);
+        ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+        ASSERT_EQ(2, result.plan.size());
+        ASSERT_EQ("taxi-1", std::any_cast<std::string>(result.plan[0].task.parameters[0]));
+    }
+}
+
+TEST(SymmetryFilterTest, GroupsAreSeparate)
+{
+    tfd_cpp::PlanningDomain planningDomain("Test");
+    planningDomain.SetObjectSignatureFunction([](const tfd_cpp::State&, const std::any&) { return 0; });
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"Test", 0}, {"Test", {}});
+    tfd_cpp::State state{"Test", 0};
+    tfd_cpp::SymmetryFilter symmetry;
+
+    ASSERT_FALSE(symmetry.Skip(planningProblem, state, {0, 1}));
+    ASSERT_TRUE(symmetry.Skip(planningProblem, state, {0, 2}));
+    ASSERT_FALSE(symmetry.Skip(planningProblem, state, {1, 2}));
+
+    symmetry.Clear();
+    symmetry.Refer({"Task", {3}});
+    ASSERT_FALSE(symmetry.Skip(planningProblem, state, {0, 3}));
+    ASSERT_FALSE(symmetry.Skip(planningProblem, state, {0, 4}));
+    ASSERT_TRUE(symmetry.Skip(planningProblem, state, {0, 5}));
+}
@@ -1,8 +1,13 @@
+#include "test_helpers.h"
 #include "tfd.h"
 #include "gtest/gtest.h"
 #include <optional>
 #include <any>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <thread>
+#include <vector>
 
 namespace {
     std::optional<tfd_cpp::State> Operator(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
@@ -76,3 +81,318 @@ TEST_F(TFDTest, TryToPlanFail)
     auto solutionPlan = tfd.TryToPlan();
     ASSERT_TRUE(solutionPlan.empty());
 }
+
+namespace {
+    using tfd_cpp_test::Decompose;
+
+    std::optional<tfd_cpp::State> Fail(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::nullopt;
+    }
+}
+
+TEST_F(TFDTest, EnumeratePlans)
+{
+    planningDomain.AddOperator("First", Operator);
+    planningDomain.AddOperator("Second", Operator);
+    planningDomain.AddMethod("TestMethod", Decompose({{"First", {}}}));
+    planningDomain.AddMethod("TestMethod", Decompose({{"Second", {}}, {"First", {}}}));
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    auto planIterator = tfd.EnumeratePlans();
+
+    auto firstPlan = planIterator.Next();
+    ASSERT_TRUE(firstPlan);
+    ASSERT_EQ(1, firstPlan.value().size());
+    ASSERT_FALSE(planIterator.Exhausted());
+
+    auto secondPlan = planIterator.Next();
+    ASSERT_TRUE(secondPlan);
+    ASSERT_EQ(2, secondPlan.value().size());
+    ASSERT_EQ("First", secondPlan.value()[0].task.taskName);
+    ASSERT_EQ("Second", secondPlan.value()[1].task.taskName);
+
+    ASSERT_EQ(std::nullopt, planIterator.Next());
+    ASSERT_TRUE(planIterator.Exhausted());
+}
+
+TEST_F(TFDTest, BacktrackingUndoesPlanSteps)
+{
+    planningDomain.AddOperator("TestOperator", Operator);
+    planningDomain.AddOperator("Dead", Fail);
+    planningDomain.AddMethod("TestMethod", Decompose({{"Dead", {}}, {"TestOperator", {}}}));
+    planningDomain.AddMethod("TestMethod", Decompose({{"TestOperator", {true}}}));
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    auto solutionPlan = tfd.TryToPlan();
+
+    ASSERT_EQ(1, solutionPlan.size());
+    ASSERT_EQ(1, solutionPlan[0].task.parameters.size());
+}
+
+TEST_F(TFDTest, IllTypedSubtasksFailTheirMethod)
+{
+    planningDomain.AddOperator("Flip", tfd_cpp::Signature<bool>(), [](const tfd_cpp::State& state, const bool& value)
+    {
+        return std::optional<tfd_cpp::State>(tfd_cpp::State{state.domainName, value});
+    });
+    planningDomain.AddMethod("TestMethod", Decompose({{"Flip", {1}}}));
+    planningDomain.AddMethod("TestMethod", Decompose({{"Flip", {true}}}));
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    auto solutionPlan = tfd.TryToPlan();
+
+    ASSERT_EQ(1, solutionPlan.size());
+    ASSERT_TRUE(std::any_cast<bool>(solutionPlan[0].task.parameters[0]));
+}
+
+TEST_F(TFDTest, PlansTopLevelTasksAsOneSearch)
+{
+    planningDomain.AddOperator("TestOperator", Operator);
+    planningDomain.AddOperator("RequireTrue", [](const tfd_cpp::State& state, const tfd_cpp::Parameters&)
+    {
+        return std::any_cast<bool>(state.data) ? std::optional<tfd_cpp::State>(state) : std::nullopt;
+    });
+    planningDomain.AddMethod("TestMethod", Decompose({}));
+    planningDomain.AddMethod("TestMethod", Decompose({{"TestOperator", {}}}));
+
+    // the second task only succeeds if the first one backtracks into its second method
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState,
+                                             tfd_cpp::TaskNetwork{{topLevelTask, {"RequireTrue", {}}, {"TestOperator", {}}}});
+    tfd_cpp::TFD tfd(planningProblem);
+    auto result = tfd.Search(tfd_cpp::SearchOptions());
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_EQ(3, result.plan.size());
+    ASSERT_EQ("TestOperator", result.plan[0].task.taskName);
+    ASSERT_EQ("RequireTrue", result.plan[1].task.taskName);
+    ASSERT_EQ("TestOperator", result.plan[2].task.taskName);
+    ASSERT_EQ((std::vector<std::size_t>{1, 2, 3}), result.taskBoundaries);
+}
+
+TEST_F(TFDTest, ReportsPeakMemory)
+{
+    planningDomain.AddOperator("TestOperator", Operator);
+    planningDomain.AddMethod("TestMethod", Method);
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    auto result = tfd.Search(tfd_cpp::SearchOptions());
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, result.status);
+    ASSERT_LT(0, result.peakMemoryBytes);
+}
+
+TEST_F(TFDTest, MemoryLimitStopsRunawayDecomposition)
+{
+    // every decomposition leaves one more task on the agenda, so the search never bottoms out
+    planningDomain.AddOperator("TestOperator", Operator);
+    planningDomain.AddMethod("TestMethod", Decompose({{"TestOperator", {}}, {"TestMethod", {}}}));
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::SearchOptions options;
+    options.memoryLimit = 256 * 1024;
+    auto result = tfd.Search(options);
+
+    ASSERT_EQ(tfd_cpp::SearchStatus::MemoryExceeded, result.status);
+    ASSERT_TRUE(result.plan.empty());
+    ASSERT_LT(options.memoryLimit.value(), result.peakMemoryBytes);
+    ASSERT_LT(100, result.nodesExpanded);
+}
+
+TEST_F(TFDTest, OptimizeFindsCheapestPlan)
+{
+    planningDomain.AddOperator("Expensive", Operator);
+    planningDomain.AddOperator("Cheap", Operator);
+    planningDomain.AddMethod("TestMethod", Decompose({{"Expensive", {}}}));
+    planningDomain.AddMethod("TestMethod", Decompose({{"Cheap", {}}, {"Cheap", {}}}));
+    planningDomain.SetOperatorCost("Expensive", [](const tfd_cpp::State&, const tfd_cpp::Parameters&) { return 10.0; });
+    planningDomain.SetOperatorCost("Cheap", [](const tfd_cpp::State&, const tfd_cpp::Parameters&) { return 2.0; });
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+
+    auto firstResult = tfd.Search(tfd_cpp::SearchOptions());
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, firstResult.status);
+    ASSERT_DOUBLE_EQ(10.0, firstResult.cost);
+
+    std::vector<double> improvements;
+    tfd_cpp::SearchOptions options;
+    options.optimize = true;
+    options.onPlanFound = [&](const tfd_cpp::Plan&, double cost) { improvements.push_back(cost); };
+
+    auto optimalResult = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Optimal, optimalResult.status);
+    ASSERT_DOUBLE_EQ(4.0, optimalResult.cost);
+    ASSERT_EQ(2, optimalResult.plan.size());
+    ASSERT_EQ(std::vector<double>({10.0, 4.0}), improvements);
+}
+
+TEST_F(TFDTest, OptimizeReturnsAnEmptyPlanAsTheOptimum)
+{
+    planningDomain.AddOperator("Expensive", Operator);
+    planningDomain.AddMethod("TestMethod", Decompose({}));
+    planningDomain.AddMethod("TestMethod", Decompose({{"Expensive", {}}}));
+    planningDomain.SetOperatorCost("Expensive", [](const tfd_cpp::State&, const tfd_cpp::Parameters&) { return 10.0; });
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+
+    // without optimize a non-empty plan is preferred
+    auto firstResult = tfd.Search(tfd_cpp::SearchOptions());
+    ASSERT_EQ(tfd_cpp::SearchStatus::Solved, firstResult.status);
+    ASSERT_EQ(1, firstResult.plan.size());
+
+    tfd_cpp::SearchOptions options;
+    options.optimize = true;
+    auto optimalResult = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Optimal, optimalResult.status);
+    ASSERT_DOUBLE_EQ(0.0, optimalResult.cost);
+    ASSERT_TRUE(optimalResult.plan.empty());
+}
+
+TEST_F(TFDTest, LowerBoundPrunesPartialPlans)
+{
+    std::size_t expensiveCalls = 0;
+    planningDomain.AddOperator("Cheap", Operator);
+    planningDomain.AddOperator("Expensive", [&](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        ++expensiveCalls;
+        return Operator(state, parameters);
+    });
+    planningDomain.AddMethod("TestMethod", Decompose({{"Cheap", {}}}));
+    planningDomain.AddMethod("TestMethod", Decompose({{"Expensive", {}}, {"Cheap", {}}}));
+    planningDomain.SetOperatorCost("Expensive", [](const tfd_cpp::State&, const tfd_cpp::Parameters&) { return 5.0; });
+    planningDomain.SetTaskLowerBound("Expensive", [](const tfd_cpp::State&, const tfd_cpp::Parameters&) { return 5.0; });
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::SearchOptions options;
+    options.optimize = true;
+
+    auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Optimal, result.status);
+    ASSERT_DOUBLE_EQ(1.0, result.cost);
+    ASSERT_EQ(0, expensiveCalls);
+}
+
+TEST_F(TFDTest, SearchStopsAtTimeLimit)
+{
+    // ten alternatives per level and a dead end at the bottom: far too many leaves to exhaust
+    planningDomain.AddOperator("Dead", Fail);
+    for (int i = 0; i < 10; ++i)
+    {
+        planningDomain.AddMethod("Level", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+            const int level = std::any_cast<int>(parameters[0]);
+            tfd_cpp::Task next = (level == 0) ? tfd_cpp::Task{"Dead", {}} : tfd_cpp::Task{"Level", {level - 1}};
+            return std::optional<std::vector<tfd_cpp::Task>>({next});
+        });
+    }
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, {"Level", {9}});
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::SearchOptions options;
+    options.timeLimit = std::chrono::milliseconds(20);
+
+    auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Timeout, result.status);
+    ASSERT_TRUE(result.plan.empty());
+    ASSERT_LT(0, result.nodesExpanded);
+}
+
+TEST_F(TFDTest, LongAgendaRunsSubtasksInOrder)
+{
+    planningDomain.AddOperator("TestOperator", Operator);
+    planningDomain.AddMethod("TestMethod", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        // the last subtask runs first
+        std::vector<tfd_cpp::Task> subtasks;
+        for (int step = 10000; step > 0; --step)
+        {
+            subtasks.push_back({"TestOperator", {step}});
+        }
+        return std::optional<std::vector<tfd_cpp::Task>>(subtasks);
+    });
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+
+    auto solutionPlan = tfd.TryToPlan();
+    ASSERT_EQ(10000, solutionPlan.size());
+    for (int step = 0; step < 10000; ++step)
+    {
+        ASSERT_EQ(step + 1, std::any_cast<int>(solutionPlan[step].task.parameters[0]));
+    }
+}
+
+TEST_F(TFDTest, DeterministicPrimitiveRunsNeedNoChoicePoints)
+{
+    planningDomain.AddOperator("TestOperator", Operator);
+    planningDomain.AddMethod("TestMethod", Decompose(std::vector<tfd_cpp::Task>(100, {"TestOperator", {}})));
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::PlanIterator planIterator(planningProblem);
+    ASSERT_TRUE(planIterator.Advance());
+    ASSERT_EQ(100, planIterator.CurrentPlan().size());
+    ASSERT_EQ(101, planIterator.NodesExpanded());
+    // only the method's choice point is left to backtrack to
+    ASSERT_EQ(1, planIterator.Checkpoint().choicePoints.size());
+    ASSERT_FALSE(planIterator.Advance());
+}
+
+TEST_F(TFDTest, DeterministicPrimitiveRunsStayWithinTheMemoryLimit)
+{
+    // every step copies a 100 KB state, so a thousand of them cannot fit in a megabyte
+    planningDomain.AddOperator("Op", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        return std::optional<tfd_cpp::State>(state);
+    });
+    planningDomain.AddMethod("TestMethod", Decompose(std::vector<tfd_cpp::Task>(1000, {"Op", {}})));
+    planningDomain.SetStateSizeFunction([](const tfd_cpp::State& state) {
+        return std::any_cast<const std::vector<char>&>(state.data).size();
+    });
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"TestDomain", std::vector<char>(100 * 1024)}, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::SearchOptions options;
+    options.memoryLimit = 1000000;
+    const auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::MemoryExceeded, result.status);
+    ASSERT_LT(result.nodesExpanded, 20);
+}
+
+TEST_F(TFDTest, DeterministicPrimitiveRunsStopAtTheDeadline)
+{
+    planningDomain.AddOperator("Op", [](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return std::optional<tfd_cpp::State>(state);
+    });
+    planningDomain.AddMethod("TestMethod", Decompose(std::vector<tfd_cpp::Task>(1000, {"Op", {}})));
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::SearchOptions options;
+    options.timeLimit = std::chrono::milliseconds(20);
+    const auto result = tfd.Search(options);
+    ASSERT_EQ(tfd_cpp::SearchStatus::Timeout, result.status);
+    ASSERT_LT(result.nodesExpanded, 1000);
+}
+
+TEST_F(TFDTest, DeterministicPrimitiveRunsStopWhenCancelled)
+{
+    std::atomic<bool> cancel(false);
+    int applied = 0;
+    planningDomain.AddOperator("Op", [&cancel, &applied](const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters) {
+        cancel = ++applied == 10;
+        return std::optional<tfd_cpp::State>(state);
+    });
+    planningDomain.AddMethod("TestMethod", Decompose(std::vector<tfd_cpp::Task>(1000, {"Op", {}})));
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, initialState, topLevelTask);
+    tfd_cpp::TFD tfd(planningProblem);
+    tfd_cpp::SearchOptions options;
+    options.cancel = &cancel;
+    ASSERT_EQ(tfd_cpp::SearchStatus::Cancelled, tfd.Search(options).status);
+    ASSERT_EQ(10, applied);
+}
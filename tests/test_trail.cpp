@@ -0,0 +1,145 @@
+#include "tfd.h"
+#include "trail.h"
+#include "gtest/gtest.h"
+#include <optional>
+#include <any>
+#include <vector>
+
+namespace {
+    int& Counter(tfd_cpp::State& state)
+    {
+        return std::any_cast<int&>(state.data);
+    }
+
+    bool Add(tfd_cpp::State& state, const tfd_cpp::Parameters& parameters, tfd_cpp::Trail& trail)
+    {
+        trail.Save(Counter(state));
+        Counter(state) += std::any_cast<int>(parameters[0]);
+        return true;
+    }
+
+    // changes the state before it finds out it is not applicable
+    bool AddBelowLimit(tfd_cpp::State& state, const tfd_cpp::Parameters& parameters, tfd_cpp::Trail& trail)
+    {
+        Add(state, parameters, trail);
+        return Counter(state) < 4;
+    }
+
+    std::optional<tfd_cpp::State> Check(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        if (std::any_cast<int>(state.data) != std::any_cast<int>(parameters[0]))
+        {
+            return std::nullopt;
+        }
+        return state;
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> AddThree(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Check", {5}}, {"Add", {3}}};
+    }
+
+    std::optional<std::vector<tfd_cpp::Task>> AddFive(const tfd_cpp::State& state, const tfd_cpp::Parameters& parameters)
+    {
+        return std::vector<tfd_cpp::Task>{{"Check", {5}}, {"Add", {5}}};
+    }
+}
+
+TEST(TrailTest, UndoesNewestFirst)
+{
+    tfd_cpp::Trail trail;
+    tfd_cpp::State state{"Test", 0};
+    std::vector<int> undone;
+
+    trail.Record([&undone](tfd_cpp::State&) { undone.push_back(1); });
+    trail.Record([&undone](tfd_cpp::State&) { undone.push_back(2); });
+    ASSERT_EQ(2, trail.Size());
+
+    trail.UndoTo(state, 0);
+    ASSERT_EQ(0, trail.Size());
+    ASSERT_EQ((std::vector<int>{2, 1}), undone);
+}
+
+TEST(TrailTest, UndoToMarkKeepsOlderEntries)
+{
+    tfd_cpp::Trail trail;
+    tfd_cpp::State state{"Test", 1};
+
+    trail.Save(Counter(state));
+    Counter(state) = 2;
+    const auto mark = trail.Size();
+    trail.Save(Counter(state));
+    Counter(state) = 3;
+
+    trail.UndoTo(state, mark);
+    ASSERT_EQ(2, Counter(state));
+    trail.UndoTo(state, 0);
+    ASSERT_EQ(1, Counter(state));
+}
+
+TEST(TrailTest, SaveStateRestoresWholeState)
+{
+    tfd_cpp::Trail trail;
+    tfd_cpp::State state{"Test", 1};
+
+    trail.SaveState(tfd_cpp::State(state));
+    state = tfd_cpp::State{"Other", 7};
+    trail.Save(Counter(state));
+    Counter(state) = 8;
+
+    trail.UndoTo(state, 0);
+    ASSERT_EQ("Test", state.domainName);
+    ASSERT_EQ(1, Counter(state));
+}
+
+TEST(TrailTest, InPlaceOperatorsAreRolledBack)
+{
+    tfd_cpp::PlanningDomain planningDomain("Counter");
+    planningDomain.AddInPlaceOperator("Add", Add);
+    planningDomain.AddOperator("Check", Check);
+    planningDomain.AddMethod("Reach", AddThree);
+    planningDomain.AddMethod("Reach", AddFive);
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"Counter", 0}, {"Reach", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+    auto solutionPlan = tfd.TryToPlan();
+
+    // without the rollback the second method would see 3 + 5
+    ASSERT_EQ(2, solutionPlan.size());
+    ASSERT_EQ("Add", solutionPlan[0].task.taskName);
+    ASSERT_EQ(5, std::any_cast<int>(solutionPlan[0].task.parameters[0]));
+    ASSERT_EQ("Check", solutionPlan[1].task.taskName);
+}
+
+TEST(TrailTest, FailedInPlaceOperatorIsRolledBack)
+{
+    tfd_cpp::PlanningDomain planningDomain("Counter");
+    planningDomain.AddInPlaceOperator("Add", AddBelowLimit);
+    planningDomain.AddInPlaceOperator("Add", Add);
+    planningDomain.AddOperator("Check", Check);
+    planningDomain.AddMethod("Reach", AddFive);
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"Counter", 0}, {"Reach", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+
+    ASSERT_EQ(2, tfd.TryToPlan().size());
+}
+
+TEST(TrailTest, InPlaceOperatorReplaysOnCopy)
+{
+    tfd_cpp::PlanningDomain planningDomain("Counter");
+    planningDomain.AddInPlaceOperator("Add", Add);
+    planningDomain.AddMethod("Reach", AddFive);
+    planningDomain.AddOperator("Check", Check);
+
+    tfd_cpp::PlanningProblem planningProblem(planningDomain, {"Counter", 0}, {"Reach", {}});
+    tfd_cpp::TFD tfd(planningProblem);
+    auto solutionPlan = tfd.TryToPlan();
+    ASSERT_EQ(2, solutionPlan.size());
+
+    const tfd_cpp::State initialState{"Counter", 1};
+    auto successor = solutionPlan[0].func(initialState, solutionPlan[0].task.parameters);
+    ASSERT_TRUE(successor);
+    ASSERT_EQ(6, std::any_cast<int>(successor.value().data));
+    ASSERT_EQ(1, std::any_cast<int>(initialState.data));
+}
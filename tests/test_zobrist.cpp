@@ -0,0 +1,58 @@
+#include "zobrist.h"
+#include "fact_state.h"
+#include "gtest/gtest.h"
+#include <string>
+
+TEST(ZobristTest, KeysAreStable)
+{
+    ASSERT_EQ(tfd_cpp::ZobristKey(std::string_view("home")), tfd_cpp::ZobristKey(std::string_view("home")));
+    ASSERT_NE(tfd_cpp::ZobristKey(std::string_view("home")), tfd_cpp::ZobristKey(std::string_view("park")));
+    ASSERT_NE(tfd_cpp::ZobristCombine(1, 2), tfd_cpp::ZobristCombine(2, 1));
+}
+
+TEST(ZobristTest, HashParameterByValue)
+{
+    ASSERT_EQ(tfd_cpp::HashParameter(std::string("me")), tfd_cpp::HashParameter(std::string("me")));
+    ASSERT_NE(tfd_cpp::HashParameter(std::string("me")), tfd_cpp::HashParameter(std::string("taxi")));
+    ASSERT_NE(tfd_cpp::HashParameter(true), tfd_cpp::HashParameter(false));
+    ASSERT_EQ(0, tfd_cpp::HashParameter(std::any()));
+}
+
+TEST(ZobristTest, AgendaHashIsIncremental)
+{
+    tfd_cpp::Task walk{"Walk", {std::string("me"), std::string("home"), std::string("park")}};
+    tfd_cpp::Task payDriver{"PayDriver", {std::string("me")}};
+
+    tfd_cpp::AgendaHash agendaHash;
+    agendaHash.Push(walk);
+    const auto withWalk = agendaHash.Value();
+    agendaHash.Push(payDriver);
+
+    ASSERT_EQ(tfd_cpp::HashAgenda({walk, payDriver}), agendaHash.Value());
+    ASSERT_NE(tfd_cpp::HashAgenda({payDriver, walk}), agendaHash.Value());
+
+    agendaHash.Pop();
+    ASSERT_EQ(withWalk, agendaHash.Value());
+    ASSERT_EQ(1, agendaHash.Size());
+}
+
+TEST(ZobristTest, FactStateHashFollowsEffects)
+{
+    tfd_cpp::FactOperator move;
+    move.positivePreconditions = tfd_cpp::MakeFactMask({3});
+    move.deleteEffects = tfd_cpp::MakeFactMask({3, 200});
+    move.addEffects = tfd_cpp::MakeFactMask({70});
+    move.fluentEffects.push_back({0, 2.5});
+
+    tfd_cpp::FactState state(256, 1);
+    state.Set(3);
+    state.Apply(move);
+
+    tfd_cpp::FactState expected(256, 1);
+    expected.Set(70);
+    expected.SetFluent(0, 2.5);
+
+    ASSERT_TRUE(expected == state);
+    ASSERT_EQ(expected.Hash(), state.Hash());
+    ASSERT_NE(tfd_cpp::FactState(256, 1).Hash(), state.Hash());
+}
@@ -0,0 +1,87 @@
+#include "agenda.h"
+
+#include <utility>
+
+namespace tfd_cpp
+{
+    Agenda::Agenda() :
+        m_size(0)
+    {
+    }
+
+    Agenda::Agenda(const std::vector<Task>& tasks) :
+        Agenda(Agenda().Push(std::vector<Task>(tasks.rbegin(), tasks.rend())))
+    {
+    }
+
+    Agenda::Agenda(std::shared_ptr<const Cell> front, std::size_t size) :
+        m_front(std::move(front)),
+        m_size(size)
+    {
+    }
+
+    Agenda::Agenda(Agenda&& other) noexcept :
+        m_front(std::move(other.m_front)),
+        m_size(other.m_size)
+    {
+        other.m_size = 0;
+    }
+
+    Agenda& Agenda::operator=(Agenda other)
+    {
+        std::swap(m_front, other.m_front);
+        std::swap(m_size, other.m_size);
+        return *this;
+    }
+
+    Agenda::~Agenda()
+    {
+        // releasing a long chain of cells recursively could overflow the stack
+        auto cell = std::move(m_front);
+        while (cell and cell.use_count() == 1)
+        {
+            auto next = std::move(cell->next);
+            cell = std::move(next);
+        }
+    }
+
+    bool Agenda::Empty() const
+    {
+        return m_size == 0;
+    }
+
+    std::size_t Agenda::Size() const
+    {
+        return m_size;
+    }
+
+    const Task& Agenda::Front() const
+    {
+        return m_front->task;
+    }
+
+    Agenda Agenda::Pop() const
+    {
+        return Agenda(m_front->next, m_size - 1);
+    }
+
+    Agenda Agenda::Push(std::vector<Task>&& tasks) const
+    {
+        auto front = m_front;
+        for (auto task = tasks.begin(); task != tasks.end(); ++task)
+        {
+            front = std::make_shared<const Cell>(Cell{std::move(*task), std::move(front)});
+        }
+        return Agenda(std::move(front), m_size + tasks.size());
+    }
+
+    Agenda::const_iterator Agenda::begin() const
+    {
+        return const_iterator(m_front.get());
+    }
+
+    Agenda::const_iterator Agenda::end() const
+    {
+        return const_iterator();
+    }
+}
@@ -0,0 +1,469 @@
+#include "best_first_search.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    static constexpr std::size_t DEADLINE_CHECK_INTERVAL = 64;
+
+    BestFirstSearch::SharedBytes::SharedBytes(std::size_t& memoryBytes, std::size_t bytes,
+                                              std::shared_ptr<const SharedBytes> previous) :
+        memoryBytes(memoryBytes),
+        bytes(bytes),
+        previous(std::move(previous))
+    {
+        memoryBytes += bytes;
+    }
+
+    BestFirstSearch::SharedBytes::~SharedBytes()
+    {
+        memoryBytes -= bytes;
+        auto sharedBytes = std::move(previous);
+        while (sharedBytes and sharedBytes.use_count() == 1)
+        {
+            auto next = std::move(sharedBytes->previous);
+            sharedBytes = std::move(next);
+        }
+    }
+
+    BestFirstSearch::CountedState::CountedState(State&& state, std::size_t& memoryBytes, std::size_t bytes) :
+        state(std::move(state)),
+        bytes(memoryBytes, bytes)
+    {
+    }
+
+    BestFirstSearch::PlanCell::PlanCell(const Task& task, const OperatorFunction* func, std::size_t topLevelTask,
+                                        std::shared_ptr<const PlanCell> previous, std::size_t& memoryBytes) :
+        task(task),
+        func(func),
+        topLevelTask(topLevelTask),
+        previous(std::move(previous)),
+        bytes(memoryBytes, sizeof(PlanCell) + TaskSize(task) - sizeof(Task))
+    {
+    }
+
+    BestFirstSearch::PlanCell::~PlanCell()
+    {
+        auto cell = std::move(previous);
+        while (cell and cell.use_count() == 1)
+        {
+            auto next = std::move(cell->previous);
+            cell = std::move(next);
+        }
+    }
+
+    bool BestFirstSearch::Compare::operator()(const Node& lhs, const Node& rhs) const
+    {
+        // true if lhs comes out of the open list after rhs
+        if (lhs.priority != rhs.priority)
+        {
+            return lhs.priority > rhs.priority;
+        }
+        // then the node with less left to do, then the earlier alternative
+        if (lhs.agenda.Size() != rhs.agenda.Size())
+        {
+            return lhs.agenda.Size() > rhs.agenda.Size();
+        }
+        return lhs.order > rhs.order;
+    }
+
+    BestFirstSearch::BestFirstSearch(const PlanningProblem& planningProblem, const SearchOptions& options) :
+        m_planningProblem(planningProblem),
+        m_options(options),
+        m_costBound(std::numeric_limits<double>::infinity()),
+        m_found(false),
+        m_timedOut(false),
+        m_memoryExceeded(false),
+        m_cancelled(false),
+        m_nodesGenerated(0),
+        m_nodesExpanded(0),
+        m_steps(0),
+        m_memoryBytes(0),
+        m_peakMemoryBytes(0),
+        m_random(options.seed)
+    {
+        if (options.timeLimit)
+        {
+            m_deadline = std::chrono::steady_clock::now() + options.timeLimit.value();
+        }
+        m_lookahead.SetMode(options.lookahead);
+    }
+
+    BestFirstSearch::~BestFirstSearch() {}
+
+    SearchResult BestFirstSearch::Run()
+    {
+        SearchResult result;
+
+        const auto& topLevelTasks = m_planningProblem.GetTopLevelTasks();
+        if (m_planningProblem.HasSignatures())
+        {
+            for (const auto& topLevelTask : topLevelTasks)
+            {
+                if (not m_planningProblem.CheckTask(topLevelTask))
+                {
+                    return result;
+                }
+            }
+        }
+
+        m_memoryBytes = sizeof(BestFirstSearch) + m_planningProblem.StateSize(m_planningProblem.GetInitialState());
+        if (m_options.strategy == SearchStrategy::Beam)
+        {
+            RunBeam(result);
+        }
+        else
+        {
+            RunBestFirst(result);
+        }
+
+        result.nodesExpanded = m_nodesExpanded;
+        result.peakMemoryBytes = m_peakMemoryBytes;
+        if (m_found)
+        {
+            // a beam may have dropped a cheaper plan, so only an exhausted open list proves optimality
+            const bool exhausted = not (m_timedOut or m_memoryExceeded or m_cancelled) and m_options.strategy != SearchStrategy::Beam;
+            result.status = (m_options.optimize and exhausted) ? SearchStatus::Optimal : SearchStatus::Solved;
+        }
+        else if (m_timedOut)
+        {
+            result.status = SearchStatus::Timeout;
+        }
+        else if (m_memoryExceeded)
+        {
+            result.status = SearchStatus::MemoryExceeded;
+        }
+        else if (m_cancelled)
+        {
+            result.status = SearchStatus::Cancelled;
+        }
+        else
+        {
+            result.status = SearchStatus::NoPlan;
+        }
+
+        return result;
+    }
+
+    void BestFirstSearch::RunBestFirst(SearchResult& result)
+    {
+        std::priority_queue<Node, std::vector<Node>, Compare> openList;
+        std::vector<Node> children;
+
+        Node root;
+        root.agenda = Agenda(m_planningProblem.GetTopLevelTasks());
+        root.state = std::make_shared<const State>(m_planningProblem.GetInitialState());
+        AddNode(std::move(root), children);
+
+        while (not children.empty() or not openList.empty())
+        {
+            for (auto& child : children)
+            {
+                openList.push(std::move(child));
+            }
+            children.clear();
+            if (OverLimits())
+            {
+                return;
+            }
+            if (openList.empty())
+            {
+                break;
+            }
+
+            // what the node shares with its children stays counted until they are gone too
+            const Node node = openList.top();
+            openList.pop();
+            DropNode();
+
+            if (Prune(node))
+            {
+                continue;
+            }
+            if (node.agenda.Empty())
+            {
+                if (FoundPlan(node, result))
+                {
+                    return;
+                }
+                continue;
+            }
+
+            Expand(node, children);
+        }
+    }
+
+    void BestFirstSearch::RunBeam(SearchResult& result)
+    {
+        std::vector<Node> beam;
+        std::vector<Node> children;
+
+        Node root;
+        root.agenda = Agenda(m_planningProblem.GetTopLevelTasks());
+        root.state = std::make_shared<const State>(m_planningProblem.GetInitialState());
+        AddNode(std::move(root), beam);
+
+        while (not beam.empty())
+        {
+            // plans completed on this level beat anything the next level could offer at equal priority
+            std::sort(beam.begin(), beam.end(), [](const Node& lhs, const Node& rhs) { return Compare()(rhs, lhs); });
+            for (const auto& node : beam)
+            {
+                if (node.agenda.Empty() and not Prune(node) and FoundPlan(node, result))
+                {
+                    return;
+                }
+            }
+
+            for (const auto& node : beam)
+            {
+                if (OverLimits())
+                {
+                    return;
+                }
+                if (not node.agenda.Empty() and not Prune(node))
+                {
+                    Expand(node, children);
+                }
+            }
+            for (std::size_t node = 0; node < beam.size(); ++node)
+            {
+                DropNode();
+            }
+
+            std::sort(children.begin(), children.end(), [](const Node& lhs, const Node& rhs) { return Compare()(rhs, lhs); });
+            for (std::size_t child = std::min(children.size(), m_options.beamWidth); child < children.size(); ++child)
+            {
+                DropNode();
+            }
+            children.resize(std::min(children.size(), m_options.beamWidth));
+            beam.swap(children);
+            children.clear();
+        }
+    }
+
+    void BestFirstSearch::Expand(const Node& node, std::vector<Node>& children)
+    {
+        const auto& task = node.agenda.Front();
+        const auto rest = node.agenda.Pop();
+        const auto callbackDuration = m_options.metrics ? m_options.metrics->CallbackDuration(task.taskName) : nullptr;
+        // the top-level tasks that have not been started are the bottom of the agenda
+        const std::size_t notStarted = m_planningProblem.GetTopLevelTasks().size() - node.topLevelTasksStarted;
+        const std::size_t topLevelTasksStarted = node.topLevelTasksStarted + (node.agenda.Size() == notStarted ? 1 : 0);
+        ++m_nodesExpanded;
+
+        if (const auto operators = m_planningProblem.FindOperators(task.taskName))
+        {
+            BOOST_LOG_TRIVIAL(trace) << "BestFirstSearch: Applying operators for " << task.taskName;
+            const auto guards = m_planningProblem.FindOperatorGuards(task.taskName);
+            if (guards)
+            {
+                guards->Select(*node.state, task.parameters, m_selection);
+            }
+
+            const auto alternatives = guards ? m_selection.alternatives.size() : operators->size();
+            for (std::size_t alternative = 0; alternative < alternatives; ++alternative)
+            {
+                const auto& chosenOperator = (*operators)[guards ? m_selection.alternatives[alternative] : alternative];
+                std::optional<State> successor;
+                {
+                    ScopedTimer callbackTimer(callbackDuration);
+                    successor = chosenOperator(*node.state, task.parameters);
+                }
+                if (not successor)
+                {
+                    continue;
+                }
+
+                Node child;
+                child.agenda = rest;
+                const auto stateBytes = m_planningProblem.StateSize(successor.value());
+                const auto countedState = std::make_shared<const CountedState>(std::move(successor.value()), m_memoryBytes, stateBytes);
+                child.state = std::shared_ptr<const State>(countedState, &countedState->state);
+                child.plan = std::make_shared<const PlanCell>(task, &chosenOperator, topLevelTasksStarted - 1, node.plan, m_memoryBytes);
+                child.agendaBytes = node.agendaBytes;
+                child.topLevelTasksStarted = topLevelTasksStarted;
+                child.cost = node.cost + m_planningProblem.OperatorCost(*node.state, task);
+                AddNode(std::move(child), children);
+            }
+        }
+        else if (const auto methods = m_planningProblem.FindMethods(task.taskName))
+        {
+            BOOST_LOG_TRIVIAL(trace) << "BestFirstSearch: Decomposing " << task.taskName;
+            const auto boundObjects = m_planningProblem.FindBoundObjects(task.taskName);
+            SymmetryFilter symmetry;
+            if (boundObjects)
+            {
+                for (const auto& agendaTask : node.agenda)
+                {
+                    symmetry.Refer(agendaTask);
+                }
+            }
+
+            const auto guards = m_planningProblem.FindMethodGuards(task.taskName);
+            if (guards)
+            {
+                guards->Select(*node.state, task.parameters, m_selection);
+            }
+            // the order children are generated in breaks ties between them
+            const bool reordered = m_options.methodOrder != MethodOrder::AsAdded;
+            if (reordered)
+            {
+                if (not guards)
+                {
+                    m_selection.alternatives.resize(methods->size());
+                    std::iota(m_selection.alternatives.begin(), m_selection.alternatives.end(), 0);
+                }
+                detail::OrderAlternatives(m_options.methodOrder, m_random, m_selection.alternatives);
+            }
+
+            const bool selected = guards or reordered;
+            const auto alternatives = selected ? m_selection.alternatives.size() : methods->size();
+            for (std::size_t next = 0; next < alternatives; ++next)
+            {
+                const auto alternative = selected ? m_selection.alternatives[next] : next;
+                if (boundObjects and alternative < boundObjects->size() and (*boundObjects)[alternative] and
+                    symmetry.Skip(m_planningProblem, *node.state, (*boundObjects)[alternative].value()))
+                {
+                    continue;
+                }
+
+                const auto& method = (*methods)[alternative];
+                std::optional<std::vector<Task>> subTasks;
+                {
+                    ScopedTimer callbackTimer(callbackDuration);
+                    subTasks = method(*node.state, task.parameters);
+                }
+                if (not subTasks)
+                {
+                    continue;
+                }
+                if (m_planningProblem.HasSignatures() and
+                    not std::all_of(subTasks->begin(), subTasks->end(),
+                                    [this](const Task& subTask) { return m_planningProblem.CheckTask(subTask); }))
+                {
+                    continue;
+                }
+                if (not m_lookahead.Passes(m_planningProblem, *node.state, subTasks.value()))
+                {
+                    BOOST_LOG_TRIVIAL(trace) << "BestFirstSearch: Lookahead pruned a method of " << task.taskName;
+                    continue;
+                }
+
+                Node child;
+                std::size_t agendaBytes = 0;
+                for (const auto& subTask : subTasks.value())
+                {
+                    // each subtask gets an agenda cell of its own, roughly a task plus a shared_ptr
+                    agendaBytes += TaskSize(subTask) + sizeof(std::shared_ptr<const Task>);
+                }
+                child.agendaBytes = std::make_shared<const SharedBytes>(m_memoryBytes, agendaBytes, node.agendaBytes);
+                child.agenda = rest.Push(std::move(subTasks.value()));
+                child.state = node.state;
+                child.plan = node.plan;
+                child.topLevelTasksStarted = topLevelTasksStarted;
+                child.cost = node.cost;
+                AddNode(std::move(child), children);
+            }
+        }
+    }
+
+    void BestFirstSearch::AddNode(Node&& node, std::vector<Node>& nodes)
+    {
+        node.order = m_nodesGenerated++;
+
+        const double heuristic = m_options.heuristic ? m_options.heuristic(*node.state, node.agenda) : LowerBound(node);
+        node.priority = (m_options.strategy == SearchStrategy::GreedyBestFirst) ? heuristic
+                                                                               : node.cost + m_options.weight * heuristic;
+
+        m_memoryBytes += sizeof(Node);
+        m_peakMemoryBytes = std::max(m_peakMemoryBytes, m_memoryBytes);
+        nodes.push_back(std::move(node));
+    }
+
+    void BestFirstSearch::DropNode()
+    {
+        m_memoryBytes -= sizeof(Node);
+    }
+
+    bool BestFirstSearch::FoundPlan(const Node& node, SearchResult& result)
+    {
+        std::vector<const PlanCell*> steps;
+        for (auto cell = node.plan.get(); cell; cell = cell->previous.get())
+        {
+            steps.push_back(cell);
+        }
+
+        result.plan.clear();
+        result.taskBoundaries.assign(m_planningProblem.GetTopLevelTasks().size(), 0);
+        for (auto step = steps.rbegin(); step != steps.rend(); ++step)
+        {
+            result.plan.emplace_back((*step)->task, *(*step)->func);
+            result.taskBoundaries[(*step)->topLevelTask] = result.plan.size();
+        }
+        // a top-level task without steps ends where the previous one ended
+        for (std::size_t topLevelTask = 1; topLevelTask < result.taskBoundaries.size(); ++topLevelTask)
+        {
+            result.taskBoundaries[topLevelTask] = std::max(result.taskBoundaries[topLevelTask], result.taskBoundaries[topLevelTask - 1]);
+        }
+        result.cost = node.cost;
+        m_found = true;
+        m_costBound = node.cost;
+
+        BOOST_LOG_TRIVIAL(info) << "BestFirstSearch: found plan with cost " << node.cost << " after " << m_nodesExpanded << " expansions.";
+        if (m_options.onPlanFound)
+        {
+            m_options.onPlanFound(result.plan, result.cost);
+        }
+
+        return not m_options.optimize;
+    }
+
+    double BestFirstSearch::LowerBound(const Node& node) const
+    {
+        if (not m_planningProblem.HasLowerBounds())
+        {
+            return 0.0;
+        }
+
+        double lowerBound = 0.0;
+        for (const auto& task : node.agenda)
+        {
+            lowerBound += m_planningProblem.TaskLowerBound(*node.state, task);
+        }
+        return lowerBound;
+    }
+
+    bool BestFirstSearch::Prune(const Node& node) const
+    {
+        return m_found and node.cost + LowerBound(node) >= m_costBound;
+    }
+
+    bool BestFirstSearch::OverLimits()
+    {
+        if (m_deadline and (m_steps++ % DEADLINE_CHECK_INTERVAL) == 0 and
+            std::chrono::steady_clock::now() >= m_deadline.value())
+        {
+            BOOST_LOG_TRIVIAL(warning) << "BestFirstSearch: Time limit reached.";
+            m_timedOut = true;
+            return true;
+        }
+        if (m_options.memoryLimit and m_memoryBytes > m_options.memoryLimit.value())
+        {
+            BOOST_LOG_TRIVIAL(warning) << "BestFirstSearch: Memory limit of " << m_options.memoryLimit.value() << " bytes reached.";
+            m_memoryExceeded = true;
+            return true;
+        }
+        if (m_options.cancel and m_options.cancel->load(std::memory_order_relaxed))
+        {
+            BOOST_LOG_TRIVIAL(info) << "BestFirstSearch: Cancelled.";
+            m_cancelled = true;
+            return true;
+        }
+        return false;
+    }
+}
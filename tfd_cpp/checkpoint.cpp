@@ -0,0 +1,170 @@
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    namespace
+    {
+        constexpr const char* CHECKPOINT_HEADER = "tfd_cpp-checkpoint 1";
+
+        void WriteRecords(std::ostream& stream, const char* name, const std::vector<SearchCheckpoint::ChoicePointRecord>& records)
+        {
+            stream << name << " " << records.size() << "\n";
+            for (const auto& record : records)
+            {
+                stream << record.nextAlternative << " " << (record.selected ? 1 : 0) << " " << record.alternatives.size();
+                for (const auto alternative : record.alternatives)
+                {
+                    stream << " " << alternative;
+                }
+                // last, so that it may contain spaces
+                stream << " " << record.taskName << "\n";
+            }
+        }
+
+        // Reads "<key> <value>" and returns the value, or nullopt if the line is not for that key.
+        std::optional<std::string> ReadField(std::istream& stream, const std::string& key)
+        {
+            std::string line;
+            if (not std::getline(stream, line) or line.compare(0, key.size() + 1, key + " ") != 0)
+            {
+                return std::nullopt;
+            }
+            return line.substr(key.size() + 1);
+        }
+
+        std::optional<std::size_t> ReadCount(std::istream& stream, const std::string& key)
+        {
+            const auto value = ReadField(stream, key);
+            if (not value)
+            {
+                return std::nullopt;
+            }
+            char* end = nullptr;
+            const auto count = std::strtoull(value->c_str(), &end, 10);
+            if (end == value->c_str() or *end != '\0')
+            {
+                return std::nullopt;
+            }
+            return static_cast<std::size_t>(count);
+        }
+
+        bool ReadRecords(std::istream& stream, const std::string& key, std::vector<SearchCheckpoint::ChoicePointRecord>& records)
+        {
+            const auto count = ReadCount(stream, key);
+            if (not count)
+            {
+                return false;
+            }
+
+            // the counts come from the file: records are read one at a time, and no line lists more
+            // alternatives than it has characters
+            records.clear();
+            for (std::size_t index = 0; index < count.value(); ++index)
+            {
+                std::string line;
+                if (not std::getline(stream, line))
+                {
+                    return false;
+                }
+
+                std::istringstream fields(line);
+                SearchCheckpoint::ChoicePointRecord record;
+                int selected = 0;
+                std::size_t alternatives = 0;
+                if (not (fields >> record.nextAlternative >> selected >> alternatives) or alternatives > line.size())
+                {
+                    return false;
+                }
+                record.selected = selected != 0;
+                record.alternatives.reserve(alternatives);
+                for (std::size_t alternative = 0; alternative < alternatives; ++alternative)
+                {
+                    std::size_t value = 0;
+                    if (not (fields >> value))
+                    {
+                        return false;
+                    }
+                    record.alternatives.push_back(value);
+                }
+                if (fields.get() != ' ' or not std::getline(fields, record.taskName))
+                {
+                    return false;
+                }
+                records.push_back(std::move(record));
+            }
+            return true;
+        }
+    }
+
+    bool SaveCheckpoint(const SearchCheckpoint& checkpoint, const std::string& path)
+    {
+        const std::string temporaryPath = path + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::trunc);
+            if (not file)
+            {
+                BOOST_LOG_TRIVIAL(error) << "SaveCheckpoint: Unable to write " << temporaryPath;
+                return false;
+            }
+
+            file << CHECKPOINT_HEADER << "\n";
+            file << "cost-bound " << std::setprecision(std::numeric_limits<double>::max_digits10) << checkpoint.costBound << "\n";
+            file << "nodes-expanded " << checkpoint.nodesExpanded << "\n";
+            file << "peak-memory-bytes " << checkpoint.peakMemoryBytes << "\n";
+            file << "random " << checkpoint.randomState << "\n";
+            WriteRecords(file, "choice-points", checkpoint.choicePoints);
+            WriteRecords(file, "incumbent", checkpoint.incumbent);
+            if (not file)
+            {
+                BOOST_LOG_TRIVIAL(error) << "SaveCheckpoint: Unable to write " << temporaryPath;
+                return false;
+            }
+        }
+
+        if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+        {
+            BOOST_LOG_TRIVIAL(error) << "SaveCheckpoint: Unable to replace " << path;
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::optional<SearchCheckpoint> LoadCheckpoint(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (not file)
+        {
+            BOOST_LOG_TRIVIAL(error) << "LoadCheckpoint: Unable to open " << path;
+            return std::nullopt;
+        }
+
+        SearchCheckpoint checkpoint;
+        std::string header;
+        std::getline(file, header);
+        const auto costBound = ReadField(file, "cost-bound");
+        const auto nodesExpanded = ReadCount(file, "nodes-expanded");
+        const auto peakMemoryBytes = ReadCount(file, "peak-memory-bytes");
+        const auto randomState = ReadField(file, "random");
+        if (header != CHECKPOINT_HEADER or not costBound or not nodesExpanded or not peakMemoryBytes or not randomState or
+            not ReadRecords(file, "choice-points", checkpoint.choicePoints) or not ReadRecords(file, "incumbent", checkpoint.incumbent))
+        {
+            BOOST_LOG_TRIVIAL(error) << "LoadCheckpoint: " << path << " is not a search checkpoint.";
+            return std::nullopt;
+        }
+
+        // strtod, unlike operator>>, reads back the "inf" of a search without a plan yet
+        checkpoint.costBound = std::strtod(costBound->c_str(), nullptr);
+        checkpoint.nodesExpanded = nodesExpanded.value();
+        checkpoint.peakMemoryBytes = peakMemoryBytes.value();
+        checkpoint.randomState = randomState.value();
+        return checkpoint;
+    }
+}
@@ -0,0 +1,261 @@
+#include "decomposition.h"
+#include "metrics.h"
+#include "tfd.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    namespace
+    {
+        std::size_t Root(std::vector<std::size_t>& parents, std::size_t task)
+        {
+            while (parents[task] != task)
+            {
+                parents[task] = parents[parents[task]];
+                task = parents[task];
+            }
+            return task;
+        }
+
+        void Join(std::vector<std::size_t>& parents, std::size_t task1, std::size_t task2)
+        {
+            const auto root1 = Root(parents, task1);
+            const auto root2 = Root(parents, task2);
+            // the earlier task stays the root, so groups come out in the order of their first tasks
+            parents[std::max(root1, root2)] = std::min(root1, root2);
+        }
+
+        struct ResourceUse
+        {
+            std::optional<std::size_t> writer;      // the first one; later writers join its group
+            std::vector<std::size_t> readers;       // before the first writer
+        };
+
+        bool Solved(const SearchResult& result)
+        {
+            return result.status == SearchStatus::Solved or result.status == SearchStatus::Optimal;
+        }
+    }
+
+    std::vector<std::vector<std::size_t>> IndependentTaskGroups(const PlanningProblem& planningProblem)
+    {
+        const auto& topLevelTasks = planningProblem.GetTopLevelTasks();
+        std::vector<std::size_t> parents(topLevelTasks.size());
+        std::iota(parents.begin(), parents.end(), 0);
+
+        std::unordered_map<std::string, ResourceUse> resources;
+        for (std::size_t task = 0; task < topLevelTasks.size(); ++task)
+        {
+            const auto footprint = planningProblem.TaskFootprint(planningProblem.GetInitialState(), topLevelTasks[task]);
+            if (not footprint)
+            {
+                BOOST_LOG_TRIVIAL(info) << "IndependentTaskGroups: " << topLevelTasks[task].taskName << " has no footprint.";
+                std::vector<std::size_t> all(topLevelTasks.size());
+                std::iota(all.begin(), all.end(), 0);
+                return {all};
+            }
+
+            for (const auto& resource : footprint->reads)
+            {
+                auto& use = resources[resource];
+                if (use.writer)
+                {
+                    Join(parents, use.writer.value(), task);
+                }
+                else
+                {
+                    use.readers.push_back(task);
+                }
+            }
+            for (const auto& resource : footprint->writes)
+            {
+                auto& use = resources[resource];
+                if (not use.writer)
+                {
+                    use.writer = task;
+                }
+                Join(parents, use.writer.value(), task);
+                for (const auto reader : use.readers)
+                {
+                    Join(parents, use.writer.value(), reader);
+                }
+                use.readers.clear();
+            }
+        }
+
+        std::vector<std::vector<std::size_t>> groups;
+        std::vector<std::size_t> groupOfRoot(topLevelTasks.size());
+        for (std::size_t task = 0; task < topLevelTasks.size(); ++task)
+        {
+            const auto root = Root(parents, task);
+            if (root == task)
+            {
+                groupOfRoot[root] = groups.size();
+                groups.emplace_back();
+            }
+            groups[groupOfRoot[root]].push_back(task);
+        }
+        return groups;
+    }
+
+    DecomposedResult TFD::SearchDecomposed(const SearchOptions& options, std::size_t threads)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        DecomposedResult decomposedResult;
+        decomposedResult.groups = IndependentTaskGroups(m_planningProblem);
+        const auto& groups = decomposedResult.groups;
+        const auto& topLevelTasks = m_planningProblem.GetTopLevelTasks();
+        BOOST_LOG_TRIVIAL(info) << "SearchDecomposed: " << topLevelTasks.size() << " tasks in " << groups.size() << " groups.";
+        if (groups.size() <= 1)
+        {
+            decomposedResult.result = Search(options);
+            decomposedResult.results.push_back(decomposedResult.result);
+            return decomposedResult;
+        }
+
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        if (options.timeLimit)
+        {
+            deadline = start + options.timeLimit.value();
+        }
+
+        decomposedResult.results.resize(groups.size());
+        std::atomic<bool> cancel(false);
+        std::atomic<std::size_t> nextGroup(0);
+        std::mutex finishedMutex;
+        std::condition_variable groupFinished;
+        std::size_t finished = 0;
+        auto planGroups = [&]()
+        {
+            for (auto group = nextGroup++; group < groups.size(); group = nextGroup++)
+            {
+                auto& result = decomposedResult.results[group];
+                if (cancel)
+                {
+                    result.status = SearchStatus::Cancelled;
+                }
+                else
+                {
+                    auto groupOptions = options;
+                    groupOptions.cancel = &cancel;
+                    groupOptions.metrics = nullptr;
+                    groupOptions.onPlanFound = nullptr;
+                    groupOptions.checkpointFile.clear();
+                    if (deadline)
+                    {
+                        groupOptions.timeLimit = std::max(std::chrono::milliseconds(0),
+                            std::chrono::duration_cast<std::chrono::milliseconds>(deadline.value() - std::chrono::steady_clock::now()));
+                    }
+
+                    TaskNetwork tasks;
+                    for (const auto task : groups[group])
+                    {
+                        tasks.tasks.push_back(topLevelTasks[task]);
+                    }
+                    TFD tfd(PlanningProblem(m_planningProblem.GetPlanningDomain(), m_planningProblem.GetInitialState(), tasks));
+                    result = tfd.Search(groupOptions);
+                }
+
+                std::lock_guard<std::mutex> lock(finishedMutex);
+                // the merged plan needs a plan for every group
+                if (not Solved(result))
+                {
+                    cancel = true;
+                }
+                ++finished;
+                groupFinished.notify_one();
+            }
+        };
+
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::vector<std::thread> pool;
+        for (std::size_t thread = 0; thread < std::min(threads, groups.size()); ++thread)
+        {
+            pool.emplace_back(planGroups);
+        }
+        {
+            // the groups are cancelled through a flag of their own, so the caller's is passed on from here
+            std::unique_lock<std::mutex> lock(finishedMutex);
+            while (finished < groups.size())
+            {
+                if (options.cancel and options.cancel->load(std::memory_order_relaxed))
+                {
+                    cancel = true;
+                }
+                groupFinished.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+        for (auto& thread : pool)
+        {
+            thread.join();
+        }
+
+        auto& result = decomposedResult.result;
+        for (const auto& groupResult : decomposedResult.results)
+        {
+            result.nodesExpanded += groupResult.nodesExpanded;
+            result.peakMemoryBytes += groupResult.peakMemoryBytes;
+        }
+
+        if (std::all_of(decomposedResult.results.begin(), decomposedResult.results.end(), Solved))
+        {
+            // interleaving the groups' steps task by task keeps the steps of every group in order
+            std::vector<std::pair<std::size_t, std::size_t>> groupOfTask(topLevelTasks.size());
+            for (std::size_t group = 0; group < groups.size(); ++group)
+            {
+                for (std::size_t position = 0; position < groups[group].size(); ++position)
+                {
+                    groupOfTask[groups[group][position]] = {group, position};
+                }
+            }
+            result.taskBoundaries.resize(topLevelTasks.size());
+            for (std::size_t task = 0; task < topLevelTasks.size(); ++task)
+            {
+                const auto [group, position] = groupOfTask[task];
+                const auto& groupResult = decomposedResult.results[group];
+                const auto begin = position > 0 ? groupResult.taskBoundaries[position - 1] : 0;
+                const auto end = groupResult.taskBoundaries[position];
+                result.plan.insert(result.plan.end(), groupResult.plan.begin() + begin, groupResult.plan.begin() + end);
+                result.taskBoundaries[task] = result.plan.size();
+            }
+
+            const bool optimal = std::all_of(decomposedResult.results.begin(), decomposedResult.results.end(),
+                                             [](const SearchResult& groupResult) { return groupResult.status == SearchStatus::Optimal; });
+            result.status = optimal ? SearchStatus::Optimal : SearchStatus::Solved;
+            for (const auto& groupResult : decomposedResult.results)
+            {
+                result.cost += groupResult.cost;
+            }
+            if (options.onPlanFound)
+            {
+                options.onPlanFound(result.plan, result.cost);
+            }
+        }
+        else
+        {
+            // groups cancelled because another one failed say nothing about the problem
+            const auto failed = std::find_if(decomposedResult.results.begin(), decomposedResult.results.end(),
+                                             [](const SearchResult& groupResult) {
+                                                 return not Solved(groupResult) and groupResult.status != SearchStatus::Cancelled;
+                                             });
+            result.status = (failed != decomposedResult.results.end()) ? failed->status : SearchStatus::Cancelled;
+            BOOST_LOG_TRIVIAL(warning) << "SearchDecomposed: A group has no plan.";
+        }
+
+        if (options.metrics)
+        {
+            options.metrics->RecordSearch(result, std::chrono::steady_clock::now() - start);
+        }
+        return decomposedResult;
+    }
+}
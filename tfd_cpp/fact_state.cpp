@@ -0,0 +1,251 @@
+#include "fact_state.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tfd_cpp
+{
+    static constexpr std::size_t WORD_BITS = 64;
+
+    static ZobristHash FluentKey(std::uint32_t fluent, double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return ZobristCombine(ZobristKey(~static_cast<std::uint64_t>(fluent)), ZobristKey(bits));
+    }
+
+    // XORs in the key of every fact whose bit differs between the two words.
+    static ZobristHash ChangedFactKeys(std::uint32_t index, std::uint64_t changed)
+    {
+        ZobristHash keys = 0;
+        while (changed != 0)
+        {
+            const auto bit = static_cast<std::uint64_t>(__builtin_ctzll(changed));
+            keys ^= ZobristKey(index * WORD_BITS + bit);
+            changed &= changed - 1;
+        }
+        return keys;
+    }
+
+    FactMask MakeFactMask(std::vector<FactId> facts)
+    {
+        std::sort(facts.begin(), facts.end());
+
+        FactMask mask;
+        for (const auto fact : facts)
+        {
+            const auto index = static_cast<std::uint32_t>(fact / WORD_BITS);
+            const auto bit = std::uint64_t(1) << (fact % WORD_BITS);
+
+            if (mask.empty() or mask.back().index != index)
+            {
+                mask.push_back(FactWord{index, bit});
+            }
+            else
+            {
+                mask.back().bits |= bit;
+            }
+        }
+
+        return mask;
+    }
+
+    FactState::FactState(std::size_t factCount, std::size_t fluentCount) :
+        m_factCount(factCount),
+        m_words((factCount + WORD_BITS - 1) / WORD_BITS, 0),
+        m_fluents(fluentCount, 0.0),
+        m_hash(0)
+    {
+        for (std::uint32_t fluent = 0; fluent < fluentCount; ++fluent)
+        {
+            m_hash ^= FluentKey(fluent, 0.0);
+        }
+    }
+
+    bool FactState::Test(FactId fact) const
+    {
+        return (m_words[fact / WORD_BITS] >> (fact % WORD_BITS)) & 1;
+    }
+
+    void FactState::Set(FactId fact, bool value)
+    {
+        const auto bit = std::uint64_t(1) << (fact % WORD_BITS);
+        auto& word = m_words[fact / WORD_BITS];
+        if (((word & bit) != 0) != value)
+        {
+            word ^= bit;
+            m_hash ^= ZobristKey(static_cast<std::uint64_t>(fact));
+        }
+    }
+
+    double FactState::Fluent(std::uint32_t fluent) const
+    {
+        return m_fluents[fluent];
+    }
+
+    void FactState::SetFluent(std::uint32_t fluent, double value)
+    {
+        m_hash ^= FluentKey(fluent, m_fluents[fluent]) ^ FluentKey(fluent, value);
+        m_fluents[fluent] = value;
+    }
+
+    bool FactState::Satisfies(const FactOperator& factOperator) const
+    {
+        const std::uint64_t* words = m_words.data();
+        std::uint64_t missing = 0;
+
+        // accumulate instead of returning early so that the loops stay branch-free
+        for (const auto& word : factOperator.positivePreconditions)
+        {
+            missing |= (words[word.index] & word.bits) ^ word.bits;
+        }
+        for (const auto& word : factOperator.negativePreconditions)
+        {
+            missing |= words[word.index] & word.bits;
+        }
+        if (missing != 0)
+        {
+            return false;
+        }
+
+        for (const auto& condition : factOperator.fluentPreconditions)
+        {
+            if (m_fluents[condition.fluent] < condition.minimum)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void FactState::Apply(const FactOperator& factOperator)
+    {
+        std::uint64_t* words = m_words.data();
+
+        for (const auto& word : factOperator.deleteEffects)
+        {
+            m_hash ^= ChangedFactKeys(word.index, words[word.index] & word.bits);
+            words[word.index] &= ~word.bits;
+        }
+        for (const auto& word : factOperator.addEffects)
+        {
+            m_hash ^= ChangedFactKeys(word.index, ~words[word.index] & word.bits);
+            words[word.index] |= word.bits;
+        }
+        for (const auto& effect : factOperator.fluentEffects)
+        {
+            SetFluent(effect.fluent, m_fluents[effect.fluent] + effect.delta);
+        }
+    }
+
+    std::size_t FactState::FactCount() const
+    {
+        return m_factCount;
+    }
+
+    std::size_t FactState::FluentCount() const
+    {
+        return m_fluents.size();
+    }
+
+    const std::vector<std::uint64_t>& FactState::Words() const
+    {
+        return m_words;
+    }
+
+    ZobristHash FactState::Hash() const
+    {
+        return m_hash;
+    }
+
+    bool FactState::operator==(const FactState& other) const
+    {
+        return m_factCount == other.m_factCount and m_words == other.m_words and m_fluents == other.m_fluents;
+    }
+
+    FactOperatorBatch::FactOperatorBatch(const std::vector<const FactOperator*>& operators)
+    {
+        for (std::size_t i = 0; i < operators.size(); ++i)
+        {
+            const auto operatorIndex = static_cast<std::uint32_t>(i);
+            for (const auto& word : operators[i]->positivePreconditions)
+            {
+                m_entries.push_back(Entry{word.index, operatorIndex, word.bits, 0});
+            }
+            for (const auto& word : operators[i]->negativePreconditions)
+            {
+                m_entries.push_back(Entry{word.index, operatorIndex, 0, word.bits});
+            }
+            m_fluentPreconditions.push_back(operators[i]->fluentPreconditions);
+        }
+
+        std::stable_sort(m_entries.begin(), m_entries.end(),
+                         [](const Entry& lhs, const Entry& rhs) { return lhs.word < rhs.word; });
+    }
+
+    void FactOperatorBatch::Applicable(const FactState& state, std::vector<std::uint8_t>& applicable) const
+    {
+        applicable.assign(m_fluentPreconditions.size(), 1);
+
+        const std::uint64_t* words = state.Words().data();
+        std::uint8_t* result = applicable.data();
+        for (const auto& entry : m_entries)
+        {
+            const auto word = words[entry.word];
+            const bool satisfied = ((word & entry.positive) == entry.positive) & ((word & entry.negative) == 0);
+            result[entry.operatorIndex] &= static_cast<std::uint8_t>(satisfied);
+        }
+
+        for (std::size_t i = 0; i < m_fluentPreconditions.size(); ++i)
+        {
+            for (const auto& condition : m_fluentPreconditions[i])
+            {
+                if (state.Fluent(condition.fluent) < condition.minimum)
+                {
+                    result[i] = 0;
+                }
+            }
+        }
+    }
+
+    std::size_t FactOperatorBatch::Size() const
+    {
+        return m_fluentPreconditions.size();
+    }
+
+    std::uint64_t HashFactState(const State& state)
+    {
+        const auto* factState = std::any_cast<FactState>(&state.data);
+        return factState ? factState->Hash() : 0;
+    }
+
+    std::size_t FactStateSize(const State& state)
+    {
+        const auto* factState = std::any_cast<FactState>(&state.data);
+        if (not factState)
+        {
+            return 0;
+        }
+        return sizeof(FactState) + factState->Words().size() * sizeof(std::uint64_t) + factState->FluentCount() * sizeof(double);
+    }
+
+    OperatorFunction MakeOperatorFunction(const FactOperatorGrounding& grounding)
+    {
+        return [grounding](const State& state, const Parameters& parameters) -> std::optional<State>
+        {
+            const auto* factState = std::any_cast<FactState>(&state.data);
+            const auto* factOperator = grounding(parameters);
+
+            if (not factState or not factOperator or not factState->Satisfies(*factOperator))
+            {
+                return std::nullopt;
+            }
+
+            State newState(state);
+            std::any_cast<FactState&>(newState.data).Apply(*factOperator);
+
+            return newState;
+        };
+    }
+}
@@ -0,0 +1,151 @@
+#include "guard_index.h"
+
+#include <algorithm>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    namespace
+    {
+        bool Holds(GuardComparison comparison, std::int64_t fieldValue, std::int64_t value)
+        {
+            switch (comparison)
+            {
+            case GuardComparison::Equal:
+                return fieldValue == value;
+            case GuardComparison::AtMost:
+                return fieldValue <= value;
+            case GuardComparison::AtLeast:
+                return fieldValue >= value;
+            }
+            return false;
+        }
+    }
+
+    GuardIndex::GuardIndex() {}
+
+    GuardIndex::~GuardIndex() {}
+
+    void GuardIndex::AddField(const std::string& fieldName, const GuardFieldFunction& fieldFunc)
+    {
+        auto field = std::find_if(m_fields.begin(), m_fields.end(), [&fieldName](const Field& field) {
+            return field.name == fieldName;
+        });
+        if (field != m_fields.end())
+        {
+            field->func = fieldFunc;
+            return;
+        }
+
+        m_fields.push_back(Field{fieldName, fieldFunc, {}, {}, {}});
+    }
+
+    bool GuardIndex::Add(std::size_t alternative, const std::vector<Guard>& guards)
+    {
+        std::vector<ResolvedGuard> resolvedGuards;
+        for (const auto& guard : guards)
+        {
+            auto field = std::find_if(m_fields.begin(), m_fields.end(), [&guard](const Field& field) {
+                return field.name == guard.field;
+            });
+            if (field == m_fields.end())
+            {
+                BOOST_LOG_TRIVIAL(error) << "GuardIndex: No guard field named " << guard.field << ".";
+                return false;
+            }
+            resolvedGuards.push_back({static_cast<std::size_t>(field - m_fields.begin()), guard.comparison, guard.value});
+        }
+
+        m_residualGuards.resize(alternative + 1);
+        if (resolvedGuards.empty())
+        {
+            m_unguarded.push_back(alternative);
+            return true;
+        }
+
+        const auto& first = resolvedGuards.front();
+        auto& field = m_fields[first.field];
+        switch (first.comparison)
+        {
+        case GuardComparison::Equal:
+            field.equal[first.value].push_back(alternative);
+            break;
+        case GuardComparison::AtMost:
+            field.atMost.insert(std::upper_bound(field.atMost.begin(), field.atMost.end(), Bound{first.value, alternative}),
+                                Bound{first.value, alternative});
+            break;
+        case GuardComparison::AtLeast:
+            field.atLeast.insert(std::upper_bound(field.atLeast.begin(), field.atLeast.end(), Bound{first.value, alternative}),
+                                 Bound{first.value, alternative});
+            break;
+        }
+
+        m_residualGuards[alternative].assign(resolvedGuards.begin() + 1, resolvedGuards.end());
+        return true;
+    }
+
+    void GuardIndex::Select(const State& state, const std::vector<std::any>& parameters, GuardSelection& selection) const
+    {
+        auto& alternatives = selection.alternatives;
+        alternatives.assign(m_unguarded.begin(), m_unguarded.end());
+        selection.evaluated.assign(m_fields.size(), false);
+        selection.fieldValues.resize(m_fields.size());
+
+        for (std::size_t fieldId = 0; fieldId < m_fields.size(); ++fieldId)
+        {
+            const auto& field = m_fields[fieldId];
+            if (field.equal.empty() and field.atMost.empty() and field.atLeast.empty())
+            {
+                continue;
+            }
+
+            const auto& value = FieldValue(fieldId, state, parameters, selection);
+            if (not value)
+            {
+                continue;
+            }
+
+            auto equal = field.equal.find(value.value());
+            if (equal != field.equal.end())
+            {
+                alternatives.insert(alternatives.end(), equal->second.begin(), equal->second.end());
+            }
+
+            // field <= bound holds for every bound from the first one not below the field
+            const Bound key{value.value(), 0};
+            for (auto bound = std::lower_bound(field.atMost.begin(), field.atMost.end(), key); bound != field.atMost.end(); ++bound)
+            {
+                alternatives.push_back(bound->alternative);
+            }
+            const auto atLeastEnd = std::upper_bound(field.atLeast.begin(), field.atLeast.end(), key);
+            for (auto bound = field.atLeast.begin(); bound != atLeastEnd; ++bound)
+            {
+                alternatives.push_back(bound->alternative);
+            }
+        }
+
+        std::sort(alternatives.begin(), alternatives.end());
+        alternatives.erase(std::remove_if(alternatives.begin(), alternatives.end(), [&](std::size_t alternative) {
+            for (const auto& guard : m_residualGuards[alternative])
+            {
+                const auto& value = FieldValue(guard.field, state, parameters, selection);
+                if (not value or not Holds(guard.comparison, value.value(), guard.value))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }), alternatives.end());
+    }
+
+    const std::optional<std::int64_t>& GuardIndex::FieldValue(std::size_t field, const State& state, const std::vector<std::any>& parameters,
+                                                              GuardSelection& selection) const
+    {
+        if (not selection.evaluated[field])
+        {
+            selection.fieldValues[field] = m_fields[field].func(state, parameters);
+            selection.evaluated[field] = true;
+        }
+        return selection.fieldValues[field];
+    }
+}
@@ -0,0 +1,1457 @@
+#include "hddl_parser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    static const std::string HDDL_TOP_LEVEL_TASK = "__top_level__";
+
+    SymbolTable::SymbolTable(const SymbolTable& other)
+    {
+        *this = other;
+    }
+
+    SymbolTable& SymbolTable::operator=(const SymbolTable& other)
+    {
+        if (this != &other)
+        {
+            // the index refers into m_names, so it has to be rebuilt rather than copied
+            m_names = other.m_names;
+            m_ids.clear();
+            for (std::size_t i = 0; i < m_names.size(); ++i)
+            {
+                m_ids.emplace(m_names[i], static_cast<SymbolId>(i));
+            }
+        }
+        return *this;
+    }
+
+    SymbolId SymbolTable::Intern(std::string_view name)
+    {
+        auto symbol = m_ids.find(name);
+        if (symbol != m_ids.end())
+        {
+            return symbol->second;
+        }
+
+        const auto id = static_cast<SymbolId>(m_names.size());
+        m_names.emplace_back(name);
+        m_ids.emplace(m_names.back(), id);
+
+        return id;
+    }
+
+    std::optional<SymbolId> SymbolTable::Find(std::string_view name) const
+    {
+        auto symbol = m_ids.find(name);
+        if (symbol == m_ids.end())
+        {
+            return std::nullopt;
+        }
+
+        return symbol->second;
+    }
+
+    const std::string& SymbolTable::NameOf(SymbolId id) const
+    {
+        return m_names.at(id);
+    }
+
+    std::size_t SymbolTable::Size() const
+    {
+        return m_names.size();
+    }
+
+    std::optional<FactId> HddlModel::FactOf(SymbolId predicate, const std::vector<SymbolId>& arguments) const
+    {
+        const auto& entry = predicateTable.at(predicate);
+        if (arguments.size() != entry.parameterTypes.size())
+        {
+            return std::nullopt;
+        }
+
+        FactId fact = entry.offset;
+        for (std::size_t i = 0; i < arguments.size(); ++i)
+        {
+            const auto index = indexInType[entry.parameterTypes[i]][arguments[i]];
+            if (index == INVALID_SYMBOL)
+            {
+                return std::nullopt;
+            }
+            fact += index * entry.strides[i];
+        }
+
+        return fact;
+    }
+
+    Task HddlModel::MakeTask(const HddlTaskReference& reference, const std::vector<SymbolId>& bindings) const
+    {
+        Task task;
+        task.taskName = tasks.NameOf(reference.task);
+        task.parameters.reserve(reference.arguments.size());
+
+        for (const auto& argument : reference.arguments)
+        {
+            task.parameters.emplace_back(argument.isVariable ? bindings[argument.index] : argument.index);
+        }
+
+        return task;
+    }
+
+    std::string HddlModel::ToString(const Task& task) const
+    {
+        std::ostringstream os;
+        os << "(" << task.taskName;
+
+        for (const auto& parameter : task.parameters)
+        {
+            const auto* object = std::any_cast<SymbolId>(&parameter);
+            if (object and *object < objects.Size())
+            {
+                os << " " << objects.NameOf(*object);
+            }
+            else
+            {
+                os << " ?";
+            }
+        }
+        os << ")";
+
+        return os.str();
+    }
+
+    namespace
+    {
+        struct HddlError : public std::runtime_error
+        {
+            using std::runtime_error::runtime_error;
+        };
+
+        // Flat s-expression tree. Children are linked through sibling indices so that building the
+        // tree needs one pass over the text and one allocation per growth of the node vector.
+        class SExpressionTree
+        {
+        public:
+            static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+            struct Node
+            {
+                std::string_view atom;
+                std::uint32_t firstChild;
+                std::uint32_t nextSibling;
+                std::uint32_t childCount;
+                bool isList;
+            };
+
+            explicit SExpressionTree(const std::string& text) :
+                m_text(text)
+            {
+                std::transform(m_text.begin(), m_text.end(), m_text.begin(),
+                               [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                Parse();
+            }
+
+            const Node& Root() const
+            {
+                if (m_nodes.empty() or m_nodes[0].nextSibling != NONE)
+                {
+                    throw HddlError("expected exactly one top-level expression");
+                }
+                return m_nodes[0];
+            }
+
+            const Node* First(const Node& list) const
+            {
+                return list.firstChild == NONE ? nullptr : &m_nodes[list.firstChild];
+            }
+
+            const Node* Next(const Node& node) const
+            {
+                return node.nextSibling == NONE ? nullptr : &m_nodes[node.nextSibling];
+            }
+
+            const Node& At(const Node& list, std::uint32_t position) const
+            {
+                const Node* node = First(list);
+                for (std::uint32_t i = 0; node and i < position; ++i)
+                {
+                    node = Next(*node);
+                }
+                if (not node)
+                {
+                    throw HddlError("malformed expression");
+                }
+                return *node;
+            }
+
+            std::string_view Head(const Node& list) const
+            {
+                const Node* head = list.isList ? First(list) : nullptr;
+                return (head and not head->isList) ? head->atom : std::string_view();
+            }
+
+        private:
+            void Parse()
+            {
+                std::vector<std::uint32_t> open;
+                std::vector<std::uint32_t> lastChild;
+                std::uint32_t lastTopLevel = NONE;
+
+                auto append = [&](const Node& node) {
+                    const auto index = static_cast<std::uint32_t>(m_nodes.size());
+                    m_nodes.push_back(node);
+                    if (open.empty())
+                    {
+                        if (lastTopLevel != NONE)
+                        {
+                            m_nodes[lastTopLevel].nextSibling = index;
+                        }
+                        lastTopLevel = index;
+                    }
+                    else
+                    {
+                        auto& parent = m_nodes[open.back()];
+                        if (lastChild.back() == NONE)
+                        {
+                            parent.firstChild = index;
+                        }
+                        else
+                        {
+                            m_nodes[lastChild.back()].nextSibling = index;
+                        }
+                        ++parent.childCount;
+                        lastChild.back() = index;
+                    }
+                    return index;
+                };
+
+                const std::size_t size = m_text.size();
+                std::size_t i = 0;
+                while (i < size)
+                {
+                    const char c = m_text[i];
+                    if (std::isspace(static_cast<unsigned char>(c)))
+                    {
+                        ++i;
+                    }
+                    else if (c == ';')
+                    {
+                        while (i < size and m_text[i] != '\n')
+                        {
+                            ++i;
+                        }
+                    }
+                    else if (c == '(')
+                    {
+                        const auto index = append(Node{{}, NONE, NONE, 0, true});
+                        open.push_back(index);
+                        lastChild.push_back(NONE);
+                        ++i;
+                    }
+                    else if (c == ')')
+                    {
+                        if (open.empty())
+                        {
+                            throw HddlError("unbalanced ')'");
+                        }
+                        open.pop_back();
+                        lastChild.pop_back();
+                        ++i;
+                    }
+                    else
+                    {
+                        const std::size_t start = i;
+                        while (i < size and not std::isspace(static_cast<unsigned char>(m_text[i])) and
+                               m_text[i] != '(' and m_text[i] != ')' and m_text[i] != ';')
+                        {
+                            ++i;
+                        }
+                        append(Node{std::string_view(m_text).substr(start, i - start), NONE, NONE, 0, false});
+                    }
+                }
+
+                if (not open.empty())
+                {
+                    throw HddlError("unbalanced '('");
+                }
+            }
+
+            std::string m_text;
+            std::vector<Node> m_nodes;
+        };
+
+        using Node = SExpressionTree::Node;
+        using Variables = std::unordered_map<std::string_view, std::uint32_t>;
+
+        class HddlCompiler
+        {
+        public:
+            explicit HddlCompiler(HddlModel& model) :
+                m_model(model)
+            {
+                m_model.types.Intern("object");
+                m_model.parentType.push_back(INVALID_SYMBOL);
+            }
+
+            void ParseDomain(const SExpressionTree& tree)
+            {
+                const Node& root = tree.Root();
+                ExpectHead(tree, root, "define");
+                const Node& header = tree.At(root, 1);
+                ExpectHead(tree, header, "domain");
+                m_model.domainName = std::string(tree.At(header, 1).atom);
+
+                // Declarations first so that bodies may refer to tasks and actions declared later.
+                for (const Node* section = tree.Next(header); section; section = tree.Next(*section))
+                {
+                    const auto head = tree.Head(*section);
+                    if (head == ":types")
+                    {
+                        ParseTypes(tree, *section);
+                    }
+                    else if (head == ":constants")
+                    {
+                        ParseObjects(tree, *section);
+                    }
+                    else if (head == ":predicates")
+                    {
+                        ParsePredicates(tree, *section);
+                    }
+                    else if (head == ":task")
+                    {
+                        DeclareTask(tree, *section, false);
+                    }
+                    else if (head == ":action")
+                    {
+                        DeclareTask(tree, *section, true);
+                    }
+                }
+
+                for (const Node* section = tree.Next(header); section; section = tree.Next(*section))
+                {
+                    const auto head = tree.Head(*section);
+                    if (head == ":action")
+                    {
+                        ParseAction(tree, *section);
+                    }
+                    else if (head == ":method")
+                    {
+                        ParseMethod(tree, *section);
+                    }
+                }
+            }
+
+            void ParseProblem(const SExpressionTree& tree)
+            {
+                const Node& root = tree.Root();
+                ExpectHead(tree, root, "define");
+                const Node& header = tree.At(root, 1);
+                ExpectHead(tree, header, "problem");
+                m_model.problemName = std::string(tree.At(header, 1).atom);
+
+                for (const Node* section = tree.Next(header); section; section = tree.Next(*section))
+                {
+                    if (tree.Head(*section) == ":objects")
+                    {
+                        ParseObjects(tree, *section);
+                    }
+                }
+
+                BuildFactLayout();
+
+                for (const Node* section = tree.Next(header); section; section = tree.Next(*section))
+                {
+                    const auto head = tree.Head(*section);
+                    if (head == ":init")
+                    {
+                        ParseInit(tree, *section);
+                    }
+                    else if (head == ":htn")
+                    {
+                        ParseInitialTaskNetwork(tree, *section);
+                    }
+                    else if (head == ":goal")
+                    {
+                        BOOST_LOG_TRIVIAL(warning) << "HDDL: state goals are not supported and will be ignored.";
+                    }
+                }
+            }
+
+        private:
+            static void ExpectHead(const SExpressionTree& tree, const Node& node, std::string_view head)
+            {
+                if (tree.Head(node) != head)
+                {
+                    throw HddlError("expected '(" + std::string(head) + " ...)'");
+                }
+            }
+
+            static const Node* Keyword(const SExpressionTree& tree, const Node& section, std::string_view keyword)
+            {
+                for (const Node* node = tree.First(section); node; node = tree.Next(*node))
+                {
+                    if (not node->isList and node->atom == keyword)
+                    {
+                        return tree.Next(*node);
+                    }
+                }
+                return nullptr;
+            }
+
+            SymbolId TypeOf(std::string_view name)
+            {
+                const auto id = m_model.types.Intern(name);
+                if (id >= m_model.parentType.size())
+                {
+                    m_model.parentType.push_back(HddlModel::OBJECT_TYPE);
+                }
+                return id;
+            }
+
+            // Walks "a b - t c" style lists, calling visit(name, type) for every declared name.
+            template <typename Visitor>
+            void ParseTypedList(const SExpressionTree& tree, const Node* node, Visitor visit)
+            {
+                std::vector<std::string_view> pending;
+                while (node)
+                {
+                    if (node->isList)
+                    {
+                        throw HddlError("unsupported construct in typed list");
+                    }
+                    if (node->atom == "-")
+                    {
+                        node = tree.Next(*node);
+                        if (not node or node->isList)
+                        {
+                            throw HddlError("expected a type name after '-'");
+                        }
+                        const auto type = TypeOf(node->atom);
+                        for (const auto& name : pending)
+                        {
+                            visit(name, type);
+                        }
+                        pending.clear();
+                    }
+                    else
+                    {
+                        pending.push_back(node->atom);
+                    }
+                    node = tree.Next(*node);
+                }
+
+                for (const auto& name : pending)
+                {
+                    visit(name, HddlModel::OBJECT_TYPE);
+                }
+            }
+
+            void ParseTypes(const SExpressionTree& tree, const Node& section)
+            {
+                ParseTypedList(tree, tree.Next(*tree.First(section)), [this](std::string_view name, SymbolId parent) {
+                    const auto type = TypeOf(name);
+                    if (type != HddlModel::OBJECT_TYPE)
+                    {
+                        m_model.parentType[type] = parent;
+                    }
+                });
+            }
+
+            void ParseObjects(const SExpressionTree& tree, const Node& section)
+            {
+                ParseTypedList(tree, tree.Next(*tree.First(section)), [this](std::string_view name, SymbolId type) {
+                    const auto object = m_model.objects.Intern(name);
+                    if (object >= m_objectType.size())
+                    {
+                        m_objectType.push_back(type);
+                    }
+                });
+            }
+
+            Variables ParseParameters(const SExpressionTree& tree, const Node* parameters, std::vector<SymbolId>& types)
+            {
+                Variables variables;
+                if (not parameters)
+                {
+                    return variables;
+                }
+                if (not parameters->isList)
+                {
+                    throw HddlError("expected a parameter list");
+                }
+
+                ParseTypedList(tree, tree.First(*parameters), [&](std::string_view name, SymbolId type) {
+                    if (not variables.emplace(name, static_cast<std::uint32_t>(types.size())).second)
+                    {
+                        throw HddlError("duplicate parameter " + std::string(name));
+                    }
+                    types.push_back(type);
+                });
+
+                return variables;
+            }
+
+            void ParsePredicates(const SExpressionTree& tree, const Node& section)
+            {
+                for (const Node* node = tree.Next(*tree.First(section)); node; node = tree.Next(*node))
+                {
+                    if (not node->isList or not tree.First(*node))
+                    {
+                        throw HddlError("malformed predicate declaration");
+                    }
+
+                    const auto predicate = m_model.predicates.Intern(tree.First(*node)->atom);
+                    if (predicate < m_model.predicateTable.size())
+                    {
+                        throw HddlError("duplicate predicate " + std::string(tree.First(*node)->atom));
+                    }
+
+                    HddlPredicate entry;
+                    ParseTypedList(tree, tree.Next(*tree.First(*node)), [&](std::string_view, SymbolId type) {
+                        entry.parameterTypes.push_back(type);
+                    });
+                    entry.offset = 0;
+                    m_model.predicateTable.push_back(std::move(entry));
+                }
+            }
+
+            void DeclareTask(const SExpressionTree& tree, const Node& section, bool primitive)
+            {
+                const auto& name = tree.At(section, 1);
+                const auto task = m_model.tasks.Intern(name.atom);
+                if (task < m_model.taskIsPrimitive.size())
+                {
+                    throw HddlError("duplicate task " + std::string(name.atom));
+                }
+
+                std::vector<SymbolId> types;
+                ParseParameters(tree, Keyword(tree, section, ":parameters"), types);
+                m_model.taskParameterTypes.push_back(std::move(types));
+                m_model.taskIsPrimitive.push_back(primitive);
+            }
+
+            HddlTerm ParseTerm(std::string_view atom, const Variables& variables) const
+            {
+                if (not atom.empty() and atom.front() == '?')
+                {
+                    auto variable = variables.find(atom);
+                    if (variable == variables.end())
+                    {
+                        throw HddlError("undeclared variable " + std::string(atom));
+                    }
+                    return HddlTerm{true, variable->second};
+                }
+
+                auto object = m_model.objects.Find(atom);
+                if (not object)
+                {
+                    throw HddlError("unknown object " + std::string(atom));
+                }
+                return HddlTerm{false, object.value()};
+            }
+
+            std::vector<HddlTerm> ParseArguments(const SExpressionTree& tree, const Node* node, const Variables& variables) const
+            {
+                std::vector<HddlTerm> arguments;
+                for (; node; node = tree.Next(*node))
+                {
+                    if (node->isList)
+                    {
+                        throw HddlError("nested terms are not supported");
+                    }
+                    arguments.push_back(ParseTerm(node->atom, variables));
+                }
+                return arguments;
+            }
+
+            HddlLiteral ParseAtom(const SExpressionTree& tree, const Node& node, const Variables& variables, bool positive) const
+            {
+                const auto head = tree.Head(node);
+                HddlLiteral literal;
+                literal.positive = positive;
+                literal.arguments = ParseArguments(tree, tree.Next(*tree.First(node)), variables);
+
+                if (head == "=")
+                {
+                    if (literal.arguments.size() != 2)
+                    {
+                        throw HddlError("'=' takes two arguments");
+                    }
+                    literal.predicate = HddlModel::EQUALITY;
+                    return literal;
+                }
+
+                auto predicate = m_model.predicates.Find(head);
+                if (not predicate)
+                {
+                    throw HddlError("unsupported construct or unknown predicate '" + std::string(head) + "'");
+                }
+                if (literal.arguments.size() != m_model.predicateTable[predicate.value()].parameterTypes.size())
+                {
+                    throw HddlError("wrong number of arguments for " + std::string(head));
+                }
+                literal.predicate = predicate.value();
+
+                return literal;
+            }
+
+            void ParseCondition(const SExpressionTree& tree, const Node* node, const Variables& variables, std::vector<HddlLiteral>& literals) const
+            {
+                if (not node or (node->isList and not tree.First(*node)))
+                {
+                    return;
+                }
+                if (not node->isList)
+                {
+                    throw HddlError("malformed condition");
+                }
+
+                const auto head = tree.Head(*node);
+                if (head == "and")
+                {
+                    for (const Node* child = tree.Next(*tree.First(*node)); child; child = tree.Next(*child))
+                    {
+                        ParseCondition(tree, child, variables, literals);
+                    }
+                }
+                else if (head == "not")
+                {
+                    literals.push_back(ParseAtom(tree, tree.At(*node, 1), variables, false));
+                }
+                else
+                {
+                    literals.push_back(ParseAtom(tree, *node, variables, true));
+                }
+            }
+
+            void ParseEffect(const SExpressionTree& tree, const Node* node, const Variables& variables, HddlAction& action) const
+            {
+                if (not node or (node->isList and not tree.First(*node)))
+                {
+                    return;
+                }
+                if (not node->isList)
+                {
+                    throw HddlError("malformed effect");
+                }
+
+                const auto head = tree.Head(*node);
+                if (head == "and")
+                {
+                    for (const Node* child = tree.Next(*tree.First(*node)); child; child = tree.Next(*child))
+                    {
+                        ParseEffect(tree, child, variables, action);
+                    }
+                }
+                else if (head == "not")
+                {
+                    action.deleteEffects.push_back(ParseAtom(tree, tree.At(*node, 1), variables, true));
+                }
+                else if (head == "increase" or head == "decrease")
+                {
+                    // action costs are not part of the supported subset
+                }
+                else
+                {
+                    action.addEffects.push_back(ParseAtom(tree, *node, variables, true));
+                }
+            }
+
+            void ParseAction(const SExpressionTree& tree, const Node& section)
+            {
+                HddlAction action;
+                action.task = m_model.tasks.Find(tree.At(section, 1).atom).value();
+
+                const auto variables = ParseParameters(tree, Keyword(tree, section, ":parameters"), action.parameterTypes);
+                ParseCondition(tree, Keyword(tree, section, ":precondition"), variables, action.preconditions);
+                ParseEffect(tree, Keyword(tree, section, ":effect"), variables, action);
+
+                m_model.actions.push_back(std::move(action));
+            }
+
+            HddlTaskReference ParseTaskReference(const SExpressionTree& tree, const Node& node, const Variables& variables) const
+            {
+                const auto head = tree.Head(node);
+                auto task = m_model.tasks.Find(head);
+                if (not task)
+                {
+                    throw HddlError("unknown task " + std::string(head));
+                }
+
+                HddlTaskReference reference{task.value(), ParseArguments(tree, tree.Next(*tree.First(node)), variables)};
+                if (reference.arguments.size() != m_model.taskParameterTypes[task.value()].size())
+                {
+                    throw HddlError("wrong number of arguments for task " + std::string(head));
+                }
+
+                return reference;
+            }
+
+            // Reads (:subtasks/:ordered-subtasks ...) and (:ordering ...) into one total order.
+            std::vector<HddlTaskReference> ParseTaskNetwork(const SExpressionTree& tree, const Node& section, const Variables& variables) const
+            {
+                bool ordered = false;
+                const Node* subtasks = nullptr;
+                for (const auto keyword : {":ordered-subtasks", ":ordered-tasks"})
+                {
+                    if (not subtasks and (subtasks = Keyword(tree, section, keyword)))
+                    {
+                        ordered = true;
+                    }
+                }
+                for (const auto keyword : {":subtasks", ":tasks"})
+                {
+                    if (not subtasks)
+                    {
+                        subtasks = Keyword(tree, section, keyword);
+                    }
+                }
+
+                std::vector<HddlTaskReference> network;
+                std::unordered_map<std::string_view, std::size_t> labels;
+                if (not subtasks or not subtasks->isList or not tree.First(*subtasks))
+                {
+                    return network;
+                }
+
+                auto addSubtask = [&](const Node& node) {
+                    const auto& first = *tree.First(node);
+                    const Node* second = tree.Next(first);
+                    if (not first.isList and second and second->isList and not tree.Next(*second))
+                    {
+                        labels.emplace(first.atom, network.size());
+                        network.push_back(ParseTaskReference(tree, *second, variables));
+                    }
+                    else
+                    {
+                        network.push_back(ParseTaskReference(tree, node, variables));
+                    }
+                };
+
+                if (tree.Head(*subtasks) == "and")
+                {
+                    for (const Node* child = tree.Next(*tree.First(*subtasks)); child; child = tree.Next(*child))
+                    {
+                        addSubtask(*child);
+                    }
+                }
+                else
+                {
+                    addSubtask(*subtasks);
+                }
+
+                const Node* ordering = Keyword(tree, section, ":ordering");
+                if (ordered or not ordering or not ordering->isList or not tree.First(*ordering))
+                {
+                    return network;
+                }
+
+                std::vector<std::pair<std::size_t, std::size_t>> constraints;
+                auto addConstraint = [&](const Node& node) {
+                    if (tree.Head(node) != "<" or node.childCount != 3)
+                    {
+                        throw HddlError("unsupported ordering constraint");
+                    }
+                    auto before = labels.find(tree.At(node, 1).atom);
+                    auto after = labels.find(tree.At(node, 2).atom);
+                    if (before == labels.end() or after == labels.end())
+                    {
+                        throw HddlError("unknown subtask label in ordering");
+                    }
+                    constraints.emplace_back(before->second, after->second);
+                };
+
+                if (tree.Head(*ordering) == "and")
+                {
+                    for (const Node* child = tree.Next(*tree.First(*ordering)); child; child = tree.Next(*child))
+                    {
+                        addConstraint(*child);
+                    }
+                }
+                else
+                {
+                    addConstraint(*ordering);
+                }
+
+                return Linearize(network, constraints);
+            }
+
+            // Partially ordered networks are linearized; ties keep declaration order.
+            static std::vector<HddlTaskReference> Linearize(std::vector<HddlTaskReference>& network,
+                                                            const std::vector<std::pair<std::size_t, std::size_t>>& constraints)
+            {
+                std::vector<std::size_t> predecessors(network.size(), 0);
+                std::vector<std::vector<std::size_t>> successors(network.size());
+                for (const auto& constraint : constraints)
+                {
+                    successors[constraint.first].push_back(constraint.second);
+                    ++predecessors[constraint.second];
+                }
+
+                // Kahn's algorithm; the min-heap of ready indices keeps ties in declaration order
+                std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t>> ready;
+                for (std::size_t task = 0; task < network.size(); ++task)
+                {
+                    if (predecessors[task] == 0)
+                    {
+                        ready.push(task);
+                    }
+                }
+
+                std::vector<HddlTaskReference> linearized;
+                linearized.reserve(network.size());
+                while (not ready.empty())
+                {
+                    const auto next = ready.top();
+                    ready.pop();
+                    for (const auto successor : successors[next])
+                    {
+                        if (--predecessors[successor] == 0)
+                        {
+                            ready.push(successor);
+                        }
+                    }
+                    linearized.push_back(std::move(network[next]));
+                }
+                if (linearized.size() < network.size())
+                {
+                    throw HddlError("cyclic ordering constraints");
+                }
+
+                return linearized;
+            }
+
+            void ParseMethod(const SExpressionTree& tree, const Node& section)
+            {
+                HddlMethod method;
+                method.name = std::string(tree.At(section, 1).atom);
+
+                const auto variables = ParseParameters(tree, Keyword(tree, section, ":parameters"), method.parameterTypes);
+
+                const Node* task = Keyword(tree, section, ":task");
+                if (not task or not task->isList)
+                {
+                    throw HddlError("method " + method.name + " has no task");
+                }
+                auto reference = ParseTaskReference(tree, *task, variables);
+                if (m_model.taskIsPrimitive[reference.task])
+                {
+                    throw HddlError("method " + method.name + " decomposes a primitive task");
+                }
+                method.task = reference.task;
+                method.taskArguments = std::move(reference.arguments);
+
+                ParseCondition(tree, Keyword(tree, section, ":precondition"), variables, method.preconditions);
+                method.subtasks = ParseTaskNetwork(tree, section, variables);
+
+                m_model.methods.push_back(std::move(method));
+            }
+
+            void BuildFactLayout()
+            {
+                const auto typeCount = m_model.types.Size();
+                const auto objectCount = m_model.objects.Size();
+
+                m_model.objectsOfType.assign(typeCount, {});
+                m_model.indexInType.assign(typeCount, std::vector<std::uint32_t>(objectCount, INVALID_SYMBOL));
+
+                for (SymbolId object = 0; object < objectCount; ++object)
+                {
+                    std::size_t depth = 0;
+                    for (SymbolId type = m_objectType[object]; type != INVALID_SYMBOL; type = m_model.parentType[type])
+                    {
+                        if (++depth > typeCount)
+                        {
+                            throw HddlError("cyclic type hierarchy");
+                        }
+                        m_model.indexInType[type][object] = static_cast<std::uint32_t>(m_model.objectsOfType[type].size());
+                        m_model.objectsOfType[type].push_back(object);
+                    }
+                }
+
+                std::uint64_t offset = 0;
+                for (auto& predicate : m_model.predicateTable)
+                {
+                    std::uint64_t size = 1;
+                    predicate.offset = static_cast<FactId>(offset);
+                    predicate.strides.clear();
+                    for (const auto type : predicate.parameterTypes)
+                    {
+                        predicate.strides.push_back(static_cast<FactId>(size));
+                        size *= m_model.objectsOfType[type].size();
+                        if (size > std::numeric_limits<FactId>::max())
+                        {
+                            break;
+                        }
+                    }
+
+                    offset += size;
+                    if (offset > std::numeric_limits<FactId>::max())
+                    {
+                        throw HddlError("too many ground facts");
+                    }
+                }
+
+                m_model.factCount = static_cast<FactId>(offset);
+                m_model.initialState = FactState(m_model.factCount);
+            }
+
+            void ParseInit(const SExpressionTree& tree, const Node& section)
+            {
+                std::vector<SymbolId> arguments;
+                for (const Node* node = tree.Next(*tree.First(section)); node; node = tree.Next(*node))
+                {
+                    const auto head = tree.Head(*node);
+                    if (head == "=")
+                    {
+                        continue;   // numeric fluents are not part of the supported subset
+                    }
+
+                    auto predicate = m_model.predicates.Find(head);
+                    if (not predicate)
+                    {
+                        throw HddlError("unknown predicate " + std::string(head) + " in :init");
+                    }
+
+                    arguments.clear();
+                    for (const Node* argument = tree.Next(*tree.First(*node)); argument; argument = tree.Next(*argument))
+                    {
+                        auto object = m_model.objects.Find(argument->atom);
+                        if (argument->isList or not object)
+                        {
+                            throw HddlError("unknown object in :init");
+                        }
+                        arguments.push_back(object.value());
+                    }
+
+                    auto fact = m_model.FactOf(predicate.value(), arguments);
+                    if (not fact)
+                    {
+                        throw HddlError("ill-typed fact " + std::string(head) + " in :init");
+                    }
+                    m_model.initialState.Set(fact.value());
+                }
+            }
+
+            void ParseInitialTaskNetwork(const SExpressionTree& tree, const Node& section)
+            {
+                const Node* parameters = Keyword(tree, section, ":parameters");
+                if (parameters and (not parameters->isList or tree.First(*parameters)))
+                {
+                    throw HddlError("parameters in the initial task network are not supported");
+                }
+
+                m_model.initialTaskNetwork = ParseTaskNetwork(tree, section, Variables());
+            }
+
+            HddlModel& m_model;
+            std::vector<SymbolId> m_objectType;
+        };
+
+        bool BindParameters(const HddlModel& model, const std::vector<SymbolId>& types, const Parameters& parameters,
+                            std::vector<SymbolId>& bindings)
+        {
+            if (parameters.size() != types.size())
+            {
+                return false;
+            }
+
+            bindings.resize(parameters.size());
+            for (std::size_t i = 0; i < parameters.size(); ++i)
+            {
+                const auto* object = std::any_cast<SymbolId>(&parameters[i]);
+                if (not object)
+                {
+                    return false;
+                }
+                if (*object != INVALID_SYMBOL and
+                    (*object >= model.objects.Size() or model.indexInType[types[i]][*object] == INVALID_SYMBOL))
+                {
+                    return false;
+                }
+                bindings[i] = *object;
+            }
+
+            return true;
+        }
+
+        std::optional<FactId> GroundFact(const HddlModel& model, const HddlLiteral& literal, const std::vector<SymbolId>& bindings)
+        {
+            const auto& predicate = model.predicateTable[literal.predicate];
+            FactId fact = predicate.offset;
+
+            for (std::size_t i = 0; i < literal.arguments.size(); ++i)
+            {
+                const auto& argument = literal.arguments[i];
+                const auto object = argument.isVariable ? bindings[argument.index] : argument.index;
+                const auto index = model.indexInType[predicate.parameterTypes[i]][object];
+                if (index == INVALID_SYMBOL)
+                {
+                    return std::nullopt;
+                }
+                fact += index * predicate.strides[i];
+            }
+
+            return fact;
+        }
+
+        bool Holds(const HddlModel& model, const HddlLiteral& literal, const std::vector<SymbolId>& bindings, const FactState& state)
+        {
+            if (literal.predicate == HddlModel::EQUALITY)
+            {
+                const auto& lhs = literal.arguments[0];
+                const auto& rhs = literal.arguments[1];
+                const bool equal = (lhs.isVariable ? bindings[lhs.index] : lhs.index) ==
+                                   (rhs.isVariable ? bindings[rhs.index] : rhs.index);
+                return equal == literal.positive;
+            }
+
+            const auto fact = GroundFact(model, literal, bindings);
+            const bool value = fact and state.Test(fact.value());
+            return value == literal.positive;
+        }
+
+        std::vector<Task> Decompose(const HddlModel& model, const HddlMethod& method, const std::vector<SymbolId>& bindings)
+        {
+            // the agenda is a stack, so subtasks are returned last-to-first
+            std::vector<Task> subtasks;
+            subtasks.reserve(method.subtasks.size());
+            for (auto subtask = method.subtasks.rbegin(); subtask != method.subtasks.rend(); ++subtask)
+            {
+                subtasks.push_back(model.MakeTask(*subtask, bindings));
+            }
+            return subtasks;
+        }
+
+        // A method with variables that do not occur in its task is compiled into a chain of helper
+        // tasks, one per free variable, with one alternative per object of that variable's type.
+        // Preconditions are checked as soon as all of their variables are bound.
+        struct CompiledMethod
+        {
+            std::vector<std::uint32_t> freeVariables;
+            std::vector<std::vector<std::size_t>> preconditionsAtStep;
+            std::vector<std::string> helperTasks;
+        };
+
+        CompiledMethod CompileMethod(const HddlMethod& method, std::size_t methodIndex)
+        {
+            CompiledMethod compiled;
+            std::vector<std::uint32_t> step(method.parameterTypes.size(), INVALID_SYMBOL);
+
+            for (const auto& argument : method.taskArguments)
+            {
+                if (argument.isVariable)
+                {
+                    step[argument.index] = 0;
+                }
+            }
+            for (std::uint32_t variable = 0; variable < step.size(); ++variable)
+            {
+                if (step[variable] == INVALID_SYMBOL)
+                {
+                    compiled.freeVariables.push_back(variable);
+                    step[variable] = static_cast<std::uint32_t>(compiled.freeVariables.size());
+                    compiled.helperTasks.push_back(method.name + "#" + std::to_string(methodIndex) + "." +
+                                                   std::to_string(compiled.freeVariables.size() - 1));
+                }
+            }
+
+            compiled.preconditionsAtStep.resize(compiled.freeVariables.size() + 1);
+            for (std::size_t i = 0; i < method.preconditions.size(); ++i)
+            {
+                std::uint32_t at = 0;
+                for (const auto& argument : method.preconditions[i].arguments)
+                {
+                    if (argument.isVariable)
+                    {
+                        at = std::max(at, step[argument.index]);
+                    }
+                }
+                compiled.preconditionsAtStep[at].push_back(i);
+            }
+
+            return compiled;
+        }
+
+        std::optional<std::vector<Task>> ContinueMethod(const HddlModel& model, const HddlMethod& method,
+                                                        const CompiledMethod& compiled, std::size_t step,
+                                                        const std::vector<SymbolId>& bindings, const FactState& state)
+        {
+            for (const auto precondition : compiled.preconditionsAtStep[step])
+            {
+                if (not Holds(model, method.preconditions[precondition], bindings, state))
+                {
+                    return std::nullopt;
+                }
+            }
+
+            if (step == compiled.freeVariables.size())
+            {
+                return Decompose(model, method, bindings);
+            }
+
+            Task helper;
+            helper.taskName = compiled.helperTasks[step];
+            helper.parameters.assign(bindings.begin(), bindings.end());
+            return std::vector<Task>{helper};
+        }
+
+        // Objects the domain or problem names directly, which can never be swapped for another object.
+        std::vector<bool> FindConstants(const HddlModel& model)
+        {
+            std::vector<bool> constants(model.objects.Size(), false);
+            auto mark = [&constants](const std::vector<HddlTerm>& terms) {
+                for (const auto& term : terms)
+                {
+                    if (not term.isVariable)
+                    {
+                        constants[term.index] = true;
+                    }
+                }
+            };
+
+            for (const auto& action : model.actions)
+            {
+                for (const auto* literals : {&action.preconditions, &action.addEffects, &action.deleteEffects})
+                {
+                    for (const auto& literal : *literals)
+                    {
+                        mark(literal.arguments);
+                    }
+                }
+            }
+            for (const auto& method : model.methods)
+            {
+                mark(method.taskArguments);
+                for (const auto& literal : method.preconditions)
+                {
+                    mark(literal.arguments);
+                }
+                for (const auto& subtask : method.subtasks)
+                {
+                    mark(subtask.arguments);
+                }
+            }
+            for (const auto& task : model.initialTaskNetwork)
+            {
+                mark(task.arguments);
+            }
+            return constants;
+        }
+
+        // Combines the object's types and every true fact about it, with the object itself replaced by
+        // a placeholder. Two objects with equal signatures can be swapped without changing the state.
+        // The facts about each object are ground once per problem, and signatures are cached per state.
+        class ObjectSignatures
+        {
+        public:
+            explicit ObjectSignatures(std::shared_ptr<const HddlModel> model) :
+                m_model(std::move(model)),
+                m_constants(FindConstants(*m_model))
+            {
+            }
+
+            std::uint64_t operator()(const State& state, SymbolId object) const
+            {
+                if (m_constants[object])
+                {
+                    return ZobristCombine(ZobristKey("constant"), object);
+                }
+
+                std::call_once(m_indexed, [this]() { Index(); });
+
+                const auto* facts = std::any_cast<FactState>(&state.data);
+                if (not facts)
+                {
+                    return m_typeSignatures[object];
+                }
+
+                const auto key = ZobristCombine(facts->Hash(), object);
+                {
+                    std::shared_lock lock(m_mutex);
+                    if (const auto cached = m_cache.find(key); cached != m_cache.end())
+                    {
+                        return cached->second;
+                    }
+                }
+
+                ZobristHash signature = m_typeSignatures[object];
+                for (const auto& [fact, factKey] : m_factsAbout[object])
+                {
+                    if (facts->Test(fact))
+                    {
+                        signature ^= factKey;
+                    }
+                }
+
+                std::unique_lock lock(m_mutex);
+                if (m_cache.size() >= s_maxCached)
+                {
+                    m_cache.clear();
+                }
+                m_cache.emplace(key, signature);
+                return signature;
+            }
+
+        private:
+            static constexpr std::size_t s_maxCached = 1 << 16;
+
+            void Index() const
+            {
+                const auto& model = *m_model;
+                const auto objectCount = model.objects.Size();
+
+                m_typeSignatures.assign(objectCount, 0);
+                for (SymbolId type = 0; type < model.indexInType.size(); ++type)
+                {
+                    for (SymbolId object = 0; object < objectCount; ++object)
+                    {
+                        if (model.indexInType[type][object] != INVALID_SYMBOL)
+                        {
+                            m_typeSignatures[object] ^= ZobristCombine(ZobristKey("type"), type);
+                        }
+                    }
+                }
+
+                m_factsAbout.assign(objectCount, {});
+                std::vector<SymbolId> arguments;
+                for (std::size_t predicate = 0; predicate < model.predicateTable.size(); ++predicate)
+                {
+                    const auto& entry = model.predicateTable[predicate];
+                    const auto end = predicate + 1 < model.predicateTable.size() ? model.predicateTable[predicate + 1].offset
+                                                                                  : static_cast<FactId>(model.factCount);
+                    for (FactId fact = entry.offset; fact < end; ++fact)
+                    {
+                        arguments.clear();
+                        for (std::size_t i = 0; i < entry.parameterTypes.size(); ++i)
+                        {
+                            const auto& objects = model.objectsOfType[entry.parameterTypes[i]];
+                            arguments.push_back(objects[(fact - entry.offset) / entry.strides[i] % objects.size()]);
+                        }
+
+                        for (std::size_t i = 0; i < arguments.size(); ++i)
+                        {
+                            const auto object = arguments[i];
+                            if (m_constants[object] or std::find(arguments.begin(), arguments.begin() + i, object) != arguments.begin() + i)
+                            {
+                                continue;
+                            }
+
+                            ZobristHash key = ZobristKey(static_cast<std::uint64_t>(predicate));
+                            for (const auto argument : arguments)
+                            {
+                                key = ZobristCombine(key, argument == object ? INVALID_SYMBOL : argument);
+                            }
+                            m_factsAbout[object].emplace_back(fact, key);
+                        }
+                    }
+                }
+            }
+
+            std::shared_ptr<const HddlModel> m_model;
+            std::vector<bool> m_constants;
+            mutable std::once_flag m_indexed;
+            mutable std::vector<ZobristHash> m_typeSignatures;
+            mutable std::vector<std::vector<std::pair<FactId, ZobristHash>>> m_factsAbout;  // fact and its key
+            mutable std::shared_mutex m_mutex;
+            mutable std::unordered_map<ZobristHash, ZobristHash> m_cache;                   // state and object
+        };
+    }
+
+    std::shared_ptr<const HddlModel> ParseHddl(const std::string& domainText, const std::string& problemText)
+    {
+        auto model = std::make_shared<HddlModel>();
+
+        try
+        {
+            HddlCompiler compiler(*model);
+            compiler.ParseDomain(SExpressionTree(domainText));
+            compiler.ParseProblem(SExpressionTree(problemText));
+        }
+        catch (const HddlError& e)
+        {
+            BOOST_LOG_TRIVIAL(error) << "HDDL: " << e.what();
+            return nullptr;
+        }
+
+        BOOST_LOG_TRIVIAL(info) << "HDDL: loaded " << model->domainName << "/" << model->problemName << " with "
+                                << model->objects.Size() << " objects, " << model->factCount << " facts, "
+                                << model->actions.size() << " actions and " << model->methods.size() << " methods.";
+
+        return model;
+    }
+
+    std::shared_ptr<const HddlModel> LoadHddlFiles(const std::string& domainPath, const std::string& problemPath)
+    {
+        auto readFile = [](const std::string& path) -> std::optional<std::string> {
+            std::ifstream file(path, std::ios::binary);
+            if (not file)
+            {
+                BOOST_LOG_TRIVIAL(error) << "HDDL: cannot open " << path;
+                return std::nullopt;
+            }
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            return contents.str();
+        };
+
+        const auto domainText = readFile(domainPath);
+        const auto problemText = readFile(problemPath);
+        if (not domainText or not problemText)
+        {
+            return nullptr;
+        }
+
+        return ParseHddl(domainText.value(), problemText.value());
+    }
+
+    PlanningDomain CreatePlanningDomain(const std::shared_ptr<const HddlModel>& model)
+    {
+        PlanningDomain planningDomain(model->domainName);
+        planningDomain.SetStateHashFunction(HashFactState);
+        planningDomain.SetStateSizeFunction(FactStateSize);
+        planningDomain.SetObjectSignatureFunction(
+            [signatures = std::make_shared<const ObjectSignatures>(model)](const State& state, const std::any& object)
+            {
+                return (*signatures)(state, std::any_cast<SymbolId>(object));
+            });
+
+        for (std::size_t i = 0; i < model->actions.size(); ++i)
+        {
+            planningDomain.AddOperator(model->tasks.NameOf(model->actions[i].task),
+                [model, i](const State& state, const Parameters& parameters) -> std::optional<State>
+                {
+                    const auto& action = model->actions[i];
+                    const auto* hddlState = std::any_cast<FactState>(&state.data);
+                    std::vector<SymbolId> bindings;
+
+                    if (not hddlState or not BindParameters(*model, action.parameterTypes, parameters, bindings))
+                    {
+                        return std::nullopt;
+                    }
+
+                    for (const auto& precondition : action.preconditions)
+                    {
+                        if (not Holds(*model, precondition, bindings, *hddlState))
+                        {
+                            return std::nullopt;
+                        }
+                    }
+
+                    State newState(state);
+                    auto& facts = std::any_cast<FactState&>(newState.data);
+                    for (const auto& effect : action.deleteEffects)
+                    {
+                        if (const auto fact = GroundFact(*model, effect, bindings))
+                        {
+                            facts.Set(fact.value(), false);
+                        }
+                    }
+                    for (const auto& effect : action.addEffects)
+                    {
+                        if (const auto fact = GroundFact(*model, effect, bindings))
+                        {
+                            facts.Set(fact.value());
+                        }
+                    }
+
+                    return newState;
+                });
+        }
+
+        for (std::size_t i = 0; i < model->methods.size(); ++i)
+        {
+            const auto& method = model->methods[i];
+            auto compiled = std::make_shared<const CompiledMethod>(CompileMethod(method, i));
+
+            planningDomain.AddMethod(model->tasks.NameOf(method.task),
+                [model, compiled, i](const State& state, const Parameters& parameters) -> std::optional<std::vector<Task>>
+                {
+                    const auto& method = model->methods[i];
+                    const auto* hddlState = std::any_cast<FactState>(&state.data);
+                    std::vector<SymbolId> taskBindings;
+
+                    if (not hddlState or not BindParameters(*model, model->taskParameterTypes[method.task], parameters, taskBindings))
+                    {
+                        return std::nullopt;
+                    }
+
+                    std::vector<SymbolId> bindings(method.parameterTypes.size(), INVALID_SYMBOL);
+                    for (std::size_t j = 0; j < method.taskArguments.size(); ++j)
+                    {
+                        const auto& argument = method.taskArguments[j];
+                        if (not argument.isVariable)
+                        {
+                            if (argument.index != taskBindings[j])
+                            {
+                                return std::nullopt;
+                            }
+                        }
+                        else if (bindings[argument.index] == INVALID_SYMBOL)
+                        {
+                            if (model->indexInType[method.parameterTypes[argument.index]][taskBindings[j]] == INVALID_SYMBOL)
+                            {
+                                return std::nullopt;
+                            }
+                            bindings[argument.index] = taskBindings[j];
+                        }
+                        else if (bindings[argument.index] != taskBindings[j])
+                        {
+                            return std::nullopt;
+                        }
+                    }
+
+                    return ContinueMethod(*model, method, *compiled, 0, bindings, *hddlState);
+                });
+
+            for (std::size_t step = 0; step < compiled->freeVariables.size(); ++step)
+            {
+                const auto variable = compiled->freeVariables[step];
+                const auto& objectsOfType = model->objectsOfType[method.parameterTypes[variable]];
+                planningDomain.AddMethodPerObject(compiled->helperTasks[step], std::vector<std::any>(objectsOfType.begin(), objectsOfType.end()),
+                    [model, compiled, i, step, variable](const State& state, const Parameters& parameters, const std::any& object) -> std::optional<std::vector<Task>>
+                    {
+                        const auto& method = model->methods[i];
+                        const auto* hddlState = std::any_cast<FactState>(&state.data);
+                        std::vector<SymbolId> bindings;
+
+                        if (not hddlState or not BindParameters(*model, method.parameterTypes, parameters, bindings))
+                        {
+                            return std::nullopt;
+                        }
+
+                        bindings[variable] = std::any_cast<SymbolId>(object);
+                        return ContinueMethod(*model, method, *compiled, step + 1, bindings, *hddlState);
+                    });
+            }
+        }
+
+        planningDomain.AddMethod(HDDL_TOP_LEVEL_TASK,
+            [model](const State&, const Parameters&) -> std::optional<std::vector<Task>>
+            {
+                HddlMethod network;
+                network.subtasks = model->initialTaskNetwork;
+                return Decompose(*model, network, {});
+            });
+
+        return planningDomain;
+    }
+
+    PlanningProblem CreatePlanningProblem(const std::shared_ptr<const HddlModel>& model)
+    {
+        State initialState{model->domainName, model->initialState};
+        Task topLevelTask{HDDL_TOP_LEVEL_TASK, {}};
+
+        return PlanningProblem(CreatePlanningDomain(model), initialState, topLevelTask);
+    }
+}
@@ -0,0 +1,102 @@
+#include "lookahead.h"
+
+#include <algorithm>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    SubtaskLookahead::SubtaskLookahead() :
+        m_lookahead(Lookahead::None)
+    {
+    }
+
+    SubtaskLookahead::~SubtaskLookahead() {}
+
+    void SubtaskLookahead::SetMode(Lookahead lookahead)
+    {
+        m_lookahead = lookahead;
+    }
+
+    Lookahead SubtaskLookahead::Mode() const
+    {
+        return m_lookahead;
+    }
+
+    bool SubtaskLookahead::Passes(const PlanningProblem& planningProblem, const State& state, const std::vector<Task>& subtasks)
+    {
+        if (m_lookahead == Lookahead::None)
+        {
+            return true;
+        }
+
+        // the last subtask is the first to run; a later one runs in the same state as far as it reads
+        // nothing written before it, which is only known while every subtask so far has a footprint
+        m_written.clear();
+        bool footprints = true;
+        for (auto subTask = subtasks.rbegin(); subTask != subtasks.rend(); ++subTask)
+        {
+            std::optional<Footprint> footprint;
+            if (m_lookahead == Lookahead::Independent and footprints)
+            {
+                footprint = planningProblem.TaskFootprint(state, *subTask);
+            }
+            const bool unchanged = subTask == subtasks.rbegin() or
+                (footprint and std::none_of(footprint->reads.begin(), footprint->reads.end(), [this](const std::string& field) {
+                    return std::find(m_written.begin(), m_written.end(), field) != m_written.end();
+                }));
+
+            if (unchanged and not OperatorsMayApply(planningProblem, state, *subTask, subTask == subtasks.rbegin()))
+            {
+                return false;
+            }
+            if (not planningProblem.FindOperators(subTask->taskName) and not planningProblem.FindMethods(subTask->taskName))
+            {
+                BOOST_LOG_TRIVIAL(trace) << "SubtaskLookahead: " << subTask->taskName << " has no operators or methods.";
+                return false;
+            }
+            if (m_lookahead == Lookahead::FirstSubtask)
+            {
+                return true;
+            }
+
+            if (footprint)
+            {
+                m_written.insert(m_written.end(), footprint->writes.begin(), footprint->writes.end());
+            }
+            footprints = footprints and footprint;
+        }
+        return true;
+    }
+
+    bool SubtaskLookahead::OperatorsMayApply(const PlanningProblem& planningProblem, const State& state, const Task& task,
+                                             bool runsNext)
+    {
+        const auto guards = planningProblem.FindOperatorGuards(task.taskName);
+        if (guards)
+        {
+            guards->Select(state, task.parameters, m_selection);
+            if (m_selection.alternatives.empty())
+            {
+                BOOST_LOG_TRIVIAL(trace) << "SubtaskLookahead: No operator of " << task.taskName << " is applicable.";
+                return false;
+            }
+            return true;
+        }
+
+        // operators may read more than their footprints, so only the subtask that runs next, and so
+        // runs in this very state, is checked by applying them
+        const auto operators = planningProblem.FindOperators(task.taskName);
+        if (not runsNext or not operators or planningProblem.FindMethods(task.taskName))
+        {
+            return true;
+        }
+        if (std::none_of(operators->begin(), operators->end(), [&](const OperatorFunction& _operator) {
+                return _operator(state, task.parameters).has_value();
+            }))
+        {
+            BOOST_LOG_TRIVIAL(trace) << "SubtaskLookahead: No operator of " << task.taskName << " applies.";
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,413 @@
+#include "metrics.h"
+#include "tfd.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    namespace
+    {
+        const std::vector<double> SECONDS_BUCKETS = ExponentialBuckets(1e-6, 4.0, 13);    // 1us to about 17s
+        const std::vector<double> NODES_BUCKETS = ExponentialBuckets(1.0, 10.0, 9);        // 1 to 10^8
+
+        bool IsValidName(const std::string& name)
+        {
+            if (name.empty() or std::isdigit(static_cast<unsigned char>(name[0])))
+            {
+                return false;
+            }
+            return std::all_of(name.begin(), name.end(), [](char character) {
+                return std::isalnum(static_cast<unsigned char>(character)) or character == '_' or character == ':';
+            });
+        }
+
+        std::string FormatValue(double value)
+        {
+            if (std::isinf(value))
+            {
+                return value > 0 ? "+Inf" : "-Inf";
+            }
+            if (std::isnan(value))
+            {
+                return "NaN";
+            }
+            std::ostringstream stream;
+            stream.precision(std::numeric_limits<double>::max_digits10);
+            stream << value;
+            return stream.str();
+        }
+
+        std::string Escape(const std::string& text, bool escapeQuotes)
+        {
+            std::string escaped;
+            for (const char character : text)
+            {
+                if (character == '\\')
+                {
+                    escaped += "\\\\";
+                }
+                else if (character == '\n')
+                {
+                    escaped += "\\n";
+                }
+                else if (character == '"' and escapeQuotes)
+                {
+                    escaped += "\\\"";
+                }
+                else
+                {
+                    escaped += character;
+                }
+            }
+            return escaped;
+        }
+
+        // {a="x",b="y"}, with an extra label such as le appended; empty without labels
+        std::string FormatLabels(const MetricLabels& labels, const std::string& extraName = "", const std::string& extraValue = "")
+        {
+            MetricLabels all(labels);
+            if (not extraName.empty())
+            {
+                all.emplace_back(extraName, extraValue);
+            }
+            if (all.empty())
+            {
+                return "";
+            }
+
+            std::string formatted = "{";
+            for (const auto& [name, value] : all)
+            {
+                if (formatted.size() > 1)
+                {
+                    formatted += ",";
+                }
+                formatted += name + "=\"" + Escape(value, true) + "\"";
+            }
+            return formatted + "}";
+        }
+    }
+
+    Counter::Counter() :
+        m_value(0)
+    {
+    }
+
+    Counter::~Counter() {}
+
+    void Counter::Increment(std::uint64_t amount)
+    {
+        m_value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Counter::Value() const
+    {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+    Histogram::Histogram(const std::vector<double>& upperBounds) :
+        m_upperBounds(upperBounds),
+        m_buckets(upperBounds.size() + 1),
+        m_sumBits(0)
+    {
+        static_assert(sizeof(double) == sizeof(std::uint64_t));
+        const double zero = 0.0;
+        std::uint64_t bits;
+        std::memcpy(&bits, &zero, sizeof(bits));
+        m_sumBits.store(bits);
+    }
+
+    Histogram::~Histogram() {}
+
+    void Histogram::Observe(double value)
+    {
+        const auto bucket = std::lower_bound(m_upperBounds.begin(), m_upperBounds.end(), value) - m_upperBounds.begin();
+        m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+        std::uint64_t expected = m_sumBits.load(std::memory_order_relaxed);
+        std::uint64_t desired;
+        do
+        {
+            double sum;
+            std::memcpy(&sum, &expected, sizeof(sum));
+            sum += value;
+            std::memcpy(&desired, &sum, sizeof(desired));
+        } while (not m_sumBits.compare_exchange_weak(expected, desired, std::memory_order_relaxed));
+    }
+
+    const std::vector<double>& Histogram::UpperBounds() const
+    {
+        return m_upperBounds;
+    }
+
+    std::vector<std::uint64_t> Histogram::BucketCounts() const
+    {
+        std::vector<std::uint64_t> counts;
+        for (const auto& bucket : m_buckets)
+        {
+            counts.push_back(bucket.load(std::memory_order_relaxed));
+        }
+        return counts;
+    }
+
+    std::uint64_t Histogram::Count() const
+    {
+        std::uint64_t count = 0;
+        for (const auto& bucket : m_buckets)
+        {
+            count += bucket.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    double Histogram::Sum() const
+    {
+        const std::uint64_t bits = m_sumBits.load(std::memory_order_relaxed);
+        double sum;
+        std::memcpy(&sum, &bits, sizeof(sum));
+        return sum;
+    }
+
+    std::vector<double> ExponentialBuckets(double start, double factor, std::size_t count)
+    {
+        std::vector<double> bounds;
+        for (double bound = start; bounds.size() < count; bound *= factor)
+        {
+            bounds.push_back(bound);
+        }
+        return bounds;
+    }
+
+    MetricsRegistry::MetricsRegistry() {}
+
+    MetricsRegistry::~MetricsRegistry() {}
+
+    MetricsRegistry::Family* MetricsRegistry::GetFamily(const std::string& name, const std::string& help, bool isHistogram)
+    {
+        if (not IsValidName(name))
+        {
+            BOOST_LOG_TRIVIAL(error) << "MetricsRegistry: " << name << " is not a valid metric name.";
+            return nullptr;
+        }
+
+        auto family = m_families.find(name);
+        if (family == m_families.end())
+        {
+            family = m_families.emplace(name, Family{help, isHistogram, {}, {}}).first;
+        }
+        else if (family->second.isHistogram != isHistogram)
+        {
+            BOOST_LOG_TRIVIAL(error) << "MetricsRegistry: " << name << " is already registered with another type.";
+            return nullptr;
+        }
+        return &family->second;
+    }
+
+    Counter* MetricsRegistry::GetCounter(const std::string& name, const std::string& help, const MetricLabels& labels)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            const auto family = m_families.find(name);
+            if (family != m_families.end() and not family->second.isHistogram)
+            {
+                const auto counter = family->second.counters.find(labels);
+                if (counter != family->second.counters.end())
+                {
+                    return counter->second.get();
+                }
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        auto family = GetFamily(name, help, false);
+        if (not family)
+        {
+            return nullptr;
+        }
+        auto& counter = family->counters[labels];
+        if (not counter)
+        {
+            counter = std::make_unique<Counter>();
+        }
+        return counter.get();
+    }
+
+    Histogram* MetricsRegistry::GetHistogram(const std::string& name, const std::string& help, const std::vector<double>& upperBounds,
+                                             const MetricLabels& labels)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            const auto family = m_families.find(name);
+            if (family != m_families.end() and family->second.isHistogram)
+            {
+                const auto histogram = family->second.histograms.find(labels);
+                if (histogram != family->second.histograms.end())
+                {
+                    return histogram->second.get();
+                }
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        auto family = GetFamily(name, help, true);
+        if (not family)
+        {
+            return nullptr;
+        }
+        auto& histogram = family->histograms[labels];
+        if (not histogram)
+        {
+            histogram = std::make_unique<Histogram>(upperBounds);
+        }
+        return histogram.get();
+    }
+
+    std::string MetricsRegistry::Render() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        std::ostringstream stream;
+
+        for (const auto& [name, family] : m_families)
+        {
+            stream << "# HELP " << name << " " << Escape(family.help, false) << "\n";
+            stream << "# TYPE " << name << " " << (family.isHistogram ? "histogram" : "counter") << "\n";
+
+            for (const auto& [labels, counter] : family.counters)
+            {
+                stream << name << FormatLabels(labels) << " " << counter->Value() << "\n";
+            }
+
+            for (const auto& [labels, histogram] : family.histograms)
+            {
+                // the count is the sum of the buckets read here, so the two always agree
+                const auto counts = histogram->BucketCounts();
+                const auto& upperBounds = histogram->UpperBounds();
+                std::uint64_t cumulative = 0;
+                for (std::size_t bucket = 0; bucket < counts.size(); ++bucket)
+                {
+                    cumulative += counts[bucket];
+                    const double upperBound = (bucket < upperBounds.size()) ? upperBounds[bucket]
+                                                                            : std::numeric_limits<double>::infinity();
+                    stream << name << "_bucket" << FormatLabels(labels, "le", FormatValue(upperBound)) << " " << cumulative << "\n";
+                }
+                stream << name << "_sum" << FormatLabels(labels) << " " << FormatValue(histogram->Sum()) << "\n";
+                stream << name << "_count" << FormatLabels(labels) << " " << cumulative << "\n";
+            }
+        }
+
+        return stream.str();
+    }
+
+    bool MetricsRegistry::WriteToFile(const std::string& path) const
+    {
+        const std::string temporaryPath = path + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::trunc);
+            if (not file)
+            {
+                BOOST_LOG_TRIVIAL(error) << "MetricsRegistry: Unable to write " << temporaryPath;
+                return false;
+            }
+            file << Render();
+            if (not file)
+            {
+                BOOST_LOG_TRIVIAL(error) << "MetricsRegistry: Unable to write " << temporaryPath;
+                return false;
+            }
+        }
+
+        if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+        {
+            BOOST_LOG_TRIVIAL(error) << "MetricsRegistry: Unable to replace " << path;
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    PlannerMetrics::PlannerMetrics(MetricsRegistry& registry) :
+        m_registry(registry),
+        m_searchDuration(registry.GetHistogram("tfd_search_duration_seconds", "Wall-clock time of a search.", SECONDS_BUCKETS)),
+        m_nodesExpanded(registry.GetHistogram("tfd_search_nodes_expanded", "Nodes expanded by a search.", NODES_BUCKETS))
+    {
+        // in the order of SearchStatus
+        for (const auto status : {"solved", "optimal", "no_plan", "timeout", "memory_exceeded", "cancelled"})
+        {
+            m_searches.push_back(registry.GetCounter("tfd_searches_total", "Searches by outcome.", {{"status", status}}));
+        }
+    }
+
+    PlannerMetrics::~PlannerMetrics() {}
+
+    void PlannerMetrics::RecordSearch(const SearchResult& result, std::chrono::steady_clock::duration duration)
+    {
+        if (m_searchDuration)
+        {
+            m_searchDuration->Observe(std::chrono::duration<double>(duration).count());
+        }
+        if (m_nodesExpanded)
+        {
+            m_nodesExpanded->Observe(static_cast<double>(result.nodesExpanded));
+        }
+        if (auto searches = m_searches[static_cast<std::size_t>(result.status)])
+        {
+            searches->Increment();
+        }
+    }
+
+    Histogram* PlannerMetrics::CallbackDuration(const std::string& taskName)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(m_callbackMutex);
+            const auto histogram = m_callbackDurations.find(taskName);
+            if (histogram != m_callbackDurations.end())
+            {
+                return histogram->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_callbackMutex);
+        auto& histogram = m_callbackDurations[taskName];
+        if (not histogram)
+        {
+            histogram = m_registry.GetHistogram("tfd_callback_duration_seconds", "Time spent in the methods and operators of a task.",
+                                                SECONDS_BUCKETS, {{"task", taskName}});
+        }
+        return histogram;
+    }
+
+    void PlannerMetrics::RecordPortfolioWinner(const std::string& configuration)
+    {
+        if (auto wins = m_registry.GetCounter("tfd_portfolio_wins_total", "Portfolio searches decided by each configuration.",
+                                              {{"configuration", configuration}}))
+        {
+            wins->Increment();
+        }
+    }
+
+    ScopedTimer::ScopedTimer(Histogram* histogram) :
+        m_histogram(histogram)
+    {
+        if (m_histogram)
+        {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ScopedTimer::~ScopedTimer()
+    {
+        if (m_histogram)
+        {
+            m_histogram->Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#include "plan_schedule.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    namespace
+    {
+        // Resource that undeclared steps write and every declared step reads.
+        const std::string EVERYTHING = "*";
+
+        struct ResourceUse
+        {
+            std::optional<std::size_t> lastWriter;
+            std::vector<std::size_t> readersSinceWrite;
+        };
+
+        void AddEdge(std::vector<std::size_t>& predecessors, std::size_t step)
+        {
+            if (std::find(predecessors.begin(), predecessors.end(), step) == predecessors.end())
+            {
+                predecessors.push_back(step);
+            }
+        }
+    }
+
+    std::optional<ParallelSchedule> DeorderPlan(const PlanningProblem& planningProblem, const Plan& plan,
+                                                const StepDurationFunction& stepDuration)
+    {
+        ParallelSchedule schedule;
+        schedule.predecessors.resize(plan.size());
+        schedule.levelOfStep.resize(plan.size(), 0);
+        schedule.earliestStart.resize(plan.size(), 0.0);
+
+        std::unordered_map<std::string, ResourceUse> resources;
+        State currentState = planningProblem.GetInitialState();
+
+        for (std::size_t step = 0; step < plan.size(); ++step)
+        {
+            const auto& planStep = plan[step];
+            auto footprint = planningProblem.TaskFootprint(currentState, planStep.task);
+            if (not footprint)
+            {
+                footprint = Footprint{{}, {EVERYTHING}};
+            }
+            else
+            {
+                footprint.value().reads.push_back(EVERYTHING);
+            }
+
+            auto& predecessors = schedule.predecessors[step];
+            for (const auto& resource : footprint.value().reads)
+            {
+                auto& use = resources[resource];
+                if (use.lastWriter)
+                {
+                    AddEdge(predecessors, use.lastWriter.value());
+                }
+                use.readersSinceWrite.push_back(step);
+            }
+            for (const auto& resource : footprint.value().writes)
+            {
+                auto& use = resources[resource];
+                if (use.lastWriter)
+                {
+                    AddEdge(predecessors, use.lastWriter.value());
+                }
+                for (const auto reader : use.readersSinceWrite)
+                {
+                    if (reader != step)
+                    {
+                        AddEdge(predecessors, reader);
+                    }
+                }
+                use.lastWriter = step;
+                use.readersSinceWrite.clear();
+            }
+
+            auto successor = planStep.func(currentState, planStep.task.parameters);
+            if (not successor)
+            {
+                BOOST_LOG_TRIVIAL(warning) << "DeorderPlan: step " << step << " (" << planStep.task.taskName << ") is not applicable.";
+                return std::nullopt;
+            }
+            currentState = std::move(successor.value());
+        }
+
+        for (std::size_t step = 0; step < plan.size(); ++step)
+        {
+            std::size_t level = 0;
+            double start = 0.0;
+            for (const auto predecessor : schedule.predecessors[step])
+            {
+                const double duration = stepDuration ? stepDuration(plan[predecessor]) : 1.0;
+                level = std::max(level, schedule.levelOfStep[predecessor] + 1);
+                start = std::max(start, schedule.earliestStart[predecessor] + duration);
+            }
+            std::sort(schedule.predecessors[step].begin(), schedule.predecessors[step].end());
+
+            schedule.levelOfStep[step] = level;
+            schedule.earliestStart[step] = start;
+            if (schedule.levels.size() <= level)
+            {
+                schedule.levels.resize(level + 1);
+            }
+            schedule.levels[level].push_back(step);
+
+            const double duration = stepDuration ? stepDuration(plan[step]) : 1.0;
+            schedule.criticalPathLength = std::max(schedule.criticalPathLength, start + duration);
+        }
+
+        return schedule;
+    }
+}
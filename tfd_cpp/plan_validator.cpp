@@ -0,0 +1,116 @@
+#include "plan_validator.h"
+#include "trail.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    namespace
+    {
+        // The in-place operator a plan step stands for; only certain when the task has one operator.
+        const InPlaceOperatorFunction* SingleInPlaceOperator(const PlanningProblem& planningProblem, const std::string& taskName)
+        {
+            const auto operators = planningProblem.FindOperators(taskName);
+            const auto inPlaceOperators = planningProblem.FindInPlaceOperators(taskName);
+            if (not operators or operators->size() != 1 or not inPlaceOperators or inPlaceOperators->empty() or
+                not inPlaceOperators->front())
+            {
+                return nullptr;
+            }
+            return &inPlaceOperators->front();
+        }
+
+        PlanValidation Validate(const PlanningProblem& planningProblem, const State& initialState, const Plan& plan,
+                                const ValidationOptions& options, Trail& trail)
+        {
+            PlanValidation validation;
+            State state(initialState);
+            for (const auto& step : plan)
+            {
+                const auto& task = step.task;
+                const double cost = planningProblem.OperatorCost(state, task);
+                const auto inPlaceOperator = options.inPlace ? SingleInPlaceOperator(planningProblem, task.taskName) : nullptr;
+                bool applied;
+                if (inPlaceOperator)
+                {
+                    // nothing is backtracked over, so the trail only rolls back a failed step
+                    applied = (*inPlaceOperator)(state, task.parameters, trail);
+                    if (not applied)
+                    {
+                        trail.UndoTo(state, 0);
+                    }
+                    trail.Clear();
+                }
+                else
+                {
+                    auto successor = step.func(state, task.parameters);
+                    applied = successor.has_value();
+                    if (applied)
+                    {
+                        state = std::move(successor.value());
+                    }
+                }
+
+                if (not applied)
+                {
+                    BOOST_LOG_TRIVIAL(info) << "ValidatePlan: Step " << validation.stepsApplied << " (" << task.taskName
+                                            << ") is not applicable.";
+                    break;
+                }
+                validation.cost += cost;
+                ++validation.stepsApplied;
+            }
+
+            validation.valid = validation.stepsApplied == plan.size();
+            if (options.keepFinalState)
+            {
+                validation.finalState = std::move(state);
+            }
+            return validation;
+        }
+    }
+
+    PlanValidation ValidatePlan(const PlanningProblem& planningProblem, const State& initialState, const Plan& plan,
+                                const ValidationOptions& options)
+    {
+        Trail trail;
+        return Validate(planningProblem, initialState, plan, options, trail);
+    }
+
+    std::vector<PlanValidation> ValidatePlans(const PlanningProblem& planningProblem, const State& initialState,
+                                              const std::vector<Plan>& plans, const ValidationOptions& options)
+    {
+        std::vector<PlanValidation> validations(plans.size());
+        std::atomic<std::size_t> nextPlan(0);
+        auto validatePlans = [&]()
+        {
+            // one trail per thread, warmed up by its first plans
+            Trail trail;
+            for (auto plan = nextPlan++; plan < plans.size(); plan = nextPlan++)
+            {
+                validations[plan] = Validate(planningProblem, initialState, plans[plan], options, trail);
+            }
+        };
+
+        std::size_t threads = options.threads;
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, plans.size());
+        std::vector<std::thread> pool;
+        for (std::size_t thread = 1; thread < threads; ++thread)
+        {
+            pool.emplace_back(validatePlans);
+        }
+        validatePlans();
+        for (auto& thread : pool)
+        {
+            thread.join();
+        }
+        return validations;
+    }
+}
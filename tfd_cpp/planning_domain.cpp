@@ -1,14 +1,23 @@
 #include "planning_domain.h"
+#include "trail.h"
+
+#include <boost/log/trivial.hpp>
 
 namespace tfd_cpp {
 
     PlanningDomain::PlanningDomain(const std::string& domainName) : 
-        m_domainName(domainName) {}
+        m_domainName(domainName),
+        m_objectGroups(0) {}
 
     PlanningDomain::~PlanningDomain() {}
 
-    void PlanningDomain::AddOperator(const std::string& taskName, const OperatorFunction& operatorFunc)
+    void PlanningDomain::AddOperator(const std::string& taskName, const OperatorFunction& operatorFunc, const std::vector<Guard>& guards)
     {
+        if (not CheckGuards(guards))
+        {
+            return;
+        }
+
         auto operators = m_operatorTable.find(taskName);
 
         if (operators == m_operatorTable.end())
@@ -19,10 +28,41 @@ namespace tfd_cpp {
         {
             operators->second.push_back(operatorFunc);
         }
+
+        IndexGuards(m_operatorGuardTable, taskName, m_operatorTable[taskName].size() - 1, guards);
     }
 
-    void PlanningDomain::AddMethod(const std::string& taskName, const MethodFunction& methodFunc)
+    void PlanningDomain::AddInPlaceOperator(const std::string& taskName, const InPlaceOperatorFunction& operatorFunc,
+                                            const std::vector<Guard>& guards)
     {
+        if (not CheckGuards(guards))
+        {
+            return;
+        }
+
+        AddOperator(taskName, [operatorFunc](const State& currentState, const Parameters& parameters) -> std::optional<State>
+        {
+            State newState(currentState);
+            Trail trail;
+            if (not operatorFunc(newState, parameters, trail))
+            {
+                return std::nullopt;
+            }
+            return newState;
+        }, guards);
+
+        auto& inPlaceOperators = m_inPlaceOperatorTable[taskName];
+        inPlaceOperators.resize(m_operatorTable[taskName].size() - 1);
+        inPlaceOperators.push_back(operatorFunc);
+    }
+
+    void PlanningDomain::AddMethod(const std::string& taskName, const MethodFunction& methodFunc, const std::vector<Guard>& guards)
+    {
+        if (not CheckGuards(guards))
+        {
+            return;
+        }
+
         auto methods = m_methodTable.find(taskName);
 
         if (methods == m_methodTable.end())
@@ -33,6 +73,109 @@ namespace tfd_cpp {
         {
             methods->second.push_back(methodFunc);
         }
+
+        IndexGuards(m_methodGuardTable, taskName, m_methodTable[taskName].size() - 1, guards);
+    }
+
+    void PlanningDomain::AddGuardField(const std::string& fieldName, const GuardFieldFunction& fieldFunc)
+    {
+        m_guardFieldTable[fieldName] = fieldFunc;
+    }
+
+    bool PlanningDomain::CheckGuards(const std::vector<Guard>& guards) const
+    {
+        for (const auto& guard : guards)
+        {
+            if (m_guardFieldTable.find(guard.field) == m_guardFieldTable.end())
+            {
+                BOOST_LOG_TRIVIAL(error) << "CheckGuards: No guard field named " << guard.field << ".";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void PlanningDomain::IndexGuards(std::map<std::string, GuardIndex>& guardTable, const std::string& taskName,
+                                     std::size_t alternative, const std::vector<Guard>& guards)
+    {
+        auto guardIndex = guardTable.find(taskName);
+        if (guardIndex == guardTable.end())
+        {
+            // tasks without any guards keep the plain loop over their alternatives
+            if (guards.empty())
+            {
+                return;
+            }
+
+            guardIndex = guardTable.emplace(taskName, GuardIndex()).first;
+            for (std::size_t unguarded = 0; unguarded < alternative; ++unguarded)
+            {
+                guardIndex->second.Add(unguarded, {});
+            }
+        }
+
+        for (const auto& guard : guards)
+        {
+            guardIndex->second.AddField(guard.field, m_guardFieldTable.at(guard.field));
+        }
+        guardIndex->second.Add(alternative, guards);
+    }
+
+    void PlanningDomain::SetSignature(const std::string& taskName, const ParameterTypes& parameterTypes)
+    {
+        m_signatureTable[taskName] = parameterTypes;
+    }
+
+    void PlanningDomain::SetStateHashFunction(const StateHashFunction& stateHashFunc)
+    {
+        m_stateHashFunction = stateHashFunc;
+    }
+
+    void PlanningDomain::AddMethodPerObject(const std::string& taskName, const std::vector<std::any>& objects,
+                                            const ObjectMethodFunction& methodFunc)
+    {
+        const std::size_t group = m_objectGroups++;
+        for (const auto& object : objects)
+        {
+            AddMethod(taskName, [methodFunc, object](const State& currentState, const Parameters& parameters)
+            {
+                return methodFunc(currentState, parameters, object);
+            });
+
+            auto& boundObjects = m_boundObjectTable[taskName];
+            boundObjects.resize(m_methodTable[taskName].size() - 1);
+            boundObjects.push_back(BoundObject{group, object});
+        }
+    }
+
+    void PlanningDomain::SetObjectSignatureFunction(const ObjectSignatureFunction& objectSignatureFunc)
+    {
+        m_objectSignatureFunction = objectSignatureFunc;
+    }
+
+    void PlanningDomain::SetStateSizeFunction(const StateSizeFunction& stateSizeFunc)
+    {
+        m_stateSizeFunction = stateSizeFunc;
+    }
+
+    void PlanningDomain::SetOperatorCost(const std::string& taskName, const CostFunction& costFunc)
+    {
+        m_costTable[taskName] = costFunc;
+    }
+
+    void PlanningDomain::SetTaskLowerBound(const std::string& taskName, const CostFunction& lowerBoundFunc)
+    {
+        m_lowerBoundTable[taskName] = lowerBoundFunc;
+    }
+
+    void PlanningDomain::SetTaskFootprint(const std::string& taskName, const FootprintFunction& footprintFunc)
+    {
+        m_footprintTable[taskName] = footprintFunc;
+    }
+
+    void PlanningDomain::SetTaskProjection(const std::string& taskName, const StateProjectionFunction& projectionFunc)
+    {
+        m_projectionTable[taskName] = projectionFunc;
     }
 
     std::optional<OperatorsWithParams> PlanningDomain::GetApplicableOperators(const State& currentState, const Task& task) const
@@ -44,18 +187,24 @@ namespace tfd_cpp {
             return std::nullopt;
         }
 
-        for (const auto& element : m_operatorTable)
+        const auto operators = FindOperators(task.taskName);
+        if (operators)
         {
-            if (element.first == task.taskName)
+            const auto guards = FindOperatorGuards(task.taskName);
+            GuardSelection selection;
+            if (guards)
             {
-                for (const auto& _operator : element.second)
+                guards->Select(currentState, task.parameters, selection);
+            }
+
+            const auto alternatives = guards ? selection.alternatives.size() : operators->size();
+            for (std::size_t alternative = 0; alternative < alternatives; ++alternative)
+            {
+                const auto& _operator = (*operators)[guards ? selection.alternatives[alternative] : alternative];
+                if (_operator(currentState, task.parameters))
                 {
-                    if (_operator(currentState, task.parameters))
-                    {
-                        operatorsWithParams.emplace_back(task, _operator);
-                    }
+                    operatorsWithParams.emplace_back(task, _operator);
                 }
-                break;
             }
         }
 
@@ -70,25 +219,72 @@ namespace tfd_cpp {
         {
             return std::nullopt;
         }
-        
-        for (const auto& element : m_methodTable)
+
+        const auto methods = FindMethods(task.taskName);
+        if (methods)
         {
-            if (element.first == task.taskName)
+            const auto guards = FindMethodGuards(task.taskName);
+            GuardSelection selection;
+            if (guards)
+            {
+                guards->Select(currentState, task.parameters, selection);
+            }
+
+            const auto alternatives = guards ? selection.alternatives.size() : methods->size();
+            for (std::size_t alternative = 0; alternative < alternatives; ++alternative)
             {
-                for (const auto& method : element.second)
+                const auto& method = (*methods)[guards ? selection.alternatives[alternative] : alternative];
+                if (method(currentState, task.parameters))
                 {
-                    if (method(currentState, task.parameters))
-                    {
-                        methodsWithParams.emplace_back(task, method);
-                    }
+                    methodsWithParams.emplace_back(task, method);
                 }
-                break;
             }
         }
 
         return methodsWithParams;
     }
 
+    const Operators* PlanningDomain::FindOperators(const std::string& taskName) const
+    {
+        auto operators = m_operatorTable.find(taskName);
+        return operators == m_operatorTable.end() ? nullptr : &operators->second;
+    }
+
+    const Methods* PlanningDomain::FindMethods(const std::string& taskName) const
+    {
+        auto methods = m_methodTable.find(taskName);
+        return methods == m_methodTable.end() ? nullptr : &methods->second;
+    }
+
+    const InPlaceOperators* PlanningDomain::FindInPlaceOperators(const std::string& taskName) const
+    {
+        auto inPlaceOperators = m_inPlaceOperatorTable.find(taskName);
+        return inPlaceOperators == m_inPlaceOperatorTable.end() ? nullptr : &inPlaceOperators->second;
+    }
+
+    const BoundObjects* PlanningDomain::FindBoundObjects(const std::string& taskName) const
+    {
+        if (not m_objectSignatureFunction)
+        {
+            return nullptr;
+        }
+
+        auto boundObjects = m_boundObjectTable.find(taskName);
+        return boundObjects == m_boundObjectTable.end() ? nullptr : &boundObjects->second;
+    }
+
+    const GuardIndex* PlanningDomain::FindOperatorGuards(const std::string& taskName) const
+    {
+        auto guards = m_operatorGuardTable.find(taskName);
+        return guards == m_operatorGuardTable.end() ? nullptr : &guards->second;
+    }
+
+    const GuardIndex* PlanningDomain::FindMethodGuards(const std::string& taskName) const
+    {
+        auto guards = m_methodGuardTable.find(taskName);
+        return guards == m_methodGuardTable.end() ? nullptr : &guards->second;
+    }
+
     bool PlanningDomain::TaskIsOperator(const std::string& taskName) const
     {
         return (m_operatorTable.find(taskName) != m_operatorTable.end());
@@ -99,6 +295,115 @@ namespace tfd_cpp {
         return (m_methodTable.find(taskName) != m_methodTable.end());
     }
 
+    bool PlanningDomain::CheckTask(const Task& task) const
+    {
+        auto signature = m_signatureTable.find(task.taskName);
+        if (signature == m_signatureTable.end())
+        {
+            return true;
+        }
+
+        const auto& parameterTypes = signature->second;
+        if (task.parameters.size() != parameterTypes.size())
+        {
+            BOOST_LOG_TRIVIAL(error) << "CheckTask: " << task.taskName << " takes " << parameterTypes.size()
+                                     << " parameters, got " << task.parameters.size() << ".";
+            return false;
+        }
+
+        for (std::size_t parameter = 0; parameter < parameterTypes.size(); ++parameter)
+        {
+            if (std::type_index(task.parameters[parameter].type()) != parameterTypes[parameter])
+            {
+                BOOST_LOG_TRIVIAL(error) << "CheckTask: parameter " << parameter << " of " << task.taskName << " should be "
+                                         << parameterTypes[parameter].name() << ", got " << task.parameters[parameter].type().name() << ".";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool PlanningDomain::HasSignatures() const
+    {
+        return not m_signatureTable.empty();
+    }
+
+    std::optional<std::uint64_t> PlanningDomain::HashState(const State& state) const
+    {
+        if (not m_stateHashFunction)
+        {
+            return std::nullopt;
+        }
+
+        return m_stateHashFunction(state);
+    }
+
+    std::size_t PlanningDomain::StateSize(const State& state) const
+    {
+        const std::size_t size = sizeof(State) + state.domainName.capacity();
+        return m_stateSizeFunction ? size + m_stateSizeFunction(state) : size;
+    }
+
+    std::uint64_t PlanningDomain::ObjectSignature(const State& state, const std::any& object) const
+    {
+        return m_objectSignatureFunction(state, object);
+    }
+
+    double PlanningDomain::OperatorCost(const State& currentState, const Task& task) const
+    {
+        auto cost = m_costTable.find(task.taskName);
+        if (cost == m_costTable.end())
+        {
+            return 1.0;
+        }
+
+        return cost->second(currentState, task.parameters);
+    }
+
+    double PlanningDomain::TaskLowerBound(const State& currentState, const Task& task) const
+    {
+        auto lowerBound = m_lowerBoundTable.find(task.taskName);
+        if (lowerBound == m_lowerBoundTable.end())
+        {
+            return 0.0;
+        }
+
+        return lowerBound->second(currentState, task.parameters);
+    }
+
+    bool PlanningDomain::HasLowerBounds() const
+    {
+        return not m_lowerBoundTable.empty();
+    }
+
+    std::optional<Footprint> PlanningDomain::TaskFootprint(const State& currentState, const Task& task) const
+    {
+        auto footprint = m_footprintTable.find(task.taskName);
+        if (footprint == m_footprintTable.end())
+        {
+            return std::nullopt;
+        }
+
+        return footprint->second(currentState, task.parameters);
+    }
+
+    std::optional<std::uint64_t> PlanningDomain::TaskProjection(const State& currentState, const Task& task) const
+    {
+        auto projection = m_projectionTable.find(task.taskName);
+        if (projection == m_projectionTable.end())
+        {
+            return std::nullopt;
+        }
+
+        return projection->second(currentState, task.parameters);
+    }
+
+    std::size_t TaskSize(const Task& task)
+    {
+        return sizeof(Task) + task.taskName.capacity() + task.parameters.capacity() * sizeof(std::any);
+    }
+
     std::ostream& operator<<(std::ostream& os, const Task& task)
     {
         os << task.taskName << " with " << task.parameters.size() << " parameters.";
@@ -5,9 +5,16 @@ namespace tfd_cpp
     PlanningProblem::PlanningProblem(const PlanningDomain& domain, 
                                      const State& initialState, 
                                      const Task& topLevelTask) : 
+        PlanningProblem(domain, initialState, TaskNetwork{{topLevelTask}})
+    {
+    }
+
+    PlanningProblem::PlanningProblem(const PlanningDomain& domain,
+                                     const State& initialState,
+                                     const TaskNetwork& topLevelTasks) :
         m_planningDomain(domain),
         m_initialState(initialState),
-        m_topLevelTask(topLevelTask)
+        m_topLevelTasks(topLevelTasks.tasks)
     {
     }
 
@@ -15,6 +22,36 @@ namespace tfd_cpp
     {
     }
 
+    const Operators* PlanningProblem::FindOperators(const std::string& taskName) const
+    {
+        return m_planningDomain.FindOperators(taskName);
+    }
+
+    const Methods* PlanningProblem::FindMethods(const std::string& taskName) const
+    {
+        return m_planningDomain.FindMethods(taskName);
+    }
+
+    const InPlaceOperators* PlanningProblem::FindInPlaceOperators(const std::string& taskName) const
+    {
+        return m_planningDomain.FindInPlaceOperators(taskName);
+    }
+
+    const BoundObjects* PlanningProblem::FindBoundObjects(const std::string& taskName) const
+    {
+        return m_planningDomain.FindBoundObjects(taskName);
+    }
+
+    const GuardIndex* PlanningProblem::FindOperatorGuards(const std::string& taskName) const
+    {
+        return m_planningDomain.FindOperatorGuards(taskName);
+    }
+
+    const GuardIndex* PlanningProblem::FindMethodGuards(const std::string& taskName) const
+    {
+        return m_planningDomain.FindMethodGuards(taskName);
+    }
+
     bool PlanningProblem::TaskIsOperator(const std::string& taskName) const
     {
         return m_planningDomain.TaskIsOperator(taskName);
@@ -25,12 +62,22 @@ namespace tfd_cpp
         return m_planningDomain.TaskIsMethod(taskName);
     }
 
+    bool PlanningProblem::CheckTask(const Task& task) const
+    {
+        return m_planningDomain.CheckTask(task);
+    }
+
+    bool PlanningProblem::HasSignatures() const
+    {
+        return m_planningDomain.HasSignatures();
+    }
+
     PlanningProblem::RelevantMethods PlanningProblem::GetMethodsForTask(const Task& task, const State& currentState) const
     {
-        const auto relevantMethods = m_planningDomain.GetRelevantMethods(currentState, task);
+        auto relevantMethods = m_planningDomain.GetRelevantMethods(currentState, task);
         if (relevantMethods)
         {
-            return relevantMethods.value();
+            return std::move(relevantMethods.value());
         }
         else
         {
@@ -40,10 +87,10 @@ namespace tfd_cpp
 
     PlanningProblem::ApplicableOperators PlanningProblem::GetOperatorsForTask(const Task& task, const State& currentState) const
     {
-        const auto applicableOperators = m_planningDomain.GetApplicableOperators(currentState, task);
+        auto applicableOperators = m_planningDomain.GetApplicableOperators(currentState, task);
         if (applicableOperators)
         {
-            return applicableOperators.value();
+            return std::move(applicableOperators.value());
         }
         else
         {
@@ -51,13 +98,64 @@ namespace tfd_cpp
         }
     }
 
-    State PlanningProblem::GetInitialState() const
+    std::optional<std::uint64_t> PlanningProblem::HashState(const State& state) const
+    {
+        return m_planningDomain.HashState(state);
+    }
+
+    std::size_t PlanningProblem::StateSize(const State& state) const
+    {
+        return m_planningDomain.StateSize(state);
+    }
+
+    std::uint64_t PlanningProblem::ObjectSignature(const State& state, const std::any& object) const
+    {
+        return m_planningDomain.ObjectSignature(state, object);
+    }
+
+    double PlanningProblem::OperatorCost(const State& currentState, const Task& task) const
+    {
+        return m_planningDomain.OperatorCost(currentState, task);
+    }
+
+    double PlanningProblem::TaskLowerBound(const State& currentState, const Task& task) const
+    {
+        return m_planningDomain.TaskLowerBound(currentState, task);
+    }
+
+    bool PlanningProblem::HasLowerBounds() const
+    {
+        return m_planningDomain.HasLowerBounds();
+    }
+
+    std::optional<Footprint> PlanningProblem::TaskFootprint(const State& currentState, const Task& task) const
+    {
+        return m_planningDomain.TaskFootprint(currentState, task);
+    }
+
+    std::optional<std::uint64_t> PlanningProblem::TaskProjection(const State& currentState, const Task& task) const
+    {
+        return m_planningDomain.TaskProjection(currentState, task);
+    }
+
+    const PlanningDomain& PlanningProblem::GetPlanningDomain() const
+    {
+        return m_planningDomain;
+    }
+
+    const State& PlanningProblem::GetInitialState() const
     {
         return m_initialState;
     }
 
-    Task PlanningProblem::GetTopLevelTask() const
+    const Task& PlanningProblem::GetTopLevelTask() const
+    {
+        static const Task s_noTask;
+        return m_topLevelTasks.empty() ? s_noTask : m_topLevelTasks.front();
+    }
+
+    const std::vector<Task>& PlanningProblem::GetTopLevelTasks() const
     {
-        return m_topLevelTask;
+        return m_topLevelTasks;
     }
 }
@@ -0,0 +1,137 @@
+#include "tfd.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    namespace
+    {
+        // Beam search and depth limits may miss plans, so their failures prove nothing.
+        bool Decides(const SearchOptions& options, const SearchResult& result)
+        {
+            if (result.status == SearchStatus::Solved or result.status == SearchStatus::Optimal)
+            {
+                return true;
+            }
+            return result.status == SearchStatus::NoPlan and options.strategy != SearchStrategy::Beam and not options.depthLimit;
+        }
+    }
+
+    std::vector<PortfolioConfiguration> DefaultPortfolio()
+    {
+        std::vector<PortfolioConfiguration> configurations(5);
+        configurations[0].name = "depth-first";
+        configurations[1].name = "depth-first-reversed";
+        configurations[1].options.methodOrder = MethodOrder::Reversed;
+        configurations[2].name = "depth-first-shuffled-1";
+        configurations[2].options.methodOrder = MethodOrder::Shuffled;
+        configurations[2].options.seed = 1;
+        configurations[3].name = "depth-first-shuffled-2";
+        configurations[3].options.methodOrder = MethodOrder::Shuffled;
+        configurations[3].options.seed = 2;
+        configurations[4].name = "greedy-best-first";
+        configurations[4].options.strategy = SearchStrategy::GreedyBestFirst;
+        return configurations;
+    }
+
+    PortfolioResult TFD::SearchPortfolio(const std::vector<PortfolioConfiguration>& configurations, PlannerMetrics* metrics)
+    {
+        PortfolioResult portfolioResult;
+        portfolioResult.results.resize(configurations.size());
+
+        // a checkpoint written by several searches at once would hold none of them
+        std::vector<SearchOptions> options;
+        options.reserve(configurations.size());
+        std::unordered_set<std::string> checkpointFiles;
+        for (const auto& configuration : configurations)
+        {
+            options.push_back(configuration.options);
+            if (not options.back().checkpointFile.empty() and not checkpointFiles.insert(options.back().checkpointFile).second)
+            {
+                BOOST_LOG_TRIVIAL(warning) << "SearchPortfolio: " << configuration.name << " shares the checkpoint file "
+                                           << options.back().checkpointFile << " and does not checkpoint.";
+                options.back().checkpointFile.clear();
+            }
+        }
+
+        std::atomic<bool> cancel(false);
+        std::mutex winnerMutex;
+        std::condition_variable searchFinished;
+        std::size_t finished = 0;
+        std::vector<std::thread> threads;
+        threads.reserve(configurations.size());
+        for (std::size_t configuration = 0; configuration < configurations.size(); ++configuration)
+        {
+            threads.emplace_back([&, configuration]()
+            {
+                auto configurationOptions = options[configuration];
+                configurationOptions.cancel = &cancel;
+                if (not configurationOptions.metrics)
+                {
+                    configurationOptions.metrics = metrics;
+                }
+
+                auto result = Search(configurationOptions);
+
+                std::lock_guard<std::mutex> lock(winnerMutex);
+                if (not portfolioResult.winner and Decides(configurationOptions, result))
+                {
+                    portfolioResult.winner = configuration;
+                    cancel = true;
+                }
+                portfolioResult.results[configuration] = std::move(result);
+                ++finished;
+                searchFinished.notify_one();
+            });
+        }
+        {
+            // the searches are cancelled through a flag of their own, so the caller's are passed on from here
+            std::unique_lock<std::mutex> lock(winnerMutex);
+            while (finished < configurations.size())
+            {
+                for (const auto& configuration : configurations)
+                {
+                    if (configuration.options.cancel and configuration.options.cancel->load(std::memory_order_relaxed))
+                    {
+                        cancel = true;
+                    }
+                }
+                searchFinished.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (portfolioResult.winner)
+        {
+            const auto winner = portfolioResult.winner.value();
+            BOOST_LOG_TRIVIAL(info) << "SearchPortfolio: " << configurations[winner].name << " won.";
+            portfolioResult.result = portfolioResult.results[winner];
+            if (metrics)
+            {
+                metrics->RecordPortfolioWinner(configurations[winner].name);
+            }
+            return portfolioResult;
+        }
+
+        // no configuration could decide; a limit that was hit says more than an incomplete NoPlan
+        BOOST_LOG_TRIVIAL(warning) << "SearchPortfolio: No configuration found a plan.";
+        for (const auto& result : portfolioResult.results)
+        {
+            portfolioResult.result.nodesExpanded += result.nodesExpanded;
+            portfolioResult.result.peakMemoryBytes += result.peakMemoryBytes;
+            if (result.status == SearchStatus::Timeout or
+                (result.status == SearchStatus::MemoryExceeded and portfolioResult.result.status != SearchStatus::Timeout))
+            {
+                portfolioResult.result.status = result.status;
+            }
+        }
+        return portfolioResult;
+    }
+}
@@ -0,0 +1,89 @@
+#include "subplan_cache.h"
+
+#include <functional>
+#include <mutex>
+
+namespace tfd_cpp
+{
+    SubplanCache::SubplanCache(std::size_t maxBytes) :
+        m_maxBytes(maxBytes),
+        m_bytes(0),
+        m_hits(0),
+        m_misses(0)
+    {
+    }
+
+    SubplanCache::~SubplanCache() {}
+
+    const OperatorsWithParams* SubplanCache::Find(const std::string& taskName, std::uint64_t projection) const
+    {
+        std::shared_lock lock(m_mutex);
+        const auto subplan = m_subplans.find(Key{taskName, projection});
+        if (subplan == m_subplans.end())
+        {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return &subplan->second;
+    }
+
+    bool SubplanCache::Contains(const std::string& taskName, std::uint64_t projection) const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_subplans.count(Key{taskName, projection}) > 0;
+    }
+
+    bool SubplanCache::Store(const std::string& taskName, std::uint64_t projection, OperatorsWithParams subplan)
+    {
+        std::size_t bytes = sizeof(Key) + sizeof(OperatorsWithParams) + taskName.capacity();
+        for (const auto& step : subplan)
+        {
+            bytes += TaskSize(step.task) + sizeof(OperatorFunction);
+        }
+
+        std::unique_lock lock(m_mutex);
+        if (m_bytes + bytes > m_maxBytes)
+        {
+            return false;
+        }
+        if (not m_subplans.try_emplace(Key{taskName, projection}, std::move(subplan)).second)
+        {
+            return false;
+        }
+        m_bytes += bytes;
+        return true;
+    }
+
+    std::size_t SubplanCache::Size() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_subplans.size();
+    }
+
+    std::size_t SubplanCache::Bytes() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_bytes;
+    }
+
+    std::size_t SubplanCache::Hits() const
+    {
+        return m_hits.load(std::memory_order_relaxed);
+    }
+
+    std::size_t SubplanCache::Misses() const
+    {
+        return m_misses.load(std::memory_order_relaxed);
+    }
+
+    bool SubplanCache::Key::operator==(const Key& other) const
+    {
+        return projection == other.projection and taskName == other.taskName;
+    }
+
+    std::size_t SubplanCache::KeyHash::operator()(const Key& key) const
+    {
+        return std::hash<std::string>()(key.taskName) ^ static_cast<std::size_t>(key.projection);
+    }
+}
@@ -0,0 +1,59 @@
+#include "symmetry.h"
+
+#include <algorithm>
+#include <boost/log/trivial.hpp>
+
+namespace tfd_cpp
+{
+    SymmetryFilter::SymmetryFilter() :
+        m_referencedSorted(true)
+    {
+    }
+
+    SymmetryFilter::~SymmetryFilter() {}
+
+    void SymmetryFilter::Clear()
+    {
+        m_referenced.clear();
+        m_referencedSorted = true;
+        m_tried.clear();
+    }
+
+    void SymmetryFilter::Refer(const Task& task)
+    {
+        for (const auto& parameter : task.parameters)
+        {
+            m_referenced.push_back(HashParameter(parameter));
+        }
+        m_referencedSorted = false;
+    }
+
+    bool SymmetryFilter::Skip(const PlanningProblem& planningProblem, const State& state, const BoundObject& boundObject)
+    {
+        if (not m_referencedSorted)
+        {
+            std::sort(m_referenced.begin(), m_referenced.end());
+            m_referenced.erase(std::unique(m_referenced.begin(), m_referenced.end()), m_referenced.end());
+            m_referencedSorted = true;
+        }
+
+        // a hash collision only makes an object look referenced, which costs pruning but never plans
+        if (std::binary_search(m_referenced.begin(), m_referenced.end(), HashParameter(boundObject.object)))
+        {
+            return false;
+        }
+
+        if (not m_tried.emplace(boundObject.group, planningProblem.ObjectSignature(state, boundObject.object)).second)
+        {
+            BOOST_LOG_TRIVIAL(trace) << "SymmetryFilter: Skipping an object interchangeable with one already tried.";
+            return true;
+        }
+
+        return false;
+    }
+
+    std::size_t SymmetryFilter::ObjectClassHash::operator()(const ObjectClass& objectClass) const
+    {
+        return static_cast<std::size_t>(ZobristCombine(ZobristKey(objectClass.first), objectClass.second));
+    }
+}
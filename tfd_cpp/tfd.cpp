@@ -1,5 +1,11 @@
 #include "tfd.h"
+#include "best_first_search.h"
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/expressions.hpp>
@@ -13,126 +19,1159 @@ namespace tfd_cpp
 {
     namespace logging = boost::log;
 
+    static constexpr std::size_t DEADLINE_CHECK_INTERVAL = 64;
+
     TFD::TFD(const PlanningProblem& planningProblem) : 
         m_planningProblem(planningProblem)
     {
-        logging::add_file_log("tfd_cpp.log");
+        // every sink added here receives every record, so it must only be added once per process
+        static std::once_flag loggingSetUp;
+        std::call_once(loggingSetUp, []()
+        {
+            logging::add_file_log("tfd_cpp.log");
 
-        logging::core::get()->set_filter
-        (
-            logging::trivial::severity >= logging::trivial::trace
-        );
+            logging::core::get()->set_filter
+            (
+                logging::trivial::severity >= logging::trivial::trace
+            );
+        });
     }
 
     TFD::~TFD() {}
 
     TFD::Plan TFD::TryToPlan()
     {
-        std::vector<Task> tasks;
-        Plan solutionPlan;
-        tasks.push_back(m_planningProblem.GetTopLevelTask());
+        BOOST_LOG_TRIVIAL(info) << "TryToPlan for: " << m_planningProblem.GetTopLevelTask().taskName;
+
+        return Search(SearchOptions()).plan;
+    }
+
+    const TFD::Plan& TFD::TryToPlan(PlannerContext& context)
+    {
+        BOOST_LOG_TRIVIAL(info) << "TryToPlan for: " << m_planningProblem.GetTopLevelTask().taskName;
+
+        PlanIterator planIterator(m_planningProblem, context);
+        while (planIterator.Advance())
+        {
+            // an empty plan cannot be told apart from a failure, so keep looking for a non-empty one
+            if (not planIterator.CurrentPlan().empty())
+            {
+                break;
+            }
+        }
 
-        BOOST_LOG_TRIVIAL(info) << "TryToPlan for: " << tasks.back().taskName;
+        return planIterator.CurrentPlan();
+    }
 
-        return SeekPlan(tasks, m_planningProblem.GetInitialState(), solutionPlan);
+    SearchResult TFD::Search(const SearchOptions& options)
+    {
+        PlannerContext context;
+        return Search(options, context);
     }
 
-    TFD::Plan TFD::SeekPlan(const std::vector<Task>& tasks, const State& currentState, Plan& currentPlan)
+    SearchResult TFD::Search(const SearchOptions& options, PlannerContext& context)
     {
-        if (tasks.empty())
+        const auto start = std::chrono::steady_clock::now();
+        auto result = (options.strategy == SearchStrategy::DepthFirst) ? SearchDepthFirst(options, context)
+                                                                       : BestFirstSearch(m_planningProblem, options).Run();
+        if (options.metrics)
         {
-            BOOST_LOG_TRIVIAL(info) << "SeekPlan: No more tasks, returning current plan.";
-            if (not currentPlan.empty())
+            options.metrics->RecordSearch(result, std::chrono::steady_clock::now() - start);
+        }
+        return result;
+    }
+
+    SearchResult TFD::SearchDepthFirst(const SearchOptions& options, PlannerContext& context)
+    {
+        SearchResult result;
+        bool found = false;
+
+        PlanIterator planIterator(m_planningProblem, context);
+        if (options.timeLimit)
+        {
+            planIterator.SetDeadline(std::chrono::steady_clock::now() + options.timeLimit.value());
+        }
+        if (options.memoryLimit)
+        {
+            planIterator.SetMemoryLimit(options.memoryLimit.value());
+        }
+        planIterator.SetMetrics(options.metrics);
+        planIterator.SetMethodOrder(options.methodOrder, options.seed);
+        if (options.depthLimit)
+        {
+            planIterator.SetDepthLimit(options.depthLimit.value());
+        }
+        planIterator.SetLookahead(options.lookahead);
+        planIterator.SetCancelFlag(options.cancel);
+        planIterator.SetSubplanCache(options.subplanCache);
+        if (not options.checkpointFile.empty())
+        {
+            planIterator.SetCheckpointing(options.checkpointInterval, [&options](const SearchCheckpoint& checkpoint) {
+                SaveCheckpoint(checkpoint, options.checkpointFile);
+            });
+            if (options.resume and std::ifstream(options.checkpointFile))
             {
-                BOOST_LOG_TRIVIAL(info) << "TFD found solution plan." << std::endl;
-                for (const auto& operatorWithParams : currentPlan)
+                // a checkpoint that cannot be resumed says nothing about the problem, so search it afresh
+                const auto checkpoint = LoadCheckpoint(options.checkpointFile);
+                if (not checkpoint or not planIterator.Resume(checkpoint.value()))
+                {
+                    BOOST_LOG_TRIVIAL(error) << "TFD: Unable to resume from " << options.checkpointFile << ", searching from the start.";
+                }
+                else if (not checkpoint->incumbent.empty())
                 {
-                    BOOST_LOG_TRIVIAL(info) << operatorWithParams.task.taskName;
+                    found = true;
+                    result.plan = planIterator.CurrentPlan();
+                    result.cost = planIterator.PlanCost();
+                    result.taskBoundaries = planIterator.TaskBoundaries();
+                    planIterator.SetCostBound(result.cost);
                 }
             }
-            return currentPlan;
         }
 
-        if (m_planningProblem.TaskIsOperator(tasks.back().taskName))
+        std::optional<std::vector<std::size_t>> emptyPlan;
+        while (planIterator.Advance())
         {
-            BOOST_LOG_TRIVIAL(trace) << "SeekPlan: Task is operator type.";
-            return SearchOperators(tasks, currentState, currentPlan);
+            // a caller reading only the plan cannot tell an empty one from a failure, so look for a
+            // non-empty one and keep the empty plan for when there is none, e.g. a decomposed group
+            // whose tasks need no steps; an optimizing search takes it like any other plan, since
+            // nothing is cheaper
+            if (planIterator.CurrentPlan().empty() and not options.optimize)
+            {
+                if (not emptyPlan)
+                {
+                    emptyPlan = planIterator.TaskBoundaries();
+                }
+                continue;
+            }
+
+            found = true;
+            result.plan = planIterator.CurrentPlan();
+            result.cost = planIterator.PlanCost();
+            result.taskBoundaries = planIterator.TaskBoundaries();
+            if (options.onPlanFound)
+            {
+                options.onPlanFound(result.plan, result.cost);
+            }
+
+            if (not options.optimize)
+            {
+                break;
+            }
+
+            BOOST_LOG_TRIVIAL(info) << "Search: found plan with cost " << result.cost << ", looking for a cheaper one.";
+            planIterator.SetCostBound(result.cost);
         }
 
-        if (m_planningProblem.TaskIsMethod(tasks.back().taskName))
+        if (not found and emptyPlan)
         {
-            BOOST_LOG_TRIVIAL(trace) << "SeekPlan: Task is method type.";
-            return SearchMethods(tasks, currentState, currentPlan);
+            found = true;
+            result.taskBoundaries = std::move(emptyPlan.value());
+        }
+        result.nodesExpanded = planIterator.NodesExpanded();
+        result.peakMemoryBytes = planIterator.PeakMemory();
+        if (found)
+        {
+            result.status = (options.optimize and planIterator.Exhausted()) ? SearchStatus::Optimal : SearchStatus::Solved;
+        }
+        else
+        {
+            if (planIterator.TimedOut())
+            {
+                result.status = SearchStatus::Timeout;
+            }
+            else if (planIterator.MemoryExceeded())
+            {
+                result.status = SearchStatus::MemoryExceeded;
+            }
+            else if (planIterator.Cancelled())
+            {
+                result.status = SearchStatus::Cancelled;
+            }
+            else
+            {
+                result.status = SearchStatus::NoPlan;
+            }
+        }
+
+        // a search stopped by its memory limit has dropped the node it could not hold, so it is not resumable
+        if (not options.checkpointFile.empty() and (planIterator.TimedOut() or planIterator.Cancelled()))
+        {
+            SaveCheckpoint(planIterator.Checkpoint(), options.checkpointFile);
+        }
+
+        return result;
+    }
+
+    PlanIterator TFD::EnumeratePlans() const
+    {
+        return PlanIterator(m_planningProblem);
+    }
+
+    PlannerContext::PlannerContext() :
+        m_depth(0),
+        m_planSize(0)
+    {
+    }
+
+    PlannerContext::~PlannerContext() {}
+
+    void PlannerContext::PushPlanStep(const Task& task, const OperatorFunction& func)
+    {
+        if (m_planSize < m_planSteps.size())
+        {
+            // assigning into an old step reuses the capacity of its name and parameters
+            m_planSteps[m_planSize].task = task;
+            m_planSteps[m_planSize].func = &func;
+        }
+        else
+        {
+            m_planSteps.push_back(PlanStep{task, &func});
+        }
+        ++m_planSize;
+    }
+
+    void PlannerContext::CopyPlan()
+    {
+        if (m_plan.size() > m_planSize)
+        {
+            m_plan.erase(m_plan.begin() + m_planSize, m_plan.end());
+        }
+        for (std::size_t step = 0; step < m_plan.size(); ++step)
+        {
+            m_plan[step].task = m_planSteps[step].task;
+            m_plan[step].func = *m_planSteps[step].func;
+        }
+        for (std::size_t step = m_plan.size(); step < m_planSize; ++step)
+        {
+            m_plan.emplace_back(m_planSteps[step].task, *m_planSteps[step].func);
+        }
+        m_planBoundaries = m_taskBoundaries;
+    }
+
+    PlanIterator::PlanIterator(const PlanningProblem& planningProblem) :
+        m_planningProblem(planningProblem),
+        m_ownedContext(std::make_unique<PlannerContext>()),
+        m_context(m_ownedContext.get()),
+        m_started(false),
+        m_timedOut(false),
+        m_costBound(std::numeric_limits<double>::infinity()),
+        m_planCost(0.0),
+        m_nodesExpanded(0),
+        m_steps(0),
+        m_memoryExceeded(false),
+        m_memoryBytes(0),
+        m_peakMemoryBytes(0),
+        m_metrics(nullptr),
+        m_methodOrder(MethodOrder::AsAdded),
+        m_cancel(nullptr),
+        m_cancelled(false),
+        m_checkpointInterval(0),
+        m_subplanCache(nullptr)
+    {
+    }
+
+    PlanIterator::PlanIterator(const PlanningProblem& planningProblem, PlannerContext& context) :
+        m_planningProblem(planningProblem),
+        m_context(&context),
+        m_started(false),
+        m_timedOut(false),
+        m_costBound(std::numeric_limits<double>::infinity()),
+        m_planCost(0.0),
+        m_nodesExpanded(0),
+        m_steps(0),
+        m_memoryExceeded(false),
+        m_memoryBytes(0),
+        m_peakMemoryBytes(0),
+        m_metrics(nullptr),
+        m_methodOrder(MethodOrder::AsAdded),
+        m_cancel(nullptr),
+        m_cancelled(false),
+        m_checkpointInterval(0),
+        m_subplanCache(nullptr)
+    {
+    }
+
+    PlanIterator::~PlanIterator() {}
+
+    std::optional<Plan> PlanIterator::Next()
+    {
+        if (Advance())
+        {
+            return m_context->m_plan;
+        }
+        return std::nullopt;
+    }
+
+    bool PlanIterator::Advance()
+    {
+        auto& context = *m_context;
+        auto& choicePoints = context.m_choicePoints;
+
+        if (m_timedOut or m_memoryExceeded or m_cancelled)
+        {
+            return false;
+        }
+
+        if (not m_started)
+        {
+            if (not StartSearch())
+            {
+                return false;
+            }
+            if (SeekPlan(choicePoints.front()))
+            {
+                FoundPlan();
+                return true;
+            }
+        }
+
+        while (context.m_depth > 0)
+        {
+            const bool checkClock = (m_steps++ % DEADLINE_CHECK_INTERVAL) == 0;
+            if (Interrupted(checkClock))
+            {
+                return false;
+            }
+            if (m_onCheckpoint and checkClock and std::chrono::steady_clock::now() >= m_nextCheckpoint)
+            {
+                m_onCheckpoint(Checkpoint());
+                m_nextCheckpoint = std::chrono::steady_clock::now() + m_checkpointInterval;
+            }
+
+            auto& choicePoint = choicePoints[context.m_depth - 1];
+            const auto alternatives = Alternatives(choicePoint);
+
+            // the bound may have tightened since this choice point was created
+            if (choicePoint.nextAlternative == alternatives or Prune(choicePoint.cost, choicePoint.lowerBound))
+            {
+                if (choicePoint.methods)
+                {
+                    BOOST_LOG_TRIVIAL(warning) << "SearchMethods: Failed to plan";
+                }
+                m_memoryBytes -= choicePoint.bytes;
+                --context.m_depth;
+                continue;
+            }
+
+            Backtrack(choicePoint);
+
+            // growing a deque leaves references to the existing choice points valid
+            if (choicePoints.size() == context.m_depth)
+            {
+                choicePoints.emplace_back();
+            }
+            auto& node = choicePoints[context.m_depth];
+
+            const bool expanded = choicePoint.subplan ? SpliceSubplan(choicePoint, node)
+                                  : choicePoint.methods ? SearchMethods(choicePoint, node)
+                                                        : SearchOperators(choicePoint, node);
+            if (expanded)
+            {
+                ++m_nodesExpanded;
+                node.bytes += NodeBytes();
+                if (OverMemoryLimit(node.bytes))
+                {
+                    return false;
+                }
+                if (SeekPlan(node))
+                {
+                    FoundPlan();
+                    return true;
+                }
+                // tasks applied without a choice point of their own are limited as well
+                if (m_timedOut or m_memoryExceeded or m_cancelled)
+                {
+                    return false;
+                }
+            }
         }
 
-        return {};
+        context.m_plan.clear();
+        return false;
     }
 
-    TFD::Plan TFD::SearchMethods(const std::vector<Task>& tasks, const State& currentState, Plan& currentPlan)
+    bool PlanIterator::StartSearch()
     {
-        BOOST_LOG_TRIVIAL(trace) << "SearchMethods for " << tasks.back().taskName;
-        RelevantMethods relevantMethods = m_planningProblem.GetMethodsForTask(tasks.back(), currentState);
-        
-        if (not relevantMethods.empty())
+        auto& context = *m_context;
+        auto& choicePoints = context.m_choicePoints;
+
+        m_started = true;
+        context.m_depth = 0;
+        context.m_planSize = 0;
+        context.m_state = m_planningProblem.GetInitialState();
+        context.m_trail.Clear();
+        if (choicePoints.empty())
         {
-            BOOST_LOG_TRIVIAL(trace) << "SearchMethods: " << relevantMethods.size() <<  " relevant methods found.";
+            choicePoints.emplace_back();
+        }
 
-            for (const auto& relevantMethod : relevantMethods)
+        const auto& topLevelTasks = m_planningProblem.GetTopLevelTasks();
+        if (m_planningProblem.HasSignatures())
+        {
+            for (const auto& topLevelTask : topLevelTasks)
             {
-                auto subTasks = relevantMethod.func(currentState, relevantMethod.task.parameters);
-                if (subTasks and not subTasks.value().empty())
+                if (not m_planningProblem.CheckTask(topLevelTask))
                 {
-                    std::vector<Task> newTasks(tasks);
-                    newTasks.pop_back();
-                    newTasks.insert(newTasks.end(), subTasks.value().begin(), subTasks.value().end());
+                    context.m_plan.clear();
+                    return false;
+                }
+            }
+        }
+        context.m_taskBoundaries.assign(topLevelTasks.size(), 0);
+        context.m_topLevelLinks.clear();
+        for (const auto& topLevelTask : topLevelTasks)
+        {
+            context.m_topLevelLinks.push_back({&topLevelTask, nullptr});
+        }
+
+        auto& root = choicePoints.front();
+        root.agenda = nullptr;
+        root.topLevelTasksStarted = 0;
+        root.planSize = 0;
+        root.cost = 0.0;
+        root.bytes = NodeBytes();
+        m_memoryBytes = sizeof(PlannerContext) + m_planningProblem.StateSize(context.m_state);
+        return not OverMemoryLimit(root.bytes);
+    }
+
+    void PlanIterator::FoundPlan()
+    {
+        // only a checkpointed search needs to find its way back to the plan
+        if (m_onCheckpoint)
+        {
+            m_incumbent = RecordChoicePoints();
+        }
+    }
+
+    std::vector<PlanIterator::ChoicePointRecord> PlanIterator::RecordChoicePoints() const
+    {
+        std::vector<ChoicePointRecord> records(m_context->m_depth);
+        for (std::size_t depth = 0; depth < records.size(); ++depth)
+        {
+            const auto& choicePoint = m_context->m_choicePoints[depth];
+            auto& record = records[depth];
+            record.taskName = choicePoint.agenda->task->taskName;
+            record.nextAlternative = choicePoint.nextAlternative;
+            record.selected = choicePoint.selected;
+            if (choicePoint.selected)
+            {
+                record.alternatives = choicePoint.selection.alternatives;
+            }
+        }
+        return records;
+    }
+
+    SearchCheckpoint PlanIterator::Checkpoint() const
+    {
+        SearchCheckpoint checkpoint;
+        if (m_started)
+        {
+            checkpoint.choicePoints = RecordChoicePoints();
+        }
+        // without a cost bound the search is not optimizing, and a resumed search need not return the plan again
+        if (m_costBound < std::numeric_limits<double>::infinity())
+        {
+            checkpoint.incumbent = m_incumbent;
+        }
+        checkpoint.costBound = m_costBound;
+        checkpoint.nodesExpanded = m_nodesExpanded;
+        checkpoint.peakMemoryBytes = m_peakMemoryBytes;
+        std::ostringstream randomState;
+        randomState << m_random;
+        checkpoint.randomState = randomState.str();
+        return checkpoint;
+    }
+
+    bool PlanIterator::Resume(const SearchCheckpoint& checkpoint)
+    {
+        if (m_started)
+        {
+            BOOST_LOG_TRIVIAL(error) << "PlanIterator: Resume must come before the search starts.";
+            return false;
+        }
+        // the checkpointed search did not splice sub-plans, so the replay must not either
+        const auto subplanCache = m_subplanCache;
+        m_subplanCache = nullptr;
+
+        // a replay that diverges leaves the iterator to start the search afresh
+        auto abandon = [this, subplanCache]()
+        {
+            m_started = false;
+            m_timedOut = false;
+            m_memoryExceeded = false;
+            m_cancelled = false;
+            m_planCost = 0.0;
+            m_nodesExpanded = 0;
+            m_steps = 0;
+            m_peakMemoryBytes = 0;
+            m_incumbent.clear();
+            m_context->m_plan.clear();
+            m_subplanCache = m_onCheckpoint ? nullptr : subplanCache;
+            return false;
+        };
+        if (not checkpoint.incumbent.empty())
+        {
+            if (not Replay(checkpoint.incumbent, true))
+            {
+                return abandon();
+            }
+            m_incumbent = checkpoint.incumbent;
+        }
+        if (not Replay(checkpoint.choicePoints, false))
+        {
+            return abandon();
+        }
+
+        m_costBound = checkpoint.costBound;
+        m_nodesExpanded = checkpoint.nodesExpanded;
+        m_peakMemoryBytes = std::max(m_peakMemoryBytes, checkpoint.peakMemoryBytes);
+        std::istringstream randomState(checkpoint.randomState);
+        randomState >> m_random;
+        BOOST_LOG_TRIVIAL(info) << "PlanIterator: Resumed at depth " << m_context->m_depth << ".";
+        return true;
+    }
+
+    void PlanIterator::SetCheckpointing(std::chrono::milliseconds interval, std::function<void(const SearchCheckpoint&)> onCheckpoint)
+    {
+        m_checkpointInterval = interval;
+        m_onCheckpoint = std::move(onCheckpoint);
+        m_nextCheckpoint = std::chrono::steady_clock::now() + interval;
+        m_subplanCache = nullptr;
+    }
+
+    void PlanIterator::SetSubplanCache(SubplanCache* subplanCache)
+    {
+        m_subplanCache = m_onCheckpoint ? nullptr : subplanCache;
+    }
+
+    bool PlanIterator::Replay(const std::vector<ChoicePointRecord>& records, bool toPlan)
+    {
+        auto& context = *m_context;
+        auto& choicePoints = context.m_choicePoints;
+        auto diverged = [](const char* reason)
+        {
+            BOOST_LOG_TRIVIAL(error) << "PlanIterator: The checkpoint does not match the problem, " << reason << ".";
+            return false;
+        };
+
+        if (not StartSearch())
+        {
+            return false;
+        }
+        if (SeekPlan(choicePoints.front()))
+        {
+            return (toPlan and records.empty()) ? true : diverged("the root is a plan");
+        }
+        if (records.empty())
+        {
+            // the checkpointed search was exhausted
+            context.m_depth = 0;
+            return not toPlan or diverged("there is no plan to return to");
+        }
+
+        for (std::size_t depth = 0; depth < records.size(); ++depth)
+        {
+            const auto& record = records[depth];
+            auto& choicePoint = choicePoints[depth];
+            if (context.m_depth != depth + 1 or choicePoint.agenda->task->taskName != record.taskName)
+            {
+                return diverged("a choice point is for another task");
+            }
+            // the order a shuffle drew, or guards selected, is not drawn again
+            if (record.selected)
+            {
+                choicePoint.selection.alternatives = record.alternatives;
+                choicePoint.selected = true;
+            }
+            if (record.nextAlternative > Alternatives(choicePoint))
+            {
+                return diverged("a choice point has fewer alternatives");
+            }
 
-                    auto solution = SeekPlan(newTasks, currentState, currentPlan);
-                    if (not solution.empty())
+            // the newest choice point continues with its next alternative, the others retake their last one
+            const bool newest = depth + 1 == records.size() and not toPlan;
+            if (not newest and record.nextAlternative == 0)
+            {
+                return diverged("a choice point has not been expanded");
+            }
+            const auto tried = newest ? record.nextAlternative : record.nextAlternative - 1;
+
+            // objects are recorded as interchangeable ones are tried, so try the earlier alternatives again
+            if (choicePoint.methods and choicePoint.boundObjects)
+            {
+                for (std::size_t earlier = 0; earlier < tried; ++earlier)
+                {
+                    const auto alternative = choicePoint.selected ? choicePoint.selection.alternatives[earlier] : earlier;
+                    if (alternative < choicePoint.boundObjects->size() and (*choicePoint.boundObjects)[alternative])
                     {
-                        return solution;
+                        choicePoint.symmetry.Skip(m_planningProblem, context.m_state, (*choicePoint.boundObjects)[alternative].value());
                     }
                 }
-            }            
+            }
+            choicePoint.nextAlternative = tried;
+            if (newest)
+            {
+                return true;
+            }
+
+            Backtrack(choicePoint);
+            if (choicePoints.size() == context.m_depth)
+            {
+                choicePoints.emplace_back();
+            }
+            auto& node = choicePoints[context.m_depth];
+            const bool expanded = choicePoint.methods ? SearchMethods(choicePoint, node)
+                                                      : SearchOperators(choicePoint, node);
+            if (not expanded)
+            {
+                return diverged("an alternative failed");
+            }
+            node.bytes += NodeBytes();
+            if (OverMemoryLimit(node.bytes))
+            {
+                return false;
+            }
+            if (SeekPlan(node))
+            {
+                return (toPlan and depth + 1 == records.size()) ? true : diverged("a plan was found early");
+            }
         }
-        else
+
+        return diverged("the plan was not reached");
+    }
+
+    const Plan& PlanIterator::CurrentPlan() const
+    {
+        return m_context->m_plan;
+    }
+
+    const std::vector<std::size_t>& PlanIterator::TaskBoundaries() const
+    {
+        return m_context->m_planBoundaries;
+    }
+
+    bool PlanIterator::Exhausted() const
+    {
+        return m_started and m_context->m_depth == 0;
+    }
+
+    bool PlanIterator::TimedOut() const
+    {
+        return m_timedOut;
+    }
+
+    void PlanIterator::SetCostBound(double costBound)
+    {
+        m_costBound = costBound;
+    }
+
+    void PlanIterator::SetDeadline(std::chrono::steady_clock::time_point deadline)
+    {
+        m_deadline = deadline;
+    }
+
+    void PlanIterator::SetMemoryLimit(std::size_t memoryLimit)
+    {
+        m_memoryLimit = memoryLimit;
+    }
+
+    bool PlanIterator::MemoryExceeded() const
+    {
+        return m_memoryExceeded;
+    }
+
+    void PlanIterator::SetMetrics(PlannerMetrics* metrics)
+    {
+        m_metrics = metrics;
+    }
+
+    void PlanIterator::SetMethodOrder(MethodOrder methodOrder, std::uint64_t seed)
+    {
+        m_methodOrder = methodOrder;
+        m_random.seed(seed);
+    }
+
+    void PlanIterator::SetDepthLimit(std::size_t depthLimit)
+    {
+        m_depthLimit = depthLimit;
+    }
+
+    void PlanIterator::SetLookahead(Lookahead lookahead)
+    {
+        m_lookahead.SetMode(lookahead);
+    }
+
+    void PlanIterator::SetCancelFlag(const std::atomic<bool>* cancel)
+    {
+        m_cancel = cancel;
+    }
+
+    bool PlanIterator::Cancelled() const
+    {
+        return m_cancelled;
+    }
+
+    double PlanIterator::PlanCost() const
+    {
+        return m_planCost;
+    }
+
+    std::size_t PlanIterator::NodesExpanded() const
+    {
+        return m_nodesExpanded;
+    }
+
+    std::size_t PlanIterator::PeakMemory() const
+    {
+        return m_peakMemoryBytes;
+    }
+
+    void PlanIterator::Backtrack(const ChoicePoint& choicePoint)
+    {
+        // undo whatever the previous alternative did to the state and added to the plan
+        m_context->m_trail.UndoTo(m_context->m_state, choicePoint.trailSize);
+        m_context->m_planSize = choicePoint.planSize;
+    }
+
+    std::size_t PlanIterator::Alternatives(const ChoicePoint& choicePoint)
+    {
+        if (choicePoint.selected)
+        {
+            return choicePoint.selection.alternatives.size();
+        }
+        return choicePoint.methods ? choicePoint.methods->size() : choicePoint.operators->size();
+    }
+
+    std::size_t PlanIterator::NextAlternative(ChoicePoint& choicePoint)
+    {
+        const auto next = choicePoint.nextAlternative++;
+        return choicePoint.selected ? choicePoint.selection.alternatives[next] : next;
+    }
+
+    double PlanIterator::LowerBound(const ChoicePoint& node, const State& currentState) const
+    {
+        if (not m_planningProblem.HasLowerBounds())
+        {
+            return 0.0;
+        }
+
+        double lowerBound = 0.0;
+        for (auto link = node.agenda; link; link = link->next)
+        {
+            lowerBound += m_planningProblem.TaskLowerBound(currentState, *link->task);
+        }
+
+        const auto& topLevelTasks = m_planningProblem.GetTopLevelTasks();
+        for (auto task = topLevelTasks.begin() + node.topLevelTasksStarted; task != topLevelTasks.end(); ++task)
+        {
+            lowerBound += m_planningProblem.TaskLowerBound(currentState, *task);
+        }
+        return lowerBound;
+    }
+
+    bool PlanIterator::Prune(double cost, double lowerBound) const
+    {
+        return cost + lowerBound >= m_costBound;
+    }
+
+    std::size_t PlanIterator::NodeBytes()
+    {
+        return sizeof(ChoicePoint);
+    }
+
+    bool PlanIterator::Interrupted(bool checkClock)
+    {
+        if (m_deadline and checkClock and std::chrono::steady_clock::now() >= m_deadline.value())
         {
-            BOOST_LOG_TRIVIAL(info) << "SearchMethods: No relevant methods found.";
+            BOOST_LOG_TRIVIAL(warning) << "PlanIterator: Time limit reached.";
+            m_timedOut = true;
+            m_context->m_plan.clear();
+            return true;
         }
+        if (m_cancel and m_cancel->load(std::memory_order_relaxed))
+        {
+            BOOST_LOG_TRIVIAL(info) << "PlanIterator: Cancelled.";
+            m_cancelled = true;
+            m_context->m_plan.clear();
+            return true;
+        }
+        return false;
+    }
 
-        BOOST_LOG_TRIVIAL(warning) << "SearchMethods: Failed to plan";
-        return {};
+    bool PlanIterator::OverMemoryLimit(std::size_t nodeBytes)
+    {
+        m_peakMemoryBytes = std::max(m_peakMemoryBytes, m_memoryBytes + nodeBytes);
+        if (m_memoryLimit and m_memoryBytes + nodeBytes > m_memoryLimit.value())
+        {
+            BOOST_LOG_TRIVIAL(warning) << "PlanIterator: Memory limit of " << m_memoryLimit.value() << " bytes reached.";
+            m_memoryExceeded = true;
+            m_context->m_plan.clear();
+            return true;
+        }
+        return false;
     }
 
-    TFD::Plan TFD::SearchOperators(const std::vector<Task>& tasks, const State& currentState, Plan& currentPlan)
+    bool PlanIterator::SeekPlan(ChoicePoint& node)
     {
-        BOOST_LOG_TRIVIAL(trace) << "SearchOperators for " << tasks.back().taskName;
-        ApplicableOperators applicableOperators = m_planningProblem.GetOperatorsForTask(tasks.back(), currentState);
-        
-        if (not applicableOperators.empty())
+        const auto& topLevelTasks = m_planningProblem.GetTopLevelTasks();
+        double lowerBound = 0.0;
+        if (m_subplanCache)
+        {
+            // the parent's task is open until this node achieves it, like those open at the parent
+            const auto depth = m_context->m_depth;
+            const auto& parent = m_context->m_choicePoints[depth > 0 ? depth - 1 : 0];
+            node.openProjection = depth == 0 ? 0 : parent.projection ? depth : parent.openProjection;
+        }
+        while (true)
         {
-            for (const auto& chosenOperator : applicableOperators)
+            if (m_subplanCache)
+            {
+                StoreSubplans(node);
+            }
+
+            // top-level tasks enter the agenda one at a time, when the previous one has been achieved
+            if (not node.agenda and node.topLevelTasksStarted < topLevelTasks.size())
             {
-                const auto newState = chosenOperator.func(currentState, chosenOperator.task.parameters);
-                
-                if (newState)
+                if (node.topLevelTasksStarted > 0)
                 {
-                    std::vector<Task> newTasks(tasks);
-                    newTasks.pop_back();
-                    currentPlan.push_back(chosenOperator);
+                    m_context->m_taskBoundaries[node.topLevelTasksStarted - 1] = node.planSize;
+                }
+                node.agenda = &m_context->m_topLevelLinks[node.topLevelTasksStarted++];
+            }
 
-                    auto solution = SeekPlan(newTasks, newState.value(), currentPlan);
-                    if (not solution.empty())
+            lowerBound = LowerBound(node, m_context->m_state);
+            if (Prune(node.cost, lowerBound))
+            {
+                BOOST_LOG_TRIVIAL(trace) << "SeekPlan: Pruned by cost bound " << m_costBound;
+                return false;
+            }
+
+            if (not node.agenda)
+            {
+                if (node.topLevelTasksStarted > 0)
+                {
+                    m_context->m_taskBoundaries[node.topLevelTasksStarted - 1] = node.planSize;
+                }
+                m_planCost = node.cost;
+                m_context->CopyPlan();
+                BOOST_LOG_TRIVIAL(info) << "SeekPlan: No more tasks, returning current plan.";
+                if (not m_context->m_plan.empty())
+                {
+                    BOOST_LOG_TRIVIAL(info) << "TFD found solution plan." << std::endl;
+                    for (const auto& operatorWithParams : m_context->m_plan)
                     {
-                        return solution;
+                        BOOST_LOG_TRIVIAL(info) << operatorWithParams.task.taskName;
                     }
                 }
+                return true;
+            }
+
+            // a task with a single unguarded operator leaves nothing to backtrack to, so it is applied
+            // here instead of in a choice point of its own; its parent's choice point undoes it
+            const auto& task = *node.agenda->task;
+            const auto operators = m_planningProblem.FindOperators(task.taskName);
+            if (not operators or operators->size() != 1 or m_planningProblem.FindOperatorGuards(task.taskName))
+            {
+                break;
+            }
+            node.nextAlternative = 0;
+            node.trailSize = m_context->m_trail.Size();
+            node.operators = operators;
+            node.inPlaceOperators = m_planningProblem.FindInPlaceOperators(task.taskName);
+            node.selected = false;
+            node.callbackDuration = m_metrics ? m_metrics->CallbackDuration(task.taskName) : nullptr;
+            if (Interrupted((m_steps++ % DEADLINE_CHECK_INTERVAL) == 0))
+            {
+                return false;
+            }
+            const auto bytes = node.bytes;
+            if (not SearchOperators(node, node))
+            {
+                return false;
+            }
+            node.bytes += bytes;
+            ++m_nodesExpanded;
+            if (OverMemoryLimit(node.bytes))
+            {
+                return false;
+            }
+        }
+
+        if (m_depthLimit and m_context->m_depth >= m_depthLimit.value())
+        {
+            BOOST_LOG_TRIVIAL(trace) << "SeekPlan: Depth limit " << m_depthLimit.value() << " reached.";
+            return false;
+        }
+
+        const auto& task = *node.agenda->task;
+        node.lowerBound = lowerBound;
+        node.nextAlternative = 0;
+        node.trailSize = m_context->m_trail.Size();
+        node.operators = m_planningProblem.FindOperators(task.taskName);
+        node.inPlaceOperators = node.operators ? m_planningProblem.FindInPlaceOperators(task.taskName) : nullptr;
+        node.methods = nullptr;
+        node.boundObjects = nullptr;
+        node.guards = nullptr;
+        node.subplan = nullptr;
+        node.projection.reset();
+        node.callbackDuration = m_metrics ? m_metrics->CallbackDuration(task.taskName) : nullptr;
+
+        if (node.operators)
+        {
+            BOOST_LOG_TRIVIAL(trace) << "SeekPlan: Task is operator type.";
+            BOOST_LOG_TRIVIAL(trace) << "SearchOperators for " << task.taskName;
+            node.guards = m_planningProblem.FindOperatorGuards(task.taskName);
+        }
+        else if ((node.methods = m_planningProblem.FindMethods(task.taskName)))
+        {
+            BOOST_LOG_TRIVIAL(trace) << "SeekPlan: Task is method type.";
+            BOOST_LOG_TRIVIAL(trace) << "SearchMethods for " << task.taskName;
+            node.guards = m_planningProblem.FindMethodGuards(task.taskName);
+            if ((node.boundObjects = m_planningProblem.FindBoundObjects(task.taskName)))
+            {
+                node.symmetry.Clear();
+                for (auto link = node.agenda; link; link = link->next)
+                {
+                    node.symmetry.Refer(*link->task);
+                }
+                // the top-level tasks not started yet are on the agenda too, just not linked
+                const auto& topLevelTasks = m_planningProblem.GetTopLevelTasks();
+                for (auto topLevelTask = node.topLevelTasksStarted; topLevelTask < topLevelTasks.size(); ++topLevelTask)
+                {
+                    node.symmetry.Refer(topLevelTasks[topLevelTask]);
+                }
             }
         }
         else
         {
-            BOOST_LOG_TRIVIAL(warning) << "SearchOperators: No applicable operator found.";
+            return false;
+        }
+
+        node.selected = node.guards != nullptr;
+        if (node.guards)
+        {
+            node.guards->Select(m_context->m_state, task.parameters, node.selection);
+            if (node.selection.alternatives.empty())
+            {
+                BOOST_LOG_TRIVIAL(trace) << "SeekPlan: No guards of " << task.taskName << " hold.";
+                return false;
+            }
+        }
+        if (node.methods and m_methodOrder != MethodOrder::AsAdded)
+        {
+            if (not node.selected)
+            {
+                node.selection.alternatives.resize(node.methods->size());
+                std::iota(node.selection.alternatives.begin(), node.selection.alternatives.end(), 0);
+                node.selected = true;
+            }
+            detail::OrderAlternatives(m_methodOrder, m_random, node.selection.alternatives);
+        }
+        if (node.methods and m_subplanCache and (node.projection = m_planningProblem.TaskProjection(m_context->m_state, task)))
+        {
+            node.subplan = m_subplanCache->Find(task.taskName, node.projection.value());
+        }
+
+        // methods and operators are tried lazily as the choice point is resumed, so each one is called once
+        m_memoryBytes += node.bytes;
+        ++m_context->m_depth;
+        return false;
+    }
+
+    bool PlanIterator::SearchMethods(ChoicePoint& choicePoint, ChoicePoint& node)
+    {
+        const auto& task = *choicePoint.agenda->task;
+        const auto alternative = NextAlternative(choicePoint);
+        const auto& method = (*choicePoint.methods)[alternative];
+        const auto boundObjects = choicePoint.boundObjects;
+        if (boundObjects and alternative < boundObjects->size() and (*boundObjects)[alternative] and
+            choicePoint.symmetry.Skip(m_planningProblem, m_context->m_state, (*boundObjects)[alternative].value()))
+        {
+            return false;
+        }
+        std::optional<std::vector<Task>> subTasks;
+        {
+            ScopedTimer callbackTimer(choicePoint.callbackDuration);
+            subTasks = method(m_context->m_state, task.parameters);
         }
 
-        return {};
+        if (not subTasks)
+        {
+            return false;
+        }
+
+        // tasks are type checked once, when they are created, rather than every time they are tried
+        if (m_planningProblem.HasSignatures())
+        {
+            for (const auto& subTask : subTasks.value())
+            {
+                if (not m_planningProblem.CheckTask(subTask))
+                {
+                    return false;
+                }
+            }
+        }
+        if (not m_lookahead.Passes(m_planningProblem, m_context->m_state, subTasks.value()))
+        {
+            BOOST_LOG_TRIVIAL(trace) << "SearchMethods: Lookahead pruned a method of " << task.taskName;
+            return false;
+        }
+
+        // the choice point owns the subtasks, its descendants only link to them
+        choicePoint.subtasks = std::move(subTasks.value());
+        choicePoint.links.resize(choicePoint.subtasks.size());
+        const AgendaLink* rest = choicePoint.agenda->next;
+        for (std::size_t subTask = 0; subTask < choicePoint.subtasks.size(); ++subTask)
+        {
+            choicePoint.links[subTask] = {&choicePoint.subtasks[subTask], rest};
+            rest = &choicePoint.links[subTask];
+        }
+        node.agenda = rest;
+        node.topLevelTasksStarted = choicePoint.topLevelTasksStarted;
+        node.planSize = choicePoint.planSize;
+        node.cost = choicePoint.cost;
+        // the subtasks live exactly as long as this node
+        node.bytes = choicePoint.subtasks.capacity() * sizeof(Task) + choicePoint.links.capacity() * sizeof(AgendaLink);
+        for (const auto& subTask : choicePoint.subtasks)
+        {
+            node.bytes += TaskSize(subTask) - sizeof(Task);
+        }
+
+        return true;
+    }
+
+    bool PlanIterator::SearchOperators(ChoicePoint& choicePoint, ChoicePoint& node)
+    {
+        auto& state = m_context->m_state;
+        auto& trail = m_context->m_trail;
+        const auto& task = *choicePoint.agenda->task;
+        const auto alternative = NextAlternative(choicePoint);
+        const auto& chosenOperator = (*choicePoint.operators)[alternative];
+        double cost = 0.0;
+        node.bytes = TaskSize(task) + sizeof(PlannerContext::PlanStep);
+
+        if (choicePoint.inPlaceOperators and alternative < choicePoint.inPlaceOperators->size() and
+            (*choicePoint.inPlaceOperators)[alternative])
+        {
+            cost = m_planningProblem.OperatorCost(state, task);
+            bool applied;
+            {
+                ScopedTimer callbackTimer(choicePoint.callbackDuration);
+                applied = (*choicePoint.inPlaceOperators)[alternative](state, task.parameters, trail);
+            }
+            if (not applied)
+            {
+                trail.UndoTo(state, choicePoint.trailSize);
+                return false;
+            }
+            node.bytes += (trail.Size() - choicePoint.trailSize) * sizeof(Trail::UndoFunction);
+        }
+        else
+        {
+            std::optional<State> successor;
+            {
+                ScopedTimer callbackTimer(choicePoint.callbackDuration);
+                successor = chosenOperator(state, task.parameters);
+            }
+            if (not successor)
+            {
+                return false;
+            }
+            cost = m_planningProblem.OperatorCost(state, task);
+            node.bytes += m_planningProblem.StateSize(state);
+            trail.SaveState(std::move(state));
+            state = std::move(successor.value());
+        }
+
+        node.agenda = choicePoint.agenda->next;
+        node.topLevelTasksStarted = choicePoint.topLevelTasksStarted;
+        node.cost = choicePoint.cost + cost;
+        m_context->PushPlanStep(task, chosenOperator);
+        node.planSize = m_context->m_planSize;
+
+        return true;
+    }
+
+    bool PlanIterator::SpliceSubplan(ChoicePoint& choicePoint, ChoicePoint& node)
+    {
+        auto& state = m_context->m_state;
+        auto& trail = m_context->m_trail;
+        const auto& subplan = *choicePoint.subplan;
+        // the methods come next either way, so a sub-plan that no longer applies costs no completeness
+        choicePoint.subplan = nullptr;
+        double cost = choicePoint.cost;
+        node.bytes = 0;
+
+        for (const auto& step : subplan)
+        {
+            auto successor = step.func(state, step.task.parameters);
+            if (not successor)
+            {
+                BOOST_LOG_TRIVIAL(trace) << "SpliceSubplan: Cached sub-plan of " << choicePoint.agenda->task->taskName
+                                         << " does not apply.";
+                return false;
+            }
+            cost += m_planningProblem.OperatorCost(state, step.task);
+            node.bytes += m_planningProblem.StateSize(state) + TaskSize(step.task) + sizeof(PlannerContext::PlanStep);
+            trail.SaveState(std::move(state));
+            state = std::move(successor.value());
+            m_context->PushPlanStep(step.task, step.func);
+        }
+
+        node.agenda = choicePoint.agenda->next;
+        node.topLevelTasksStarted = choicePoint.topLevelTasksStarted;
+        node.cost = cost;
+        node.planSize = m_context->m_planSize;
+        return true;
+    }
+
+    void PlanIterator::StoreSubplans(ChoicePoint& node)
+    {
+        const auto& context = *m_context;
+        // a task has been achieved once the agenda is back at the tasks that followed it; the tasks
+        // open at a node nest, so only the innermost can be achieved before the others
+        while (node.openProjection > 0)
+        {
+            const auto& choicePoint = context.m_choicePoints[node.openProjection - 1];
+            // tasks of earlier top-level tasks were achieved before
+            if (choicePoint.topLevelTasksStarted == node.topLevelTasksStarted)
+            {
+                if (choicePoint.agenda->next != node.agenda)
+                {
+                    break;
+                }
+
+                const auto& taskName = choicePoint.agenda->task->taskName;
+                if (not m_subplanCache->Contains(taskName, choicePoint.projection.value()))
+                {
+                    Plan subplan;
+                    subplan.reserve(node.planSize - choicePoint.planSize);
+                    for (auto step = choicePoint.planSize; step < node.planSize; ++step)
+                    {
+                        subplan.emplace_back(context.m_planSteps[step].task, *context.m_planSteps[step].func);
+                    }
+                    m_subplanCache->Store(taskName, choicePoint.projection.value(), std::move(subplan));
+                }
+            }
+            node.openProjection = choicePoint.openProjection;
+        }
+    }
+
+    namespace detail
+    {
+        void OrderAlternatives(MethodOrder methodOrder, std::mt19937_64& random, std::vector<std::size_t>& alternatives)
+        {
+            switch (methodOrder)
+            {
+            case MethodOrder::AsAdded:
+                break;
+            case MethodOrder::Reversed:
+                std::reverse(alternatives.begin(), alternatives.end());
+                break;
+            case MethodOrder::Shuffled:
+                std::shuffle(alternatives.begin(), alternatives.end(), random);
+                break;
+            }
+        }
     }
 }
@@ -0,0 +1,86 @@
+#include "trail.h"
+
+namespace tfd_cpp
+{
+    Trail::Trail() :
+        m_size(0),
+        m_savedStateCount(0)
+    {
+    }
+
+    Trail::~Trail() {}
+
+    void Trail::Record(UndoFunction undo)
+    {
+        if (not undo)
+        {
+            return;
+        }
+
+        if (m_size < m_entries.size())
+        {
+            m_entries[m_size] = std::move(undo);
+        }
+        else
+        {
+            m_entries.push_back(std::move(undo));
+        }
+        ++m_size;
+    }
+
+    void Trail::SaveState(State&& state)
+    {
+        if (m_savedStateCount < m_savedStates.size())
+        {
+            m_savedStates[m_savedStateCount] = std::move(state);
+        }
+        else
+        {
+            m_savedStates.push_back(std::move(state));
+        }
+        ++m_savedStateCount;
+
+        if (m_size < m_entries.size())
+        {
+            m_entries[m_size] = nullptr;
+        }
+        else
+        {
+            m_entries.emplace_back();
+        }
+        ++m_size;
+    }
+
+    std::size_t Trail::Size() const
+    {
+        return m_size;
+    }
+
+    void Trail::UndoTo(State& state, std::size_t mark)
+    {
+        while (m_size > mark)
+        {
+            auto& entry = m_entries[--m_size];
+            if (entry)
+            {
+                entry(state);
+                // drop whatever the undo function captured
+                entry = nullptr;
+            }
+            else
+            {
+                state = std::move(m_savedStates[--m_savedStateCount]);
+            }
+        }
+    }
+
+    void Trail::Clear()
+    {
+        for (std::size_t entry = 0; entry < m_size; ++entry)
+        {
+            m_entries[entry] = nullptr;
+        }
+        m_size = 0;
+        m_savedStateCount = 0;
+    }
+}
@@ -0,0 +1,147 @@
+#include "zobrist.h"
+
+#include <cstring>
+#include <string>
+
+namespace tfd_cpp
+{
+    ZobristHash ZobristKey(std::uint64_t feature)
+    {
+        // splitmix64 finalizer
+        std::uint64_t z = feature + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    ZobristHash ZobristKey(std::string_view feature)
+    {
+        // FNV-1a, which unlike std::hash is the same on every platform
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const auto c : feature)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ULL;
+        }
+        return ZobristKey(hash);
+    }
+
+    ZobristHash ZobristCombine(ZobristHash lhs, ZobristHash rhs)
+    {
+        return ZobristKey(lhs ^ (rhs + 0x9e3779b97f4a7c15ULL + (lhs << 6) + (lhs >> 2)));
+    }
+
+    ZobristHash HashParameter(const std::any& parameter)
+    {
+        if (not parameter.has_value())
+        {
+            return 0;
+        }
+
+        const auto& type = parameter.type();
+        if (type == typeid(std::string))
+        {
+            return ZobristKey(std::any_cast<const std::string&>(parameter));
+        }
+        if (type == typeid(const char*))
+        {
+            return ZobristKey(std::string_view(std::any_cast<const char*>(parameter)));
+        }
+        if (type == typeid(bool))
+        {
+            return ZobristKey(static_cast<std::uint64_t>(std::any_cast<bool>(parameter)));
+        }
+        if (type == typeid(int))
+        {
+            return ZobristKey(static_cast<std::uint64_t>(std::any_cast<int>(parameter)));
+        }
+        if (type == typeid(unsigned int))
+        {
+            return ZobristKey(static_cast<std::uint64_t>(std::any_cast<unsigned int>(parameter)));
+        }
+        if (type == typeid(long))
+        {
+            return ZobristKey(static_cast<std::uint64_t>(std::any_cast<long>(parameter)));
+        }
+        if (type == typeid(unsigned long))
+        {
+            return ZobristKey(static_cast<std::uint64_t>(std::any_cast<unsigned long>(parameter)));
+        }
+        if (type == typeid(long long))
+        {
+            return ZobristKey(static_cast<std::uint64_t>(std::any_cast<long long>(parameter)));
+        }
+        if (type == typeid(unsigned long long))
+        {
+            return ZobristKey(static_cast<std::uint64_t>(std::any_cast<unsigned long long>(parameter)));
+        }
+        if (type == typeid(double))
+        {
+            std::uint64_t bits;
+            const double value = std::any_cast<double>(parameter);
+            std::memcpy(&bits, &value, sizeof(bits));
+            return ZobristKey(bits);
+        }
+        if (type == typeid(float))
+        {
+            std::uint32_t bits;
+            const float value = std::any_cast<float>(parameter);
+            std::memcpy(&bits, &value, sizeof(bits));
+            return ZobristKey(static_cast<std::uint64_t>(bits));
+        }
+
+        return ZobristKey(static_cast<std::uint64_t>(type.hash_code()));
+    }
+
+    ZobristHash HashTask(const Task& task)
+    {
+        ZobristHash hash = ZobristKey(task.taskName);
+        for (const auto& parameter : task.parameters)
+        {
+            hash = ZobristCombine(hash, HashParameter(parameter));
+        }
+        return hash;
+    }
+
+    void AgendaHash::Push(const Task& task)
+    {
+        const auto key = ZobristCombine(ZobristKey(static_cast<std::uint64_t>(m_keys.size())), HashTask(task));
+        m_keys.push_back(key);
+        m_value ^= key;
+    }
+
+    void AgendaHash::Pop()
+    {
+        if (not m_keys.empty())
+        {
+            m_value ^= m_keys.back();
+            m_keys.pop_back();
+        }
+    }
+
+    void AgendaHash::Clear()
+    {
+        m_keys.clear();
+        m_value = 0;
+    }
+
+    ZobristHash AgendaHash::Value() const
+    {
+        return m_value;
+    }
+
+    std::size_t AgendaHash::Size() const
+    {
+        return m_keys.size();
+    }
+
+    ZobristHash HashAgenda(const std::vector<Task>& tasks)
+    {
+        AgendaHash agendaHash;
+        for (const auto& task : tasks)
+        {
+            agendaHash.Push(task);
+        }
+        return agendaHash.Value();
+    }
+}